@@ -702,7 +702,7 @@ OutputIterator merge(InputIterator1 first1, InputIterator1 last1,
         ++result;
     }
     // 最后剩余元素以 copy 复制到目的端. 以下两个序列一定至少有一个为空
-    return copy(first2, last2, copy(first1, last1, result));
+    return cstl::copy(first2, last2, cstl::copy(first1, last1, result));
 }
 
 // min_element() 返回一个迭代器, 指向序列之中数值最小的元素
@@ -1620,14 +1620,14 @@ template <class RandomAccessIterator, class T, class Compare>
 void __partial_sort(RandomAccessIterator first, RandomAccessIterator middle,
                     RandomAccessIterator last, T*, Compare comp)
 {
-    make_heap(first, middle);
+    ::make_heap(first, middle, comp);
     // 以下的 i < last 判断操作, 只适用于 random iterator
     for (RandomAccessIterator i = middle; i < last; ++i) {
         if (comp(*i, *first)) {
-            __pop_heap(first, middle, i, T(*i), distance_type(first));
+            ::__pop_heap(first, middle, i, T(*i), comp, distance_type(first));
         }
     }
-    sort_heap(first, middle);
+    ::sort_heap(first, middle, comp);
 }
 
 // 版本一
@@ -1755,7 +1755,7 @@ template <class RandomAccessIterator, class T>
 inline void __linear_insert(RandomAccessIterator first, RandomAccessIterator last, T*)
 {
     T value = *last;
-    if (comp(value, *first)) {                           // 尾元素比头元素小
+    if (value < *first) {                           // 尾元素比头元素小
         copy_backward(first, last, last + 1);       // 将整个区间向右递移一个位置
         *first = value;                             // 令头元素等于原先的尾元素值
     } else {
@@ -1768,8 +1768,8 @@ inline void __linear_insert(RandomAccessIterator first, RandomAccessIterator las
                             T*, Compare comp)
 {
     T value = *last;
-    if (value < *first) {                           // 尾元素比头元素小
-        copy_backward(first, last, last + 1);       // 将整个区间向右递移一个位置
+    if (comp(value, *first)) {                      // 尾元素比头元素小
+        cstl::copy_backward(first, last, last + 1); // 将整个区间向右递移一个位置
         *first = value;                             // 令头元素等于原先的尾元素值
     } else {
         __unguarded_linear_insert(last, value, comp);
@@ -1821,6 +1821,26 @@ inline const T& __median(const T& a, const T& b, const T& c)
     }
 }
 
+template <class T, class Compare>
+inline const T& __median(const T& a, const T& b, const T& c, Compare comp)
+{
+    if (comp(a, b)) {
+        if (comp(b, c)) {
+            return b;
+        } else if (comp(a, c)) {
+            return c;
+        } else {
+            return a;
+        }
+    } else if (comp(a, c)) {
+        return a;
+    } else if (comp(b, c)) {
+        return c;
+    } else {
+        return b;
+    }
+}
+
 // 分割函数, 其返回值是分割后的右段第一个位置
 template <class RandomAccessIterator, class T>
 RandomAccessIterator __unguarded_partition(RandomAccessIterator first,
@@ -1847,12 +1867,14 @@ RandomAccessIterator __unguarded_partition(RandomAccessIterator first,
         --last;
         while (comp(pivot, *last)) --last;
         if (!(first < last)) return first;
-        iter_swap(first, last);
+        cstl::iter_swap(first, last);
         ++first;
     }
 }
 
 // SGI STL sort
+// 注意: 以下有些调用以 cstl:: 限定. 元素型别来自 std (例如 std::string) 时, 未限定的调用
+// 会经由 ADL 同时找到 <algorithm> 中的同名函数而产生歧义
 
 // __lg() 用来控制分割恶化的情况
 // 找出 2 ^ k <= n 的最大值 k
@@ -1881,7 +1903,7 @@ void __introsort_loop(RandomAccessIterator first, RandomAccessIterator last,
         // 以下是 median-of-3 partition, 选择一个够好的枢轴并决定分割点
         // 分割点将落在迭代器 cut 身上
         RandomAccessIterator cut = __unguarded_partition(first, last,
-                        T(__median(*first, *(first + (last - first) / 2, *(last - 1)))));
+                        T(__median(*first, *(first + (last - first) / 2), *(last - 1))));
         // 对右半段递归进行 sort
         __introsort_loop(cut, last, value_type(first), depth_limit);
         last = cut;
@@ -1889,14 +1911,21 @@ void __introsort_loop(RandomAccessIterator first, RandomAccessIterator last,
     }
 }
 
-template <class RandomAccessIterator>
-void __final_insertion_sort(RandomAccessIterator first, RandomAccessIterator last)
+template <class RandomAccessIterator, class T, class Size, class Compare>
+void __introsort_loop(RandomAccessIterator first, RandomAccessIterator last,
+                      T*, Size depth_limit, Compare comp)
 {
-    if (last - first > __stl_threshold) {
-        __insertion_sort(first, first + __stl_threshold);
-        __unguarded_insertion_sort(first + __stl_threshold, last);
-    } else {
-        __insertion_sort(first, last);
+    while (last - first > __stl_threshold) {
+        if (depth_limit == 0) {
+            cstl::partial_sort(first, last, last, comp);
+            return;
+        }
+        --depth_limit;
+        RandomAccessIterator cut = __unguarded_partition(first, last,
+                        T(__median(*first, *(first + (last - first) / 2), *(last - 1), comp)),
+                        comp);
+        __introsort_loop(cut, last, value_type(first), depth_limit, comp);
+        last = cut;
     }
 }
 
@@ -1915,6 +1944,44 @@ inline void __unguarded_insertion_sort_aux(RandomAccessIterator first, RandomAcc
     }
 }
 
+template <class RandomAccessIterator, class T, class Compare>
+inline void __unguarded_insertion_sort_aux(RandomAccessIterator first, RandomAccessIterator last,
+                                           T*, Compare comp)
+{
+    for (RandomAccessIterator i = first; i != last; ++i) {
+        __unguarded_linear_insert(i, T(*i), comp);
+    }
+}
+
+template <class RandomAccessIterator, class Compare>
+inline void __unguarded_insertion_sort(RandomAccessIterator first, RandomAccessIterator last,
+                                       Compare comp)
+{
+    __unguarded_insertion_sort_aux(first, last, value_type(first), comp);
+}
+
+template <class RandomAccessIterator>
+void __final_insertion_sort(RandomAccessIterator first, RandomAccessIterator last)
+{
+    if (last - first > __stl_threshold) {
+        __insertion_sort(first, first + __stl_threshold);
+        __unguarded_insertion_sort(first + __stl_threshold, last);
+    } else {
+        __insertion_sort(first, last);
+    }
+}
+
+template <class RandomAccessIterator, class Compare>
+void __final_insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+{
+    if (last - first > __stl_threshold) {
+        cstl::__insertion_sort(first, first + __stl_threshold, comp);
+        cstl::__unguarded_insertion_sort(first + __stl_threshold, last, comp);
+    } else {
+        cstl::__insertion_sort(first, last, comp);
+    }
+}
+
 // sort() 只适用于 RandomAccessIterator
 template <class RandomAccessIterator>
 inline void sort(RandomAccessIterator first, RandomAccessIterator last)
@@ -1925,6 +1992,16 @@ inline void sort(RandomAccessIterator first, RandomAccessIterator last)
     }
 }
 
+// 版本二, 以 comp 取代 operator<
+template <class RandomAccessIterator, class Compare>
+inline void sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+{
+    if (first != last) {
+        __introsort_loop(first, last, value_type(first), __lg(last - first) * 2, comp);
+        cstl::__final_insertion_sort(first, last, comp);
+    }
+}
+
 // equal_range() 是二分查找法的一个版本, 试图在已排序的 [first, last) 中寻找 value
 // 返回一对迭代器 i 和 j, 其中 i 是在不破坏次序的前提下, value 可插入的第一个位置,
 // j 是在不破坏次序的前提下, value 可插入的最后一个位置.
@@ -2071,40 +2148,6 @@ equal_range(ForwardIterator first, ForwardIterator last, const T& value, Compare
 // 如果两个连接在一起的序列 [first, middle) 和 [middle, last) 都已排序,
 // 那么 inplace_merge 可将它们结合成单一一个序列, 并仍保有序性
 
-template <class InputIterator1, class InputIterator2, class OutputIterator>
-OutputIterator merge(InputIterator1 first1, InputIterator1 last1,
-                     InputIterator2 first2, InputIterator2 last2,
-                     OutputIterator result) {
-    while (first1 != last1 && first2 != last2) {
-        if (*first2 < *first1) {
-            *result = *first2;
-            ++first2;
-        } else {
-            *result = *first1;
-            ++first1;
-        }
-        ++result;
-    }
-    return copy(first2, last2, copy(first1, last1, result));
-}
-
-template <class InputIterator1, class InputIterator2, class OutputIterator, class Compare>
-OutputIterator merge(InputIterator1 first1, InputIterator1 last1,
-                     InputIterator2 first2, InputIterator2 last2,
-                     OutputIterator result, Compare comp) {
-    while (first1 != last1 && first2 != last2) {
-        if (comp(*first2, *first1)) {
-            *result = *first2;
-            ++first2;
-        } else {
-            *result = *first1;
-            +first1;
-        }
-        ++result;
-    }
-    return copy(first2, last2, copy(first1, last1, result));
-}
-
 template <class BidirectionalIterator, class Distance>
 void __merge_without_buffer(BidirectionalIterator first, BidirectionalIterator middle,
                             BidirectionalIterator last, Distance len1, Distance len2)
@@ -2133,7 +2176,9 @@ void __merge_without_buffer(BidirectionalIterator first, BidirectionalIterator m
         first_cut = upper_bound(first, middle, *second_cut);
         distance(first, first_cut, len11);
     }
-    BidirectionalIterator new_middle = rotate(first_cut, middle, second_cut);
+    rotate(first_cut, middle, second_cut);
+    BidirectionalIterator new_middle = first_cut;
+    advance(new_middle, len22);
     __merge_without_buffer(first, first_cut, new_middle, len11, len22);
     __merge_without_buffer(new_middle, second_cut, last, len1 - len11, len2 - len22);
 }
@@ -2147,7 +2192,7 @@ void __merge_without_buffer(BidirectionalIterator first, BidirectionalIterator m
     }
     if (len1 + len2 == 2) {
         if (comp(*middle, *first)) {
-            iter_swap(first, middle);
+            cstl::iter_swap(first, middle);
         }
         return;
     }
@@ -2157,18 +2202,20 @@ void __merge_without_buffer(BidirectionalIterator first, BidirectionalIterator m
     Distance len22 = 0;
     if (len1 > len2) {
         len11 = len1 / 2;
-        advance(first_cut, len11);
-        second_cut = lower_bound(middle, last, *first_cut, comp);
+        cstl::advance(first_cut, len11);
+        second_cut = cstl::lower_bound(middle, last, *first_cut, comp);
         distance(middle, second_cut, len22);
     } else {
         len22 = len2 / 2;
-        advance(second_cut, len22);
-        first_cut = upper_bound(first, middle, *second_cut, comp);
+        cstl::advance(second_cut, len22);
+        first_cut = cstl::upper_bound(first, middle, *second_cut, comp);
         distance(first, first_cut, len11);
     }
-    BidirectionalIterator new_middle = rotate(first_cut, middle, second_cut);
-    __merge_without_buffer(first, first_cut, new_middle, len11, len22, comp);
-    __merge_without_buffer(new_middle, second_cut, last, len1 - len11, len2 - len22, comp);
+    cstl::rotate(first_cut, middle, second_cut);
+    BidirectionalIterator new_middle = first_cut;
+    cstl::advance(new_middle, len22);
+    cstl::__merge_without_buffer(first, first_cut, new_middle, len11, len22, comp);
+    cstl::__merge_without_buffer(new_middle, second_cut, last, len1 - len11, len2 - len22, comp);
 }
 
 template <class BidirectionalIterator1, class BidirectionalIterator2,
@@ -2207,10 +2254,10 @@ BidirectionalIterator3 __merge_backward(BidirectionalIterator1 first1, Bidirecti
                                         BidirectionalIterator2 first2, BidirectionalIterator2 last2,
                                         BidirectionalIterator3 result, Compare comp) {
     if (first1 == last1) {
-        return copy_backward(first2, last2, result);
+        return cstl::copy_backward(first2, last2, result);
     }
     if (first2 == last2) {
-        return copy_backward(first1, last1, result);
+        return cstl::copy_backward(first1, last1, result);
     }
     --last1;
     --last2;
@@ -2218,13 +2265,13 @@ BidirectionalIterator3 __merge_backward(BidirectionalIterator1 first1, Bidirecti
         if (comp(*last2, *last1)) {
             *--result = *last1;
             if (first1 == last1) {
-                eturn copy_backward(first2, ++last2, result);
+                return cstl::copy_backward(first2, ++last2, result);
             }
             --last1;
         } else {
             *--result = *last2;
             if (first2 == last2) {
-                return copy_backward(first1, ++last1, result);
+                return cstl::copy_backward(first1, ++last1, result);
             }
             --last2;
         }
@@ -2244,18 +2291,18 @@ BidirectionalIterator1 __rotate_adaptive(BidirectionalIterator1 first,
     BidirectionalIterator2 buffer_end;
     if (len1 > len2 && len2 <= buffer_size) {
         // 缓冲区足够安置序列二
-        buffer_end = copy(middle, last, buffer);
-        copy_backward(first, middle, last);
-        return copy(buffer, buffer_end, first);
+        buffer_end = cstl::copy(middle, last, buffer);
+        cstl::copy_backward(first, middle, last);
+        return cstl::copy(buffer, buffer_end, first);
     } else if (len1 <= buffer_size) {
         // 缓冲区足够安置序列一
-        buffer_end = copy(first, middle, buffer);
-        copy(middle, last, first);
-        return copy_backward(buffer, buffer_end, last);
+        buffer_end = cstl::copy(first, middle, buffer);
+        cstl::copy(middle, last, first);
+        return cstl::copy_backward(buffer, buffer_end, last);
     } else {
         // 缓冲区不足, 改用 rotate 算法
-        rotate(first, middle, last);
-        advance(first, len2);
+        cstl::rotate(first, middle, last);
+        cstl::advance(first, len2);
         return first;
     }
 }
@@ -2308,10 +2355,10 @@ void __merge_adaptive(BidirectionalIterator first, BidirectionalIterator middle,
                       Pointer buffer, Distance buffer_size, Compare comp)
 {
     if (len1 <= len2 && len1 <= buffer_size) {
-        Pointer buffer_end = copy(first, middle, buffer);
-        merge(buffer, buffer_end, middle, last, first, comp);
+        Pointer buffer_end = cstl::copy(first, middle, buffer);
+        cstl::merge(buffer, buffer_end, middle, last, first, comp);
     } else if (len2 <= buffer_size) {
-        Pointer buffer_end = copy(middle, last, buffer);
+        Pointer buffer_end = cstl::copy(middle, last, buffer);
         __merge_backward(first, middle, buffer, buffer_end, last, comp);
     } else {
         BidirectionalIterator first_cut = first;
@@ -2320,20 +2367,20 @@ void __merge_adaptive(BidirectionalIterator first, BidirectionalIterator middle,
         Distance len22 = 0;
         if (len1 > len2) {
             len11 = len1 / 2;
-            advance(first_cut, len11);
-            second_cut = lower_bound(middle, last, *first_cut, comp);
+            cstl::advance(first_cut, len11);
+            second_cut = cstl::lower_bound(middle, last, *first_cut, comp);
             distance(middle, second_cut, len22);   
         } else {
             len22 = len2 / 2;
-            advance(second_cut, len22);
-            first_cut = upper_bound(first, middle, *second_cut, comp);
+            cstl::advance(second_cut, len22);
+            first_cut = cstl::upper_bound(first, middle, *second_cut, comp);
             distance(first, first_cut, len11);
         }
         BidirectionalIterator new_middle =
-            __rotate_adaptive(first_cut, middle, second_cut, len1 - len11,
+            cstl::__rotate_adaptive(first_cut, middle, second_cut, len1 - len11,
                               len22, buffer, buffer_size);
-        __merge_adaptive(first, first_cut, new_middle, len11, len22, buffer, buffer_size, comp);
-        __merge_adaptive(new_middle, second_cut, last, len1 - len11,
+        cstl::__merge_adaptive(first, first_cut, new_middle, len11, len22, buffer, buffer_size, comp);
+        cstl::__merge_adaptive(new_middle, second_cut, last, len1 - len11,
                          len2 - len22, buffer, buffer_size, comp);
     }
 }
@@ -2342,10 +2389,8 @@ template <class BidirectionalIterator, class T, class Distance>
 inline void __inplace_merge_aux(BidirectionalIterator first, BidirectionalIterator middle,
                                 BidirectionalIterator last, T*, Distance*)
 {
-    Distance len1 = 0;
-    distance(first middle, len1);
-    Distance len2 = 0;
-    distance(middle, last, len2);
+    Distance len1 = cstl::distance(first, middle);
+    Distance len2 = cstl::distance(middle, last);
 
     temporary_buffer<BidirectionalIterator, T> buf(first, last);
     if (buf.begin() == 0) {     // 内存配置失败
@@ -2359,16 +2404,15 @@ template <class BidirectionalIterator, class T, class Distance, class Compare>
 inline void __inplace_merge_aux(BidirectionalIterator first, BidirectionalIterator middle,
                                 BidirectionalIterator last, T*, Distance*, Compare comp)
 {
-    Distance len1 = 0;
-    distance(first, middle, len1);
-    Distance len2 = 0;
-    distance(middle, last, len2);
+    Distance len1 = cstl::distance(first, middle);
+    Distance len2 = cstl::distance(middle, last);
 
     temporary_buffer<BidirectionalIterator, T> buf(first, last);
     if (buf.begin() == 0) {
-        __merge_without_buffer(first, middle, last, len1, len2, comp);
+        cstl::__merge_without_buffer(first, middle, last, len1, len2, comp);
     } else {
-        __merge_adaptive(first, middle, last, len1, len2, buf.begin(), Distance(buf.size()), comp);
+        cstl::__merge_adaptive(first, middle, last, len1, len2, buf.begin(), Distance(buf.size()),
+                               comp);
     }
 }
 
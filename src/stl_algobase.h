@@ -373,8 +373,8 @@ inline _BI2 copy_backward(_BI1 __first, _BI1 __last, _BI2 __result) {
 template <class _BI1, class _BI2>
 inline _BI2 copy_backward(_BI1 __first, _BI1 __last, _BI2 __result) {
   return __copy_backward(__first, __last, __result,
-                         __ITERATOR_CATEGORY(__first),
-                         __DISTANCE_TYPE(__first));
+                         iterator_category(__first),
+                         distance_type(__first));
 }
 
 #endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
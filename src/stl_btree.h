@@ -0,0 +1,814 @@
+#ifndef __STL_BTREE_H
+#define __STL_BTREE_H
+
+#include <cstddef>
+
+#include "../src/stl_pair.h"
+#include "../src/stl_config.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_construct.h"
+#include "../src/stl_iterator.h"
+#include "../src/type_traits.h"
+
+// B-tree
+// rb_tree 的每个节点只放一个元素, 另有三个指针和一个颜色, 查找时每往下一层就是一次 cache miss.
+// btree 的每个节点连续存放多个元素 (节点约 256 bytes, 即四条 cache line), 树高只有
+// rb_tree 的几分之一. 只有内部节点带 children[], 占绝大多数的叶节点几乎没有额外负担.
+//
+// 注意: 插入和删除会在节点之间搬移元素, 因此会使迭代器失效, 元素的地址也可能改变.
+// 这一点与 rb_tree 不同, 与 vector 相近
+
+enum { __btree_node_target_size = 256 };
+
+template <class Value, size_t N>
+struct __btree_node {
+    typedef __btree_node<Value, N>* node_ptr;
+
+    node_ptr parent;            // 根节点的 parent 为 0
+    unsigned short position;    // 本节点在父节点 children[] 中的下标
+    unsigned short count;       // 本节点存放的元素个数, 只有 values[0, count) 是已构造的对象
+    bool leaf;
+    Value values[N];
+};
+
+// 内部节点: 在叶节点之后多出 count + 1 个子节点指针
+template <class Value, size_t N>
+struct __btree_internal_node : public __btree_node<Value, N> {
+    __btree_node<Value, N>* children[N + 1];
+};
+
+// 迭代器以 (节点, 下标) 表示一个元素. end() 为 (最右叶节点, 其 count)
+template <class Value, class Ref, class Ptr, size_t N>
+struct __btree_iterator {
+    typedef __btree_iterator<Value, Value&, Value*, N> iterator;
+    typedef __btree_iterator<Value, const Value&, const Value*, N> const_iterator;
+    typedef __btree_iterator<Value, Ref, Ptr, N> self;
+
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef Ptr pointer;
+    typedef Ref reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef __btree_node<Value, N>* node_ptr;
+    typedef __btree_internal_node<Value, N>* internal_ptr;
+
+    node_ptr node;
+    int position;
+
+    __btree_iterator() { }
+    __btree_iterator(node_ptr x, int i) : node(x), position(i) { }
+    __btree_iterator(const iterator& it) : node(it.node), position(it.position) { }
+
+    bool operator==(const self& x) const { return node == x.node && position == x.position; }
+    bool operator!=(const self& x) const { return !(*this == x); }
+    reference operator*() const { return node->values[position]; }
+    pointer operator->() const { return &(operator*()); }
+
+    void increment()
+    {
+        if (node->leaf) {
+            if (++position < node->count) return;
+            // 走出叶节点: 往上找第一个 "从左边子树上来" 的祖先
+            self save = *this;
+            while (position == node->count && node->parent != 0) {
+                position = node->position;
+                node = node->parent;
+            }
+            if (position == node->count) *this = save;    // 已是最后一个元素, 停在 end()
+        } else {
+            // 内部节点: 右边子树的最左叶节点
+            node = ((internal_ptr)node)->children[position + 1];
+            while (!node->leaf) node = ((internal_ptr)node)->children[0];
+            position = 0;
+        }
+    }
+
+    void decrement()
+    {
+        if (node->leaf) {
+            if (--position >= 0) return;
+            while (position < 0 && node->parent != 0) {
+                position = node->position - 1;
+                node = node->parent;
+            }
+        } else {
+            // 内部节点: 左边子树的最右叶节点
+            node = ((internal_ptr)node)->children[position];
+            while (!node->leaf) node = ((internal_ptr)node)->children[node->count];
+            position = node->count - 1;
+        }
+    }
+
+    self& operator++() { increment(); return *this; }
+    self operator++(int)
+    {
+        self tmp = *this;
+        increment();
+        return tmp;
+    }
+    self& operator--() { decrement(); return *this; }
+    self operator--(int)
+    {
+        self tmp = *this;
+        decrement();
+        return tmp;
+    }
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = alloc>
+class btree {
+public:
+    // 每个节点的元素个数, 由元素大小决定, 与 deque 的 __deque_buf_size() 同理. 至少为 3
+    enum { node_values = (__btree_node_target_size - 2 * sizeof(void*)) / sizeof(Value) > 3
+                         ? (__btree_node_target_size - 2 * sizeof(void*)) / sizeof(Value) : 3 };
+
+protected:
+    typedef __btree_node<Value, node_values> node_type;
+    typedef __btree_internal_node<Value, node_values> internal_node_type;
+    typedef node_type* node_ptr;
+    typedef internal_node_type* internal_ptr;
+    typedef simple_alloc<node_type, Alloc> leaf_allocator;
+    typedef simple_alloc<internal_node_type, Alloc> internal_allocator;
+
+    // 除根节点外, 每个节点至少放 min_values 个元素
+    enum { min_values = (node_values - 1) / 2 };
+
+    // 键值为内建型别 (整数, 浮点数, 指针) 时, 节点内以线性方式查找, 否则以二分查找
+    typedef typename __type_traits<Key>::is_POD_type linear_search;
+
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    typedef __btree_iterator<value_type, reference, pointer, node_values> iterator;
+    typedef __btree_iterator<value_type, const_reference, const_pointer, node_values>
+        const_iterator;
+
+#ifdef __STL_CLASS_PARTIAL_SPECIALIZATION
+    typedef reverse_iterator<const_iterator> const_reverse_iterator;
+    typedef reverse_iterator<iterator> reverse_iterator;
+#else /* __STL_CLASS_PARTIAL_SPECIALIZATION */
+    typedef reverse_bidirectional_iterator<iterator, value_type, reference,
+                                         difference_type>
+          reverse_iterator;
+    typedef reverse_bidirectional_iterator<const_iterator, value_type,
+                                         const_reference, difference_type>
+          const_reverse_iterator;
+#endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
+
+protected:
+    node_ptr root;          // 空树时为 0
+    node_ptr leftmost;      // 最左叶节点, begin() 所在
+    node_ptr rightmost;     // 最右叶节点, end() 所在
+    size_type node_count;   // 元素个数 (沿用 rb_tree 的命名)
+    Compare key_compare;
+
+    static const Key& key(node_ptr x, int i) { return KeyOfValue()(x->values[i]); }
+    static const Key& key(const_iterator it) { return KeyOfValue()(*it); }
+    static node_ptr& child(node_ptr x, int i) { return ((internal_ptr)x)->children[i]; }
+
+    static void set_child(node_ptr p, int i, node_ptr x)
+    {
+        child(p, i) = x;
+        x->parent = p;
+        x->position = i;
+    }
+
+    // 把 src->values[i] 搬到 dst->values[j] (后者尚未构造)
+    static void move_value(node_ptr dst, int j, node_ptr src, int i)
+    {
+        construct(&dst->values[j], src->values[i]);
+        destroy(&src->values[i]);
+    }
+
+    node_ptr new_node(bool leaf)
+    {
+        node_ptr x = leaf ? leaf_allocator::allocate()
+                          : (node_ptr)internal_allocator::allocate();
+        x->parent = 0;
+        x->position = 0;
+        x->count = 0;
+        x->leaf = leaf;
+        return x;
+    }
+    void delete_node(node_ptr x)
+    {
+        if (x->leaf) {
+            leaf_allocator::deallocate(x);
+        } else {
+            internal_allocator::deallocate((internal_ptr)x);
+        }
+    }
+
+    // 节点内查找: 返回第一个不小于 k (upper 为 true 时: 大于 k) 的元素的下标
+    // 线性版本只是数出 "小于 k 的键值个数", 循环内没有分支也不提前跳出,
+    // 键值连续存放, 编译器可以把它向量化. 元素有序, 所以个数即下标
+    int __search_in_node(node_ptr x, const Key& k, bool upper, __true_type) const
+    {
+        int n = 0;
+        if (upper) {
+            for (int i = 0; i < x->count; ++i) n += !key_compare(k, key(x, i));
+        } else {
+            for (int i = 0; i < x->count; ++i) n += key_compare(key(x, i), k);
+        }
+        return n;
+    }
+    int __search_in_node(node_ptr x, const Key& k, bool upper, __false_type) const
+    {
+        int first = 0;
+        int len = x->count;
+        while (len > 0) {
+            int half = len >> 1;
+            int middle = first + half;
+            if (upper ? !key_compare(k, key(x, middle)) : key_compare(key(x, middle), k)) {
+                first = middle + 1;
+                len = len - half - 1;
+            } else {
+                len = half;
+            }
+        }
+        return first;
+    }
+    int lower_bound_in_node(node_ptr x, const Key& k) const
+    {
+        return __search_in_node(x, k, false, linear_search());
+    }
+    int upper_bound_in_node(node_ptr x, const Key& k) const
+    {
+        return __search_in_node(x, k, true, linear_search());
+    }
+
+private:
+    iterator __insert(node_ptr x, int i, const value_type& v);
+    iterator __insert_before(iterator position, const value_type& v);
+    void __split(node_ptr x);
+    iterator __erase(iterator position);
+    void __rebalance_for_erase(node_ptr x, iterator& it);
+    void __merge(node_ptr left, node_ptr right);
+    node_ptr __copy(node_ptr x, node_ptr p);
+    void __clear(node_ptr x);
+
+    void init()
+    {
+        root = 0;
+        leftmost = 0;
+        rightmost = 0;
+        node_count = 0;
+    }
+
+public:
+    btree(const Compare& comp = Compare()) : key_compare(comp) { init(); }
+    btree(const btree& x) : key_compare(x.key_compare)
+    {
+        init();
+        if (x.root != 0) {
+            root = __copy(x.root, 0);
+            for (leftmost = root; !leftmost->leaf; leftmost = child(leftmost, 0)) { }
+            for (rightmost = root; !rightmost->leaf; rightmost = child(rightmost, rightmost->count)) { }
+            node_count = x.node_count;
+        }
+    }
+    ~btree() { clear(); }
+    btree& operator=(const btree& x)
+    {
+        if (this != &x) {
+            btree tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+public:
+    Compare key_comp() const { return key_compare; }
+    iterator begin() { return iterator(leftmost, 0); }
+    const_iterator begin() const { return const_iterator(leftmost, 0); }
+    iterator end() { return iterator(rightmost, rightmost != 0 ? rightmost->count : 0); }
+    const_iterator end() const
+    {
+        return const_iterator(rightmost, rightmost != 0 ? rightmost->count : 0);
+    }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+    size_type max_size() const { return size_type(-1); }
+
+    void swap(btree& t)
+    {
+        std::swap(root, t.root);
+        std::swap(leftmost, t.leftmost);
+        std::swap(rightmost, t.rightmost);
+        std::swap(node_count, t.node_count);
+        std::swap(key_compare, t.key_compare);
+    }
+
+public:
+    pair<iterator, bool> insert_unique(const value_type& v);
+    iterator insert_equal(const value_type& v);
+
+    // position 为提示: 若 v 恰好应该放在 position 之前, 不必从根查找
+    iterator insert_unique(iterator position, const value_type& v);
+    iterator insert_equal(iterator position, const value_type& v);
+
+    template <class InputIterator>
+    void insert_unique(InputIterator first, InputIterator last)
+    {
+        // 输入有序时, 每次都以 end() 为提示, 直接附加于最右叶节点
+        for ( ; first != last; ++first) insert_unique(end(), *first);
+    }
+    template <class InputIterator>
+    void insert_equal(InputIterator first, InputIterator last)
+    {
+        for ( ; first != last; ++first) insert_equal(end(), *first);
+    }
+
+    void erase(iterator position) { __erase(position); }
+    size_type erase(const key_type& k);
+    void erase(iterator first, iterator last);
+    void clear()
+    {
+        if (root != 0) {
+            __clear(root);
+            init();
+        }
+    }
+
+public:
+    iterator find(const key_type& k);
+    const_iterator find(const key_type& k) const
+    {
+        return const_cast<btree*>(this)->find(k);
+    }
+    size_type count(const key_type& k) const;
+    iterator lower_bound(const key_type& k);
+    const_iterator lower_bound(const key_type& k) const
+    {
+        return const_cast<btree*>(this)->lower_bound(k);
+    }
+    iterator upper_bound(const key_type& k);
+    const_iterator upper_bound(const key_type& k) const
+    {
+        return const_cast<btree*>(this)->upper_bound(k);
+    }
+    pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        return pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+    }
+
+    // 树高. 所有叶节点位于同一层
+    int height() const
+    {
+        int h = 0;
+        for (node_ptr x = root; x != 0; x = x->leaf ? 0 : child(x, 0)) ++h;
+        return h;
+    }
+};
+
+// 在叶节点 x 的 values[i] 之前插入 v. 节点已满时先分裂
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc>::__insert(node_ptr x, int i, const value_type& v)
+{
+    if (x->count == node_values) {
+        __split(x);
+        // 分裂后 x 留下前 node_values/2 个元素, 中间元素上移, 其余在右兄弟
+        const int mid = node_values / 2;
+        if (i > mid) {
+            i -= mid + 1;
+            x = child(x->parent, x->position + 1);
+        }
+    }
+    for (int j = x->count; j > i; --j) {
+        move_value(x, j, x, j - 1);
+    }
+    construct(&x->values[i], v);
+    ++x->count;
+    ++node_count;
+    return iterator(x, i);
+}
+
+// 将满节点 x 一分为二, 中间元素上移至父节点. 父节点也满时先分裂父节点 (由下而上递归)
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::__split(node_ptr x)
+{
+    if (x == root) {                        // 树长高一层
+        root = new_node(false);
+        set_child(root, 0, x);
+    } else if (x->parent->count == node_values) {
+        __split(x->parent);                 // x 的父节点可能因此改变
+    }
+    node_ptr p = x->parent;
+    const int pos = x->position;
+    const int mid = node_values / 2;
+    node_ptr sibling = new_node(x->leaf);
+
+    for (int j = mid + 1; j < x->count; ++j) {
+        move_value(sibling, j - mid - 1, x, j);
+    }
+    if (!x->leaf) {
+        for (int j = mid + 1; j <= x->count; ++j) {
+            set_child(sibling, j - mid - 1, child(x, j));
+        }
+    }
+    sibling->count = x->count - mid - 1;
+
+    // 父节点中, pos 之后的元素和子节点右移一格
+    for (int j = p->count; j > pos; --j) {
+        move_value(p, j, p, j - 1);
+        set_child(p, j + 1, child(p, j));
+    }
+    move_value(p, pos, x, mid);
+    set_child(p, pos + 1, sibling);
+    ++p->count;
+    x->count = mid;
+
+    if (x == rightmost) rightmost = sibling;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+pair<typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator, bool>
+btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const value_type& v)
+{
+    if (root == 0) {
+        root = leftmost = rightmost = new_node(true);
+    }
+    const Key& k = KeyOfValue()(v);
+    node_ptr x = root;
+    for (;;) {
+        int i = lower_bound_in_node(x, k);
+        if (i < x->count && !key_compare(k, key(x, i))) {
+            return pair<iterator, bool>(iterator(x, i), false);     // 键值重复
+        }
+        if (x->leaf) {
+            return pair<iterator, bool>(__insert(x, i, v), true);
+        }
+        x = child(x, i);
+    }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(const value_type& v)
+{
+    if (root == 0) {
+        root = leftmost = rightmost = new_node(true);
+    }
+    const Key& k = KeyOfValue()(v);
+    node_ptr x = root;
+    for (;;) {
+        int i = upper_bound_in_node(x, k);  // 放在相同键值的最后
+        if (x->leaf) {
+            return __insert(x, i, v);
+        }
+        x = child(x, i);
+    }
+}
+
+// 新元素只插入叶节点: position 位于内部节点时, 改为插在其前驱 (必为某叶节点的最后一个元素) 之后
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc>::__insert_before(iterator position,
+                                                               const value_type& v)
+{
+    if (!position.node->leaf) {
+        --position;
+        ++position.position;
+    }
+    return __insert(position.node, position.position, v);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(iterator position,
+                                                             const value_type& v)
+{
+    if (node_count == 0) {
+        return insert_unique(v).first;
+    }
+    const Key& k = KeyOfValue()(v);
+    if (position == end() || key_compare(k, key(position))) {
+        if (position == begin()) {
+            return __insert_before(position, v);
+        }
+        iterator before = position;
+        --before;
+        if (key_compare(key(before), k)) {
+            return __insert_before(position, v);
+        }
+    } else if (!key_compare(key(position), k)) {
+        return position;                    // 键值重复
+    }
+    return insert_unique(v).first;          // 提示无效
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(iterator position,
+                                                            const value_type& v)
+{
+    if (node_count == 0) {
+        return insert_equal(v);
+    }
+    const Key& k = KeyOfValue()(v);
+    if (position == end() || !key_compare(key(position), k)) {
+        if (position == begin()) {
+            return __insert_before(position, v);
+        }
+        iterator before = position;
+        --before;
+        if (!key_compare(k, key(before))) {
+            return __insert_before(position, v);
+        }
+    }
+    return insert_equal(v);                 // 提示无效
+}
+
+// 删除 position 所指元素, 返回其后继.
+// 位于内部节点的元素先以其前驱 (某叶节点的最后一个元素) 取代, 改为删除该叶节点中的前驱
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc>::__erase(iterator position)
+{
+    node_ptr x = position.node;
+    int i = position.position;
+    const bool internal = !x->leaf;
+    if (internal) {
+        iterator pred = position;
+        --pred;
+        // 先复制出前驱再析构原元素: 复制抛出异常时树仍保持原样
+        value_type tmp(*pred);
+        destroy(&x->values[i]);
+        construct(&x->values[i], tmp);
+        x = pred.node;
+        i = pred.position;
+    }
+    destroy(&x->values[i]);
+    for (int j = i + 1; j < x->count; ++j) {
+        move_value(x, j - 1, x, j);
+    }
+    --x->count;
+    --node_count;
+
+    // result 以 "叶节点中的下标" 记录后继的位置, 下标可能等于 count (表示该叶节点之后的元素).
+    // 再平衡时若元素在节点之间搬移, 由 __rebalance_for_erase() 一并修正
+    iterator result(x, i);
+    __rebalance_for_erase(x, result);
+    if (node_count == 0) {
+        return end();
+    }
+    while (result.position == result.node->count && result.node->parent != 0) {
+        result.position = result.node->position;
+        result.node = result.node->parent;
+    }
+    if (result.position == result.node->count) {
+        return end();
+    }
+    if (internal) {
+        ++result;       // result 此刻指向取代者 (原前驱), 再前进一步才是原元素的后继
+    }
+    return result;
+}
+
+// 节点 x 因删除而不足 min_values 个元素时: 向兄弟借一个, 或与兄弟合并.
+// 合并使父节点少一个元素, 所以可能一路往上
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::__rebalance_for_erase(node_ptr x,
+                                                                          iterator& it)
+{
+    for (;;) {
+        if (x == root) {
+            if (x->count == 0) {
+                if (x->leaf) {              // 树已空
+                    delete_node(x);
+                    init();
+                } else {                    // 树变矮一层
+                    root = child(x, 0);
+                    root->parent = 0;
+                    root->position = 0;
+                    delete_node(x);
+                }
+            }
+            return;
+        }
+        if (x->count >= min_values) return;
+
+        node_ptr p = x->parent;
+        const int pos = x->position;
+        node_ptr left = pos > 0 ? child(p, pos - 1) : 0;
+        node_ptr right = pos < p->count ? child(p, pos + 1) : 0;
+
+        if (left != 0 && left->count > min_values) {
+            // 向左兄弟借: 父节点的分隔元素下移至 x 的最前, 左兄弟的最后一个元素上移
+            for (int j = x->count; j > 0; --j) {
+                move_value(x, j, x, j - 1);
+            }
+            move_value(x, 0, p, pos - 1);
+            move_value(p, pos - 1, left, left->count - 1);
+            if (!x->leaf) {
+                for (int j = x->count + 1; j > 0; --j) {
+                    set_child(x, j, child(x, j - 1));
+                }
+                set_child(x, 0, child(left, left->count));
+            }
+            ++x->count;
+            --left->count;
+            if (it.node == x) ++it.position;
+            return;
+        }
+        if (right != 0 && right->count > min_values) {
+            // 向右兄弟借: 分隔元素下移至 x 的最后, 右兄弟的第一个元素上移
+            move_value(x, x->count, p, pos);
+            move_value(p, pos, right, 0);
+            if (!x->leaf) {
+                set_child(x, x->count + 1, child(right, 0));
+            }
+            for (int j = 1; j < right->count; ++j) {
+                move_value(right, j - 1, right, j);
+            }
+            if (!right->leaf) {
+                for (int j = 1; j <= right->count; ++j) {
+                    set_child(right, j - 1, child(right, j));
+                }
+            }
+            ++x->count;
+            --right->count;
+            return;
+        }
+        // 两个兄弟都无法出借, 合并. 合并后的元素个数不超过 2 * min_values <= node_values
+        if (left != 0) {
+            if (it.node == x) {
+                it.node = left;
+                it.position += left->count + 1;
+            }
+            __merge(left, x);
+        } else {
+            __merge(x, right);
+        }
+        x = p;
+    }
+}
+
+// 把 right 连同父节点中的分隔元素并入其左兄弟 left, 释放 right
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::__merge(node_ptr left, node_ptr right)
+{
+    node_ptr p = left->parent;
+    const int pos = left->position;
+
+    move_value(left, left->count, p, pos);
+    for (int j = 0; j < right->count; ++j) {
+        move_value(left, left->count + 1 + j, right, j);
+    }
+    if (!left->leaf) {
+        for (int j = 0; j <= right->count; ++j) {
+            set_child(left, left->count + 1 + j, child(right, j));
+        }
+    }
+    left->count += right->count + 1;
+
+    // 父节点去掉 values[pos] 和 children[pos + 1]
+    for (int j = pos + 1; j < p->count; ++j) {
+        move_value(p, j - 1, p, j);
+        set_child(p, j, child(p, j + 1));
+    }
+    --p->count;
+
+    if (right == rightmost) rightmost = left;
+    delete_node(right);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
+btree<Key, Value, KeyOfValue, Compare, Alloc>::erase(const key_type& k)
+{
+    pair<iterator, iterator> p = equal_range(k);
+    size_type n = 0;
+    for (iterator it = p.first; it != p.second; ++it) ++n;
+    iterator it = p.first;
+    for (size_type i = 0; i < n; ++i) it = __erase(it);
+    return n;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::erase(iterator first, iterator last)
+{
+    if (first == begin() && last == end()) {
+        clear();
+        return;
+    }
+    // __erase() 会搬移元素, 使 last 失效, 所以先数出要删除几个元素
+    size_type n = 0;
+    for (iterator it = first; it != last; ++it) ++n;
+    while (n-- != 0) first = __erase(first);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::node_ptr
+btree<Key, Value, KeyOfValue, Compare, Alloc>::__copy(node_ptr x, node_ptr p)
+{
+    node_ptr y = new_node(x->leaf);
+    y->parent = p;
+    y->position = x->position;
+    // 先把 children[] 清零, 复制元素时若抛出异常, __clear(y) 才不会走到未初始化的指针
+    if (!x->leaf) {
+        for (int i = 0; i <= x->count; ++i) {
+            child(y, i) = 0;
+        }
+    }
+    __STL_TRY {
+        for ( ; y->count < x->count; ++y->count) {
+            construct(&y->values[y->count], x->values[y->count]);
+        }
+        if (!x->leaf) {
+            for (int i = 0; i <= x->count; ++i) {
+                child(y, i) = __copy(child(x, i), y);
+            }
+        }
+    }
+    __STL_UNWIND(__clear(y));
+    return y;
+}
+
+// 析构并释放以 x 为根的子树
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::__clear(node_ptr x)
+{
+    if (!x->leaf) {
+        for (int i = 0; i <= x->count; ++i) {
+            if (child(x, i) != 0) __clear(child(x, i));
+        }
+    }
+    for (int i = 0; i < x->count; ++i) {
+        destroy(&x->values[i]);
+    }
+    delete_node(x);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc>::lower_bound(const Key& k)
+{
+    iterator result = end();    // 沿途最后一个不小于 k 的元素, 越深越小
+    node_ptr x = root;
+    while (x != 0) {
+        int i = lower_bound_in_node(x, k);
+        if (i < x->count) result = iterator(x, i);
+        x = x->leaf ? 0 : child(x, i);
+    }
+    return result;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc>::upper_bound(const Key& k)
+{
+    iterator result = end();
+    node_ptr x = root;
+    while (x != 0) {
+        int i = upper_bound_in_node(x, k);
+        if (i < x->count) result = iterator(x, i);
+        x = x->leaf ? 0 : child(x, i);
+    }
+    return result;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc>::find(const Key& k)
+{
+    // 与 lower_bound() 相同, 但遇到相等的键值即可停止
+    node_ptr x = root;
+    while (x != 0) {
+        int i = lower_bound_in_node(x, k);
+        if (i < x->count && !key_compare(k, key(x, i))) {
+            return iterator(x, i);
+        }
+        x = x->leaf ? 0 : child(x, i);
+    }
+    return end();
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
+btree<Key, Value, KeyOfValue, Compare, Alloc>::count(const Key& k) const
+{
+    pair<const_iterator, const_iterator> p = equal_range(k);
+    size_type n = 0;
+    for ( ; p.first != p.second; ++p.first) ++n;
+    return n;
+}
+
+#endif /* __STL_BTREE_H */
@@ -0,0 +1,112 @@
+#ifndef __STL_BTREE_MULTISET_H
+#define __STL_BTREE_MULTISET_H
+
+#include "../src/stl_pair.h"
+#include "../src/stl_function.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_btree.h"
+
+// 与 multiset 的接口相同, 只是以 btree 取代 rb_tree 作为底层结构.
+// 注意: 插入和删除会使所有迭代器失效, 见 stl_btree.h
+template <class Key, class Compare = less<Key>, class Alloc = alloc>
+class btree_multiset {
+public:     // typedefs
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+private:
+    typedef btree<key_type, value_type, identity<value_type>, key_compare, Alloc> rep_type;
+    rep_type t;
+public:
+    typedef typename rep_type::const_pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::const_reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::const_iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::const_reverse_iterator reverse_iterator;
+    typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    // allocation/deallocation
+    btree_multiset() : t(Compare()) { }
+    explicit btree_multiset(const Compare& comp) : t(comp) { }
+
+    template <class InputIterator>
+    btree_multiset(InputIterator first, InputIterator last)
+        : t(Compare()) { t.insert_equal(first, last); }
+
+    template <class InputIterator>
+    btree_multiset(InputIterator first, InputIterator last, const Compare& comp)
+        : t(comp) { t.insert_equal(first, last); }
+
+    btree_multiset(const btree_multiset<Key, Compare, Alloc>& x) : t(x.t) { }
+    btree_multiset<Key, Compare, Alloc>& operator=(const btree_multiset<Key, Compare, Alloc>& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+    // accessors;
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    reverse_iterator rbegin() const { return t.rbegin(); }
+    reverse_iterator rend() const { return t.rend(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+    void swap(btree_multiset<Key, Compare, Alloc>& x) { t.swap(x.t); }
+
+    // insert/erase
+    iterator insert(const value_type& x)
+    {
+        return t.insert_equal(x);
+    }
+    iterator insert(iterator position, const value_type& x)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        return t.insert_equal((rep_iterator&)position, x);
+    }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_equal(first, last);
+    }
+    void erase(iterator position)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        t.erase((rep_iterator&)position);
+    }
+    size_type erase(const key_type& x)
+    {
+        return t.erase(x);
+    }
+    void erase(iterator first, iterator last)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        t.erase((rep_iterator&)first, (rep_iterator&)last);
+    }
+    void clear() { t.clear(); }
+
+    // set operations
+    iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) const
+    {
+        return t.lower_bound(x);
+    }
+    iterator upper_bound(const key_type& x) const
+    {
+        return t.upper_bound(x);
+    }
+    pair<iterator, iterator> equal_range(const key_type& x) const
+    {
+        return t.equal_range(x);
+    }
+};
+
+#endif /* __STL_BTREE_MULTISET_H */
@@ -0,0 +1,101 @@
+#ifndef __STL_CONCURRENT_HASH_MAP_H
+#define __STL_CONCURRENT_HASH_MAP_H
+
+#include "../src/stl_concurrent_hashtable.h"
+#include "../src/stl_hash_fun.h"
+#include "../src/stl_function.h"
+#include "../src/stl_config.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_pair.h"
+
+// 可由多个线程同时读写的 hash_map, 见 stl_concurrent_hashtable.h
+// 读者不加锁; 写者按键值的杂凑值分段加锁, 不同段的写操作可以同时进行.
+// 接口以"复制出来"与"回调"为主: 不交出元素的引用或迭代器, 它们可能随时被取代
+template <class Key,
+          class T,
+          class HashFcn = hash<Key>,
+          class EqualKey = equal_to<Key>,
+          class Alloc = malloc_alloc>
+class concurrent_hash_map {
+private:
+    typedef concurrent_hashtable<pair<const Key, T>, Key, HashFcn,
+                                 select1st<pair<const Key, T> >, EqualKey, Alloc> ht;
+    ht rep;
+
+    // 把作用于实值的回调 f(T&) 转换为作用于元素的回调
+    template <class Func>
+    struct __apply_second {
+        Func f;
+        explicit __apply_second(Func fn) : f(fn) { }
+        template <class Pair>
+        void operator()(Pair& x) { f(x.second); }
+    };
+    struct __copy_second {
+        T* result;
+        explicit __copy_second(T* r) : result(r) { }
+        void operator()(const pair<const Key, T>& x) const { *result = x.second; }
+    };
+
+public:
+    typedef typename ht::key_type key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef typename ht::value_type value_type;
+    typedef typename ht::hasher hasher;
+    typedef typename ht::key_equal key_equal;
+    typedef typename ht::size_type size_type;
+
+    hasher hash_funct() const { return rep.hash_funct(); }
+    key_equal key_eq() const { return rep.key_eq(); }
+
+public:
+    // n 为预计的元素个数
+    concurrent_hash_map() : rep(0, hasher(), key_equal()) { }
+    explicit concurrent_hash_map(size_type n) : rep(n, hasher(), key_equal()) { }
+    concurrent_hash_map(size_type n, const hasher& hf) : rep(n, hf, key_equal()) { }
+    concurrent_hash_map(size_type n, const hasher& hf, const key_equal& eql)
+        : rep(n, hf, eql) { }
+
+public:     // 读操作: 不加锁
+    // 查找 key, 找到时把实值复制到 value
+    bool find(const key_type& key, T& value) const
+    {
+        return rep.visit(key, __copy_second(&value));
+    }
+    // 找到 key 时以 f(const value_type&) 取用它, 不必复制
+    template <class Visitor>
+    bool visit(const key_type& key, Visitor f) const { return rep.visit(key, f); }
+    template <class Visitor>
+    void for_each(Visitor f) const { rep.for_each(f); }
+
+    size_type count(const key_type& key) const { return rep.count(key); }
+    size_type size() const { return rep.size(); }
+    bool empty() const { return rep.empty(); }
+
+public:     // 写操作
+    bool insert(const value_type& obj) { return rep.insert_unique(obj); }
+
+    // key 不存在时插入 (key, value), 返回 true; 已存在时以 f(T&) 修改其实值, 返回 false.
+    // 例如计数: insert_or_update(word, 1, increment)
+    template <class Updater>
+    bool insert_or_update(const key_type& key, const T& value, Updater f)
+    {
+        return rep.insert_or_update(value_type(key, value), __apply_second<Updater>(f));
+    }
+    // key 存在时以 f(T&) 修改其实值
+    template <class Updater>
+    bool find_and_modify(const key_type& key, Updater f)
+    {
+        return rep.find_and_modify(key, __apply_second<Updater>(f));
+    }
+
+    size_type erase(const key_type& key) { return rep.erase(key); }
+    void clear() { rep.clear(); }
+    void reclaim() { rep.reclaim(); }
+
+public:
+    size_type bucket_count() const { return rep.bucket_count(); }
+    size_type resize_count() const { return rep.resize_count(); }
+};
+
+#endif /* __STL_CONCURRENT_HASH_MAP_H */
@@ -0,0 +1,473 @@
+#ifndef __STL_CONCURRENT_HASHTABLE_H
+#define __STL_CONCURRENT_HASHTABLE_H
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstddef>
+
+#include "../src/stl_config.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_construct.h"
+#include "../src/stl_vector.h"
+#include "../src/stl_hash_fun.h"
+#include "../src/stl_concurrent_map.h"
+
+// 并发杂凑表, 供 concurrent_hash_map 使用. 模板参数与 hashtable 相同
+// 写者以分段锁(lock striping)串行化: 键值的杂凑值决定它属于哪一段, 不同段的写操作互不阻塞.
+// 读者完全不加锁: 节点一经发布就不再修改, 修改实值时以一个新节点取代旧节点
+// (copy-on-write), 被取代或删除的节点交给基于 epoch 的回收, 做法与 concurrent_map 相同.
+//
+// 扩大表格时写者取得所有段的锁, 把所有元素复制到新的 bucket 数组, 再以一次原子写发布
+// 新表; 读者不受阻塞, 仍在旧表中查找, 直到下一次读操作才看到新表.
+// bucket 个数是段数的倍数, 所以一个键值所属的段不因表格大小而改变.
+//
+// 注意:
+// - 读操作以 visitor 取用元素, visitor 只能在读操作期间使用元素的引用
+// - insert_or_update/find_and_modify 的 updater 作用于元素的副本, 由写者在段锁之内调用,
+//   其中不得再操作同一个表格
+// - 节点由多个写者同时配置和释放, 所以缺省使用 malloc_alloc
+// - 不提供迭代器: 要走访全部元素, 以 for_each() 在一次读操作中完成
+
+enum { __chm_stripes = 64 };            // 写锁的段数, 即最少的 bucket 个数
+enum { __chm_reclaim_batch = 64 };      // 一段累积这么多待回收节点后, 才尝试推进 epoch
+
+template <class Value>
+struct __chm_node {
+    std::atomic<__chm_node*> next;
+    Value val;
+};
+
+template <class Value, class Key, class HashFcn,
+          class ExtractKey, class EqualKey, class Alloc = malloc_alloc>
+class concurrent_hashtable {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef HashFcn hasher;
+    typedef EqualKey key_equal;
+    typedef size_t size_type;
+
+    hasher hash_funct() const { return hash; }
+    key_equal key_eq() const { return equals; }
+
+private:
+    typedef __chm_node<Value> node;
+    typedef node* link_type;
+    typedef std::atomic<link_type> bucket_type;
+
+    struct table_type {
+        size_type n;            // bucket 个数: 2 的幂次, 至少 __chm_stripes
+        bucket_type* buckets;
+        size_t epoch;           // 被取代时的 epoch
+    };
+
+    // 只由持有 lock 的写者使用. retired[i] 中是在 epoch retired_epoch[i] 被取代的节点
+    struct stripe_type {
+        std::mutex lock;
+        std::atomic<size_type> count;
+        vector<link_type, Alloc> retired[3];
+        size_t retired_epoch[3];
+        size_type retired_count;
+        char pad[__cmap_cache_line];
+    };
+
+    typedef simple_alloc<node, Alloc> node_allocator;
+    typedef simple_alloc<bucket_type, Alloc> bucket_allocator;
+    typedef simple_alloc<table_type, Alloc> table_allocator;
+
+    hasher hash;
+    key_equal equals;
+    ExtractKey get_key;
+
+    std::atomic<table_type*> tab;
+    std::atomic<size_t> epoch;
+    stripe_type stripes[__chm_stripes];
+    vector<table_type*, Alloc> retired_tables;  // 只在持有所有段锁时使用
+    std::atomic<size_type> num_resizes;
+
+    mutable __cmap_reader_count readers[__cmap_reader_slots];
+
+    // 在表格 t 中找出键值 k 所在的位置: 返回指向该节点的那个指针; 找不到时返回链尾的空指针
+    bucket_type* locate(table_type* t, size_t h, const key_type& k) const
+    {
+        bucket_type* link = t->buckets + (h & (t->n - 1));
+        for (link_type p; (p = link->load(std::memory_order_relaxed)) != 0; link = &p->next) {
+            if (equals(get_key(p->val), k)) return link;
+        }
+        return link;
+    }
+    stripe_type& stripe_of(size_t h) { return stripes[h & (__chm_stripes - 1)]; }
+
+public:
+    // n 为预计的元素个数
+    concurrent_hashtable(size_type n, const HashFcn& hf, const EqualKey& eql)
+        : hash(hf), equals(eql), get_key(ExtractKey()), tab(0), epoch(0), num_resizes(0)
+    {
+        for (int i = 0; i < __chm_stripes; ++i) {
+            stripes[i].count.store(0);
+            stripes[i].retired_count = 0;
+            for (int j = 0; j < 3; ++j) stripes[i].retired_epoch[j] = 0;
+        }
+        for (int i = 0; i < __cmap_reader_slots; ++i) {
+            for (int j = 0; j < 3; ++j) readers[i].count[j].store(0);
+        }
+        size_type buckets = __chm_stripes;
+        while (buckets < n) buckets *= 2;
+        tab.store(__create_table(buckets));
+    }
+    // 析构时不得有任何读者或写者
+    ~concurrent_hashtable()
+    {
+        table_type* t = tab.load();
+        for (size_type i = 0; i < t->n; ++i) __destroy_chain(t->buckets[i].load());
+        __destroy_table(t);
+        for (int i = 0; i < __chm_stripes; ++i) {
+            for (int j = 0; j < 3; ++j) __free_retired(stripes[i], j);
+        }
+        for (size_type i = 0; i < retired_tables.size(); ++i) __destroy_table(retired_tables[i]);
+    }
+
+public:     // 读操作: 不加锁, 可以与写者及其他读者同时进行
+    // 找到 k 时以 f(const value_type&) 取用它
+    template <class Visitor>
+    bool visit(const key_type& k, Visitor f) const
+    {
+        const size_t h = __stl_hash_mix(hash(k));
+        size_t slot = __cmap_reader_slot();
+        size_t e = __enter(slot);
+        table_type* t = tab.load(std::memory_order_acquire);
+        link_type p = t->buckets[h & (t->n - 1)].load(std::memory_order_acquire);
+        for ( ; p != 0; p = p->next.load(std::memory_order_acquire)) {
+            if (equals(get_key(p->val), k)) break;
+        }
+        if (p != 0) {
+            __STL_TRY {
+                f(p->val);
+            }
+            __STL_UNWIND(__leave(slot, e));
+        }
+        __leave(slot, e);
+        return p != 0;
+    }
+    size_type count(const key_type& k) const { return visit(k, __chm_ignore()) ? 1 : 0; }
+
+    // 对每个元素调用 f(const value_type&). 与写者同时进行时, 同时被插入或删除的元素
+    // 可能看到也可能看不到, 其余元素恰好各看到一次
+    template <class Visitor>
+    void for_each(Visitor f) const
+    {
+        size_t slot = __cmap_reader_slot();
+        size_t e = __enter(slot);
+        table_type* t = tab.load(std::memory_order_acquire);
+        __STL_TRY {
+            for (size_type i = 0; i < t->n; ++i) {
+                link_type p = t->buckets[i].load(std::memory_order_acquire);
+                for ( ; p != 0; p = p->next.load(std::memory_order_acquire)) f(p->val);
+            }
+        }
+        __STL_UNWIND(__leave(slot, e));
+        __leave(slot, e);
+    }
+
+    // 与写者同时进行时只是近似值
+    size_type size() const
+    {
+        size_type n = 0;
+        for (int i = 0; i < __chm_stripes; ++i) {
+            n += stripes[i].count.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+    bool empty() const { return size() == 0; }
+    size_type bucket_count() const { return tab.load()->n; }
+    size_type resize_count() const { return num_resizes.load(); }
+
+public:     // 写操作: 同一段之内串行化
+    // 键值已存在时不插入, 返回 false
+    bool insert_unique(const value_type& obj) { return insert_or_update(obj, __chm_ignore()); }
+
+    // 键值不存在时插入 obj, 返回 true; 已存在时以 f(value_type&) 修改它的一个副本,
+    // 再以副本取代之, 返回 false
+    template <class Updater>
+    bool insert_or_update(const value_type& obj, Updater f);
+
+    // 键值存在时以 f(value_type&) 修改它的一个副本, 再以副本取代之
+    template <class Updater>
+    bool find_and_modify(const key_type& k, Updater f);
+
+    size_type erase(const key_type& k);
+    void clear();
+
+    // 尝试推进 epoch. 写操作会自动调用
+    void reclaim() { __try_advance(); }
+
+private:
+    struct __chm_ignore {
+        void operator()(const value_type&) const { }
+    };
+
+    // 取得所有段的锁. 按段的顺序取得, 写者任何时候最多只持有一个段锁, 所以不会死锁
+    struct __lock_all {
+        concurrent_hashtable* ht;
+        explicit __lock_all(concurrent_hashtable* h) : ht(h)
+        {
+            for (int i = 0; i < __chm_stripes; ++i) ht->stripes[i].lock.lock();
+        }
+        ~__lock_all()
+        {
+            for (int i = __chm_stripes; i > 0; --i) ht->stripes[i - 1].lock.unlock();
+        }
+    };
+
+    size_t __enter(size_t slot) const
+    {
+        for (;;) {
+            size_t e = epoch.load();
+            readers[slot].count[e % 3].fetch_add(1);
+            if (epoch.load() == e) return e;    // 登记时 epoch 未变, 登记有效
+            readers[slot].count[e % 3].fetch_sub(1);
+        }
+    }
+    void __leave(size_t slot, size_t e) const { readers[slot].count[e % 3].fetch_sub(1); }
+    void __try_advance()
+    {
+        size_t e = epoch.load();
+        for (int i = 0; i < __cmap_reader_slots; ++i) {
+            if (readers[i].count[(e + 2) % 3].load() != 0) return;
+        }
+        epoch.compare_exchange_strong(e, e + 1);
+    }
+
+    link_type __create_node(const value_type& obj)
+    {
+        link_type tmp = node_allocator::allocate();
+        __STL_TRY {
+            construct(&tmp->val, obj);
+        }
+        __STL_UNWIND(node_allocator::deallocate(tmp));
+        new (&tmp->next) std::atomic<link_type>(static_cast<link_type>(0));
+        return tmp;
+    }
+    void __destroy_node(link_type p)
+    {
+        destroy(&p->val);
+        node_allocator::deallocate(p);
+    }
+    void __destroy_chain(link_type p)
+    {
+        while (p != 0) {
+            link_type next = p->next.load(std::memory_order_relaxed);
+            __destroy_node(p);
+            p = next;
+        }
+    }
+    table_type* __create_table(size_type n);
+    void __destroy_table(table_type* t)
+    {
+        bucket_allocator::deallocate(t->buckets, t->n);
+        table_allocator::deallocate(t);
+    }
+
+    void __free_retired(stripe_type& s, int i)
+    {
+        for (size_type n = 0; n < s.retired[i].size(); ++n) __destroy_node(s.retired[i][n]);
+        s.retired_count -= s.retired[i].size();
+        s.retired[i].clear();
+    }
+    void __retire(stripe_type& s, link_type p);
+    void __replace(stripe_type& s, bucket_type* link, link_type n)
+    {
+        link_type old = link->load(std::memory_order_relaxed);
+        n->next.store(old->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        link->store(n, std::memory_order_release);
+        __retire(s, old);
+    }
+    void __grow(table_type* expected);
+
+    concurrent_hashtable(const concurrent_hashtable&);
+    concurrent_hashtable& operator=(const concurrent_hashtable&);
+};
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename concurrent_hashtable<V, K, HF, Ex, Eq, A>::table_type*
+concurrent_hashtable<V, K, HF, Ex, Eq, A>::__create_table(size_type n)
+{
+    table_type* t = table_allocator::allocate();
+    __STL_TRY {
+        t->buckets = bucket_allocator::allocate(n);
+    }
+    __STL_UNWIND(table_allocator::deallocate(t));
+    for (size_type i = 0; i < n; ++i) new (t->buckets + i) bucket_type(static_cast<link_type>(0));
+    t->n = n;
+    t->epoch = 0;
+    return t;
+}
+
+// 节点 p 已从表格中摘下. 在 epoch e 中被取代的节点, 要等 epoch 推进到 e + 2 才释放.
+// retired[e % 3] 若仍留有更早(至少 e - 3)的节点, 它们早已可以释放
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void concurrent_hashtable<V, K, HF, Ex, Eq, A>::__retire(stripe_type& s, link_type p)
+{
+    size_t e = epoch.load();
+    int i = int(e % 3);
+    if (s.retired_epoch[i] != e) {
+        __free_retired(s, i);
+        s.retired_epoch[i] = e;
+    }
+    s.retired[i].push_back(p);
+    ++s.retired_count;
+    if (s.retired_count >= __chm_reclaim_batch) {
+        __try_advance();
+        e = epoch.load();
+        for (int j = 0; j < 3; ++j) {
+            if (s.retired_epoch[j] + 2 <= e) __free_retired(s, j);
+        }
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+template <class Updater>
+bool concurrent_hashtable<V, K, HF, Ex, Eq, A>::insert_or_update(const value_type& obj,
+                                                                Updater f)
+{
+    const size_t h = __stl_hash_mix(hash(get_key(obj)));
+    stripe_type& s = stripe_of(h);
+    table_type* t;
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        t = tab.load(std::memory_order_relaxed);   // 扩大表格需要所有段锁, 此时不会改变
+        bucket_type* link = locate(t, h, get_key(obj));
+        link_type p = link->load(std::memory_order_relaxed);
+        if (p != 0) {
+            link_type n = __create_node(p->val);
+            __STL_TRY {
+                f(n->val);
+            }
+            __STL_UNWIND(__destroy_node(n));
+            __replace(s, link, n);
+            return false;
+        }
+        link_type n = __create_node(obj);
+        bucket_type& head = t->buckets[h & (t->n - 1)];
+        n->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        head.store(n, std::memory_order_release);
+        // 最大负载为 1: 每一段平均分到 n / __chm_stripes 个 buckets
+        if (s.count.fetch_add(1, std::memory_order_relaxed) + 1 <= t->n / __chm_stripes) {
+            return true;
+        }
+    }
+    __grow(t);
+    return true;
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+template <class Updater>
+bool concurrent_hashtable<V, K, HF, Ex, Eq, A>::find_and_modify(const key_type& k, Updater f)
+{
+    const size_t h = __stl_hash_mix(hash(k));
+    stripe_type& s = stripe_of(h);
+    std::lock_guard<std::mutex> guard(s.lock);
+    bucket_type* link = locate(tab.load(std::memory_order_relaxed), h, k);
+    link_type p = link->load(std::memory_order_relaxed);
+    if (p == 0) return false;
+    link_type n = __create_node(p->val);
+    __STL_TRY {
+        f(n->val);
+    }
+    __STL_UNWIND(__destroy_node(n));
+    __replace(s, link, n);
+    return true;
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename concurrent_hashtable<V, K, HF, Ex, Eq, A>::size_type
+concurrent_hashtable<V, K, HF, Ex, Eq, A>::erase(const key_type& k)
+{
+    const size_t h = __stl_hash_mix(hash(k));
+    stripe_type& s = stripe_of(h);
+    std::lock_guard<std::mutex> guard(s.lock);
+    bucket_type* link = locate(tab.load(std::memory_order_relaxed), h, k);
+    link_type p = link->load(std::memory_order_relaxed);
+    if (p == 0) return 0;
+    // 读者可能正停在 p 上, 所以 p->next 保持不变, 它仍然可以走到链尾
+    link->store(p->next.load(std::memory_order_relaxed), std::memory_order_release);
+    s.count.fetch_sub(1, std::memory_order_relaxed);
+    __retire(s, p);
+    return 1;
+}
+
+// 所有节点都交给回收. 读者可能仍在走访它们
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void concurrent_hashtable<V, K, HF, Ex, Eq, A>::clear()
+{
+    __lock_all guard(this);
+    table_type* t = tab.load(std::memory_order_relaxed);
+    for (size_type i = 0; i < t->n; ++i) {
+        stripe_type& s = stripes[i & (__chm_stripes - 1)];
+        link_type p = t->buckets[i].load(std::memory_order_relaxed);
+        t->buckets[i].store(0, std::memory_order_release);
+        while (p != 0) {
+            link_type next = p->next.load(std::memory_order_relaxed);
+            __retire(s, p);
+            p = next;
+        }
+    }
+    for (int i = 0; i < __chm_stripes; ++i) stripes[i].count.store(0);
+}
+
+// 由插入 expected 的写者在放开段锁之后调用. 取得所有段锁之后, 若表格已经被别的写者
+// 扩大, 什么也不做. 复制元素时若发生异常, 新表整个放弃, 原有内容不受影响.
+// 旧表本身要等下一次扩大表格时才可能释放
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void concurrent_hashtable<V, K, HF, Ex, Eq, A>::__grow(table_type* expected)
+{
+    __lock_all guard(this);
+    table_type* old = tab.load(std::memory_order_relaxed);
+    if (old != expected) return;
+
+    const size_type n = old->n * 2;
+    table_type* t = __create_table(n);
+    size_type i = 0;
+    __STL_TRY {
+        for ( ; i < old->n; ++i) {
+            for (link_type p = old->buckets[i].load(std::memory_order_relaxed); p != 0;
+                 p = p->next.load(std::memory_order_relaxed)) {
+                // 先算出 bucket 再复制: 杂凑函数抛出异常时不会留下尚未串进新表的节点
+                bucket_type& head = t->buckets[__stl_hash_mix(hash(get_key(p->val))) & (n - 1)];
+                link_type q = __create_node(p->val);
+                q->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                head.store(q, std::memory_order_relaxed);
+            }
+        }
+    }
+    __STL_UNWIND(for (size_type j = 0; j < n; ++j) __destroy_chain(t->buckets[j].load());
+                 __destroy_table(t));
+    tab.store(t, std::memory_order_release);
+    num_resizes.fetch_add(1, std::memory_order_relaxed);
+
+    for (i = 0; i < old->n; ++i) {
+        stripe_type& s = stripes[i & (__chm_stripes - 1)];
+        for (link_type p = old->buckets[i].load(std::memory_order_relaxed); p != 0; ) {
+            link_type next = p->next.load(std::memory_order_relaxed);
+            __retire(s, p);
+            p = next;
+        }
+    }
+
+    __try_advance();
+    const size_t e = epoch.load();
+    size_type kept = 0;
+    for (size_type j = 0; j < retired_tables.size(); ++j) {
+        if (retired_tables[j]->epoch + 2 <= e) {
+            __destroy_table(retired_tables[j]);
+        } else {
+            retired_tables[kept++] = retired_tables[j];
+        }
+    }
+    retired_tables.erase(retired_tables.begin() + kept, retired_tables.end());
+    old->epoch = e;
+    retired_tables.push_back(old);
+}
+
+#endif /* __STL_CONCURRENT_HASHTABLE_H */
@@ -0,0 +1,630 @@
+#ifndef __STL_CONCURRENT_MAP_H
+#define __STL_CONCURRENT_MAP_H
+
+#include <atomic>
+#include <mutex>
+#include <cstddef>
+
+#include "../src/stl_config.h"
+#include "../src/stl_pair.h"
+#include "../src/stl_function.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_construct.h"
+#include "../src/stl_iterator.h"
+#include "../src/stl_vector.h"
+
+// 读多写少的并发有序 map
+// 树是不可变的(persistent) AVL 树: 写者以路径复制(path copying)产生新版本, 再以一次原子写
+// 发布新的根; 读者只读一次根指针, 之后完全不加锁, 看到的始终是某个完整的版本.
+// 被新版本取代的节点交给基于 epoch 的回收(epoch-based reclamation), 确定没有读者还能
+// 看到它们之后才释放.
+//
+// epoch 回收:
+//   全局 epoch e 只由写者推进. 读者进入时在自己的槽位上把 count[e % 3] 加 1, 并确认 e 未变;
+//   离开时减 1. 写者在 epoch e 中取代的节点, 要等 epoch 推进到 e + 2 才释放;
+//   而 epoch 由 e 推进到 e + 1 的前提是已经没有登记在 e - 1 的读者.
+//   每个读者槽位独占一条 cache line, 线程依次分配到不同的槽位, 读者之间不共享任何写入的位置.
+//
+// 注意:
+// - 写操作(insert/insert_or_assign/erase/clear)之间以互斥锁串行化, 读操作从不加锁
+// - snapshot 存在期间, 它登记的 epoch 不能结束, 节点的回收也就停止. 不要长期持有
+// - 节点只由写者配置和释放, 所以缺省使用 malloc_alloc (第二级配置器不是线程安全的)
+// - 迭代器是单向的, 只在产生它的 snapshot 存在期间有效
+
+enum { __cmap_cache_line = 64 };
+enum { __cmap_reader_slots = 128 };     // 读者槽位数. 超过此数的线程会共享槽位, 但仍然正确
+enum { __cmap_max_height = 64 };        // 高度 64 的 AVL 树至少有约 2.7e13 个节点
+enum { __cmap_reclaim_batch = 256 };    // 累积这么多待回收节点后, 才尝试推进 epoch
+
+// 每个线程第一次调用时分配一个槽位, 之后不变
+inline size_t __cmap_reader_slot()
+{
+    static std::atomic<size_t> next(0);
+    static thread_local size_t slot =
+        next.fetch_add(1, std::memory_order_relaxed) % __cmap_reader_slots;
+    return slot;
+}
+
+struct __cmap_reader_count {
+    std::atomic<long> count[3];     // 分别登记在 epoch % 3 == 0, 1, 2 的读者数
+    char pad[__cmap_cache_line - 3 * sizeof(std::atomic<long>)];
+};
+
+// 节点一经发布就不再修改. version 记录产生它的写操作, 写者据此判断节点能否就地修改
+template <class Value>
+struct __cmap_node {
+    typedef __cmap_node<Value>* link_type;
+    link_type left;
+    link_type right;
+    int height;
+    size_t version;
+    size_t size;        // 子树的节点数. 使 snapshot 的 size() 为 O(1)
+    Value value_field;
+};
+
+// 沿途记下 "往左走过" 的祖先, 它们就是中序遍历中待访问的后继
+template <class Value>
+struct __cmap_iterator {
+    typedef forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const Value& reference;
+    typedef const Value* pointer;
+    typedef __cmap_iterator<Value> self;
+    typedef __cmap_node<Value>* link_type;
+
+    link_type stack[__cmap_max_height];
+    int depth;          // stack[depth - 1] 即当前节点; depth == 0 表示 end()
+
+    __cmap_iterator() : depth(0) { }
+
+    void push_left(link_type x)
+    {
+        for ( ; x != 0; x = x->left) stack[depth++] = x;
+    }
+
+    reference operator*() const { return stack[depth - 1]->value_field; }
+    pointer operator->() const { return &(operator*()); }
+
+    self& operator++()
+    {
+        link_type x = stack[--depth];
+        push_left(x->right);
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    bool operator==(const self& x) const
+    {
+        return depth == 0 ? x.depth == 0
+                          : (x.depth != 0 && stack[depth - 1] == x.stack[x.depth - 1]);
+    }
+    bool operator!=(const self& x) const { return !(*this == x); }
+};
+
+template <class Key, class T, class Compare = less<Key>, class Alloc = malloc_alloc>
+class concurrent_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<const Key, T> value_type;
+    typedef Compare key_compare;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef __cmap_iterator<value_type> const_iterator;
+    typedef const_iterator iterator;
+
+private:
+    typedef __cmap_node<value_type> node;
+    typedef node* link_type;
+    typedef simple_alloc<node, Alloc> node_allocator;
+
+    std::atomic<link_type> root;
+    std::atomic<size_t> epoch;
+    Compare key_compare_;
+
+    // 以下只由写者使用
+    std::mutex writer_lock;
+    size_t cur_version;                     // 目前写操作的编号
+    vector<link_type, Alloc> retired[3];    // 在 epoch % 3 中被取代的节点
+    size_type retired_count;
+    // 目前写操作的记录. 发布之前, 被取代的节点仍可能被读者看到, 不能交给 retired[];
+    // 写操作因异常而放弃时, 据此释放它已产生的节点, 旧版本原封不动
+    vector<link_type, Alloc> fresh;         // 本次产生的节点
+    vector<link_type, Alloc> replaced;      // 本次取代的已发布节点
+    vector<link_type, Alloc> discarded;     // 本次产生而又被取代的节点(也在 fresh 之中)
+
+    mutable __cmap_reader_count readers[__cmap_reader_slots];
+
+    static const Key& key(link_type x) { return x->value_field.first; }
+    static int height(link_type x) { return x == 0 ? 0 : x->height; }
+    static size_type subtree_size(link_type x) { return x == 0 ? 0 : x->size; }
+
+public:
+    // 一个版本的只读视图. 存在期间, 其中的节点不会被释放
+    class snapshot_type {
+        friend class concurrent_map<Key, T, Compare, Alloc>;
+        const concurrent_map* m;
+        link_type r;
+        size_t slot;
+        size_t e;
+
+        snapshot_type(const concurrent_map* map, link_type root_, size_t slot_, size_t e_)
+            : m(map), r(root_), slot(slot_), e(e_) { }
+    public:
+        snapshot_type(const snapshot_type& x) : m(x.m), r(x.r), slot(x.slot), e(x.e)
+        {
+            // x 仍然登记在 epoch e, 所以 epoch 还不能越过 e + 1, 可以直接在 e 上再登记一次
+            m->readers[slot].count[e % 3].fetch_add(1);
+        }
+        ~snapshot_type() { m->readers[slot].count[e % 3].fetch_sub(1); }
+
+        bool empty() const { return r == 0; }
+        size_type size() const { return subtree_size(r); }
+
+        const_iterator begin() const
+        {
+            const_iterator it;
+            it.push_left(r);
+            return it;
+        }
+        const_iterator end() const { return const_iterator(); }
+        const_iterator lower_bound(const key_type& k) const;
+        const_iterator upper_bound(const key_type& k) const;
+        const_iterator find(const key_type& k) const
+        {
+            const_iterator it = lower_bound(k);
+            return (it == end() || m->key_compare_(k, it->first)) ? end() : it;
+        }
+        size_type count(const key_type& k) const { return find(k) == end() ? 0 : 1; }
+
+    private:
+        snapshot_type& operator=(const snapshot_type&);
+    };
+
+public:
+    explicit concurrent_map(const Compare& comp = Compare())
+        : root(0), epoch(0), key_compare_(comp), cur_version(0), retired_count(0)
+    {
+        for (int i = 0; i < __cmap_reader_slots; ++i) {
+            for (int j = 0; j < 3; ++j) readers[i].count[j].store(0);
+        }
+    }
+    // 析构时不得有读者或 snapshot
+    ~concurrent_map()
+    {
+        __destroy_tree(root.load());
+        for (int i = 0; i < 3; ++i) __free_retired(i);
+    }
+
+    key_compare key_comp() const { return key_compare_; }
+
+public:     // 读操作: 不加锁, 可以与写者及其他读者同时进行
+    snapshot_type snapshot() const
+    {
+        size_t slot = __cmap_reader_slot();
+        size_t e = __enter(slot);
+        return snapshot_type(this, root.load(), slot, e);
+    }
+
+    // 查找 k, 找到时把实值复制到 value
+    bool find(const key_type& k, T& value) const
+    {
+        size_t slot = __cmap_reader_slot();
+        size_t e = __enter(slot);
+        link_type x = __find(root.load(), k);
+        if (x != 0) value = x->value_field.second;
+        __leave(slot, e);
+        return x != 0;
+    }
+    size_type count(const key_type& k) const
+    {
+        size_t slot = __cmap_reader_slot();
+        size_t e = __enter(slot);
+        link_type x = __find(root.load(), k);
+        __leave(slot, e);
+        return x != 0 ? 1 : 0;
+    }
+    bool empty() const { return root.load() == 0; }
+    size_type size() const
+    {
+        size_t slot = __cmap_reader_slot();
+        size_t e = __enter(slot);
+        size_type n = subtree_size(root.load());
+        __leave(slot, e);
+        return n;
+    }
+
+public:     // 写操作: 彼此串行化
+    // 键值已存在时不插入, 返回 false
+    bool insert(const value_type& v);
+    // 键值已存在时以 v 取代之
+    void insert_or_assign(const key_type& k, const T& v);
+    size_type erase(const key_type& k);
+    void clear();
+
+    // 尝试推进 epoch 并释放已确定不再被读者看到的节点. 写操作会自动调用
+    void reclaim()
+    {
+        std::lock_guard<std::mutex> guard(writer_lock);
+        __try_advance();
+    }
+
+private:
+    size_t __enter(size_t slot) const
+    {
+        for (;;) {
+            size_t e = epoch.load();
+            readers[slot].count[e % 3].fetch_add(1);
+            if (epoch.load() == e) return e;    // 登记时 epoch 未变, 登记有效
+            readers[slot].count[e % 3].fetch_sub(1);
+        }
+    }
+    void __leave(size_t slot, size_t e) const { readers[slot].count[e % 3].fetch_sub(1); }
+
+    link_type __find(link_type x, const key_type& k) const
+    {
+        while (x != 0) {
+            if (key_compare_(k, key(x))) {
+                x = x->left;
+            } else if (key_compare_(key(x), k)) {
+                x = x->right;
+            } else {
+                return x;
+            }
+        }
+        return 0;
+    }
+
+    link_type __create_node(const value_type& v, link_type l, link_type r)
+    {
+        fresh.push_back(0);     // 先占位, 节点产生之后就不会因记录失败而遗失
+        link_type tmp = node_allocator::allocate();
+        __STL_TRY {
+            construct(&tmp->value_field, v);
+        }
+        __STL_UNWIND(node_allocator::deallocate(tmp); fresh.pop_back());
+        fresh.back() = tmp;
+        tmp->left = l;
+        tmp->right = r;
+        tmp->version = cur_version;
+        __update(tmp);
+        return tmp;
+    }
+    void __destroy_node(link_type x)
+    {
+        destroy(&x->value_field);
+        node_allocator::deallocate(x);
+    }
+    void __destroy_tree(link_type x)
+    {
+        while (x != 0) {
+            __destroy_tree(x->right);
+            link_type y = x->left;
+            __destroy_node(x);
+            x = y;
+        }
+    }
+
+    // 节点 x 已不在新版本中. 只是记下, 发布之后才真正回收, 见 __publish()
+    void __retire(link_type x)
+    {
+        if (x->version == cur_version) {
+            discarded.push_back(x);
+        } else {
+            replaced.push_back(x);
+        }
+    }
+    void __free_retired(size_t i)
+    {
+        for (size_type n = 0; n < retired[i].size(); ++n) __destroy_node(retired[i][n]);
+        retired_count -= retired[i].size();
+        retired[i].clear();
+    }
+    void __try_advance();
+
+    // 取得 x 的可写版本: 本次写操作产生的节点直接返回, 否则复制一份并回收旧节点
+    link_type __own(link_type x)
+    {
+        if (x->version == cur_version) return x;
+        link_type y = __create_node(x->value_field, x->left, x->right);
+        __retire(x);
+        return y;
+    }
+
+    static void __update(link_type x)
+    {
+        int hl = height(x->left), hr = height(x->right);
+        x->height = (hl > hr ? hl : hr) + 1;
+        x->size = subtree_size(x->left) + subtree_size(x->right) + 1;
+    }
+    link_type __rotate_left(link_type x);
+    link_type __rotate_right(link_type x);
+    link_type __balance(link_type x);
+
+    link_type __insert(link_type x, const value_type& v, bool assign, bool& changed);
+    link_type __erase(link_type x, const key_type& k, bool& erased);
+    link_type __erase_min(link_type x, link_type& min);
+
+    void __begin_write()
+    {
+        ++cur_version;
+        fresh.clear();
+        replaced.clear();
+        discarded.clear();
+    }
+    // 发布新的根之后, 本次取代的节点才交给 epoch 回收; 本次产生又被取代的节点
+    // 从未发布, 立即释放
+    void __publish(link_type r)
+    {
+        vector<link_type, Alloc>& bin = retired[epoch.load(std::memory_order_relaxed) % 3];
+        bin.reserve(bin.size() + replaced.size());     // 发布之后不能再失败
+        root.store(r);
+        for (size_type n = 0; n < replaced.size(); ++n) bin.push_back(replaced[n]);
+        retired_count += replaced.size();
+        for (size_type n = 0; n < discarded.size(); ++n) __destroy_node(discarded[n]);
+        fresh.clear();
+        replaced.clear();
+        discarded.clear();
+        if (retired_count >= __cmap_reclaim_batch) __try_advance();
+    }
+    // 写操作放弃: 释放本次产生的全部节点, 不回收任何已发布的节点
+    void __abort_write()
+    {
+        for (size_type n = 0; n < fresh.size(); ++n) __destroy_node(fresh[n]);
+        fresh.clear();
+        replaced.clear();
+        discarded.clear();
+    }
+
+    concurrent_map(const concurrent_map&);
+    concurrent_map& operator=(const concurrent_map&);
+};
+
+template <class Key, class T, class Compare, class Alloc>
+typename concurrent_map<Key, T, Compare, Alloc>::const_iterator
+concurrent_map<Key, T, Compare, Alloc>::snapshot_type::lower_bound(const key_type& k) const
+{
+    const_iterator it;
+    link_type x = r;
+    while (x != 0) {
+        if (!m->key_compare_(key(x), k)) {
+            it.stack[it.depth++] = x;
+            x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+    return it;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+typename concurrent_map<Key, T, Compare, Alloc>::const_iterator
+concurrent_map<Key, T, Compare, Alloc>::snapshot_type::upper_bound(const key_type& k) const
+{
+    const_iterator it;
+    link_type x = r;
+    while (x != 0) {
+        if (m->key_compare_(k, key(x))) {
+            it.stack[it.depth++] = x;
+            x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+    return it;
+}
+
+// epoch e 推进到 e + 1 的前提是已经没有登记在 e - 1 的读者. 推进之后,
+// 在 e - 1 中被取代的节点已不可能被任何读者看到, 可以释放
+template <class Key, class T, class Compare, class Alloc>
+void concurrent_map<Key, T, Compare, Alloc>::__try_advance()
+{
+    size_t e = epoch.load(std::memory_order_relaxed);
+    for (int i = 0; i < __cmap_reader_slots; ++i) {
+        if (readers[i].count[(e + 2) % 3].load() != 0) return;
+    }
+    epoch.store(e + 1);
+    __free_retired((e + 2) % 3);
+}
+
+template <class Key, class T, class Compare, class Alloc>
+typename concurrent_map<Key, T, Compare, Alloc>::link_type
+concurrent_map<Key, T, Compare, Alloc>::__rotate_left(link_type x)
+{
+    link_type y = __own(x->right);
+    x->right = y->left;
+    y->left = x;
+    __update(x);
+    __update(y);
+    return y;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+typename concurrent_map<Key, T, Compare, Alloc>::link_type
+concurrent_map<Key, T, Compare, Alloc>::__rotate_right(link_type x)
+{
+    link_type y = __own(x->left);
+    x->left = y->right;
+    y->right = x;
+    __update(x);
+    __update(y);
+    return y;
+}
+
+// x 必须是可写的. 左右子树高度差至多为 2, 经一次单旋转或双旋转恢复平衡
+template <class Key, class T, class Compare, class Alloc>
+typename concurrent_map<Key, T, Compare, Alloc>::link_type
+concurrent_map<Key, T, Compare, Alloc>::__balance(link_type x)
+{
+    int diff = height(x->left) - height(x->right);
+    if (diff > 1) {
+        if (height(x->left->left) < height(x->left->right)) {
+            x->left = __rotate_left(__own(x->left));
+        }
+        return __rotate_right(x);
+    }
+    if (diff < -1) {
+        if (height(x->right->right) < height(x->right->left)) {
+            x->right = __rotate_right(__own(x->right));
+        }
+        return __rotate_left(x);
+    }
+    __update(x);
+    return x;
+}
+
+// 只复制自根至插入点的路径. 没有任何改变时原样返回 x, 不产生新节点
+template <class Key, class T, class Compare, class Alloc>
+typename concurrent_map<Key, T, Compare, Alloc>::link_type
+concurrent_map<Key, T, Compare, Alloc>::__insert(link_type x, const value_type& v,
+                                                bool assign, bool& changed)
+{
+    if (x == 0) {
+        changed = true;
+        return __create_node(v, 0, 0);
+    }
+    if (key_compare_(v.first, key(x))) {
+        link_type l = __insert(x->left, v, assign, changed);
+        if (!changed) return x;
+        x = __own(x);
+        x->left = l;
+        return __balance(x);
+    }
+    if (key_compare_(key(x), v.first)) {
+        link_type r = __insert(x->right, v, assign, changed);
+        if (!changed) return x;
+        x = __own(x);
+        x->right = r;
+        return __balance(x);
+    }
+    if (!assign) {
+        changed = false;
+        return x;
+    }
+    // 键值为 const, 不能就地赋值: 以新值产生一个节点取代 x
+    changed = true;
+    link_type y = __create_node(v, x->left, x->right);
+    __retire(x);
+    return y;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+typename concurrent_map<Key, T, Compare, Alloc>::link_type
+concurrent_map<Key, T, Compare, Alloc>::__erase_min(link_type x, link_type& min)
+{
+    if (x->left == 0) {
+        min = x;
+        return x->right;
+    }
+    link_type l = __erase_min(x->left, min);
+    x = __own(x);
+    x->left = l;
+    return __balance(x);
+}
+
+template <class Key, class T, class Compare, class Alloc>
+typename concurrent_map<Key, T, Compare, Alloc>::link_type
+concurrent_map<Key, T, Compare, Alloc>::__erase(link_type x, const key_type& k, bool& erased)
+{
+    if (x == 0) {
+        erased = false;
+        return 0;
+    }
+    if (key_compare_(k, key(x))) {
+        link_type l = __erase(x->left, k, erased);
+        if (!erased) return x;
+        x = __own(x);
+        x->left = l;
+        return __balance(x);
+    }
+    if (key_compare_(key(x), k)) {
+        link_type r = __erase(x->right, k, erased);
+        if (!erased) return x;
+        x = __own(x);
+        x->right = r;
+        return __balance(x);
+    }
+    erased = true;
+    link_type l = x->left;
+    link_type r = x->right;
+    __retire(x);
+    if (l == 0) return r;
+    if (r == 0) return l;
+    // 以右子树的最小节点取代 x
+    link_type min;
+    r = __erase_min(r, min);
+    min = __own(min);
+    min->left = l;
+    min->right = r;
+    return __balance(min);
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool concurrent_map<Key, T, Compare, Alloc>::insert(const value_type& v)
+{
+    std::lock_guard<std::mutex> guard(writer_lock);
+    __begin_write();
+    bool changed = false;
+    __STL_TRY {
+        link_type r = __insert(root.load(std::memory_order_relaxed), v, false, changed);
+        if (changed) __publish(r);
+    }
+    __STL_UNWIND(__abort_write());
+    return changed;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+void concurrent_map<Key, T, Compare, Alloc>::insert_or_assign(const key_type& k, const T& v)
+{
+    std::lock_guard<std::mutex> guard(writer_lock);
+    __begin_write();
+    bool changed = false;
+    __STL_TRY {
+        __publish(__insert(root.load(std::memory_order_relaxed), value_type(k, v), true,
+                           changed));
+    }
+    __STL_UNWIND(__abort_write());
+}
+
+template <class Key, class T, class Compare, class Alloc>
+typename concurrent_map<Key, T, Compare, Alloc>::size_type
+concurrent_map<Key, T, Compare, Alloc>::erase(const key_type& k)
+{
+    std::lock_guard<std::mutex> guard(writer_lock);
+    __begin_write();
+    bool erased = false;
+    __STL_TRY {
+        link_type r = __erase(root.load(std::memory_order_relaxed), k, erased);
+        if (erased) __publish(r);
+    }
+    __STL_UNWIND(__abort_write());
+    return erased ? 1 : 0;
+}
+
+// 整棵树都交给回收. 读者可能仍在旧版本中
+template <class Key, class T, class Compare, class Alloc>
+void concurrent_map<Key, T, Compare, Alloc>::clear()
+{
+    std::lock_guard<std::mutex> guard(writer_lock);
+    __begin_write();
+    vector<link_type, Alloc> stack;
+    link_type old = root.load(std::memory_order_relaxed);
+    if (old != 0) stack.push_back(old);
+    while (!stack.empty()) {
+        link_type x = stack.back();
+        stack.pop_back();
+        if (x->left != 0) stack.push_back(x->left);
+        if (x->right != 0) stack.push_back(x->right);
+        __retire(x);
+    }
+    __publish(0);
+}
+
+#endif /* __STL_CONCURRENT_MAP_H */
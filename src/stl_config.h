@@ -130,6 +130,20 @@
 //   standard-conforming iostreams (e.g. the <iosfwd> header).  If not
 //   defined, the STL will use old cfront-style iostreams (e.g. the
 //   <iostream.h> header).
+// * __STL_RB_TREE_SUBTREE_SIZE: if defined, every red-black tree node also
+//   records the size of its subtree.  set, map, multiset and multimap then
+//   provide select(), rank() and logarithmic-time distance() and advance(),
+//   at the cost of one extra word per node and a little extra work on every
+//   insertion, erasure and rotation.
+// * __STL_RB_TREE_COMPACT_NODE: if defined, red-black tree nodes keep their
+//   color in the low bit of the parent pointer instead of in a separate
+//   field.  This saves one word per node (e.g. 32 -> 24 bytes of node
+//   overhead on LP64) at the cost of a mask on every parent access.
+// * __STL_HASHTABLE_POW2_BUCKETS: if defined, hashtable (and hence hash_set,
+//   hash_map, hash_multiset and hash_multimap) uses power-of-two bucket
+//   counts and maps a hash code to a bucket by mixing it and masking the low
+//   bits.  By default bucket counts are primes and the modulo is done by a
+//   per-prime function that the compiler reduces to a multiply and shift.
 
 // Other macros defined by this file:
 
@@ -1,5 +1,11 @@
+#ifndef __STL_CONSTRUCT_H
+#define __STL_CONSTRUCT_H
+
 #include <new>    // for placement new
 
+#include "type_traits.h"
+#include "stl_iterator.h"
+
 template <class T1, class T2>
 inline void construct(T1* p, const T2& value)
 {
@@ -13,12 +19,15 @@ inline void destroy(T* pointer)
     pointer->~T();      // 调用 dtor ~T()
 }
 
+template <class ForwardIterator, class T>
+inline void __destroy(ForwardIterator first, ForwardIterator last, T*);
+
 // destroy() 第二个版本，接受两个迭代器。此函数设法找出元素的数值型别,
 // 进而利用 __type_traits<> 求取最适当措施
 template <class ForwardIterator>
-inline void destory(ForwardIterator first, ForwardIterator last)
+inline void destroy(ForwardIterator first, ForwardIterator last)
 {
-    __destroy(first, last, value_type(first));      // value_type() 详见3.7节
+    __destroy(first, last, cstl::value_type(first));    // value_type() 详见3.7节
 }
 
 // 判断元素的数值型别(value type)是否有 trivial destructor
@@ -34,7 +43,7 @@ template <class ForwardIterator>
 inline void __destroy_aux(ForwardIterator first, ForwardIterator last, __false_type)
 {
     for ( ; first < last; first++)
-        destory(&*first);
+        destroy(&*first);
 }
 
 // 如果元素的数值型别(value type)有 trivial destructor
@@ -43,4 +52,13 @@ inline void __destroy_aux(ForwardIterator, ForwardIterator, __true_type) { }
 
 // 以下是destory()第二个版本针对迭代器为 char* 和 wchar_t* 的特化版
 inline void destroy(char*, char*) { }
-inline void destroy(wchar_t*, wchar_t*) { }
\ No newline at end of file
+inline void destroy(wchar_t*, wchar_t*) { }
+
+// 早期的拼写 destory(), 保留给既有的调用者
+template <class T>
+inline void destory(T* pointer) { destroy(pointer); }
+
+template <class ForwardIterator>
+inline void destory(ForwardIterator first, ForwardIterator last) { destroy(first, last); }
+
+#endif /* __STL_CONSTRUCT_H */
@@ -0,0 +1,463 @@
+#ifndef __STL_FLAT_HASHTABLE_H
+#define __STL_FLAT_HASHTABLE_H
+
+#include <cstddef>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../src/stl_config.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_construct.h"
+#include "../src/stl_iterator.h"
+#include "../src/stl_pair.h"
+#include "../src/stl_hash_fun.h"
+
+// 开放定址(open addressing)的杂凑表, 供 flat_hash_set/flat_hash_map 使用 (Swiss table 的做法)
+// hashtable 以串行(separate chaining)解决碰撞, 每查一个节点就是一次 cache miss.
+// 这里所有元素直接存放于一个 slot 数组中, 另有一个平行的控制字节(control byte)数组:
+// 每个 slot 对应一个字节, 记录该 slot 为空, 已删除, 或者存放着杂凑值低 7 位 (H2).
+// 查找时一次取 16 个控制字节, 以 SSE2 同时与 H2 比较, 只有控制字节相符的 slot 才需要
+// 比较键值; 遇到含有空 slot 的一组即可断定键值不存在.
+//
+// 注意:
+// - 插入可能导致重新配置, 使所有迭代器失效, 元素的地址也会改变
+// - 删除不会使其他元素的迭代器失效
+// - 杂凑函数沿用 stl_hash_fun.h 的 hash<>. 它们对整数只是恒等函数, 所以这里会先把
+//   杂凑值打散(__stl_hash_mix), 再分成决定探测起点的 H1 和存入控制字节的 H2
+
+typedef signed char __fht_ctrl_type;
+const __fht_ctrl_type __fht_empty = -128;   // 1000 0000
+const __fht_ctrl_type __fht_deleted = -2;   // 1111 1110
+                                            // 存放元素者为 0xxx xxxx, 即 H2
+
+inline int __fht_ctz(unsigned x)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(x);
+#else
+    int n = 0;
+    for ( ; (x & 1) == 0; x >>= 1) ++n;
+    return n;
+#endif
+}
+
+// 16 位遮罩的前导 0 个数
+inline int __fht_clz16(unsigned x)
+{
+    int n = 0;
+    for (unsigned bit = 0x8000; bit != 0 && (x & bit) == 0; bit >>= 1) ++n;
+    return n;
+}
+
+// 一组 16 个控制字节. match 系列函数返回一个遮罩, 第 i 位为 1 表示第 i 个字节符合
+struct __fht_group {
+    enum { width = 16 };
+#ifdef __SSE2__
+    __m128i ctrl;
+    explicit __fht_group(const __fht_ctrl_type* p)
+        : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) { }
+    unsigned match(__fht_ctrl_type h2) const
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+    }
+    unsigned match_empty() const { return match(__fht_empty); }
+    // 空与已删除的最高位都是 1, 存放元素者为 0
+    unsigned match_empty_or_deleted() const { return _mm_movemask_epi8(ctrl); }
+#else /* __SSE2__ */
+    const __fht_ctrl_type* ctrl;
+    explicit __fht_group(const __fht_ctrl_type* p) : ctrl(p) { }
+    unsigned match(__fht_ctrl_type h2) const
+    {
+        unsigned m = 0;
+        for (int i = 0; i < width; ++i) {
+            if (ctrl[i] == h2) m |= 1u << i;
+        }
+        return m;
+    }
+    unsigned match_empty() const { return match(__fht_empty); }
+    unsigned match_empty_or_deleted() const
+    {
+        unsigned m = 0;
+        for (int i = 0; i < width; ++i) {
+            if (ctrl[i] < 0) m |= 1u << i;
+        }
+        return m;
+    }
+#endif /* __SSE2__ */
+};
+
+template <class Value, class Ref, class Ptr>
+struct __flat_hashtable_iterator {
+    typedef __flat_hashtable_iterator<Value, Value&, Value*> iterator;
+    typedef __flat_hashtable_iterator<Value, const Value&, const Value*> const_iterator;
+    typedef __flat_hashtable_iterator<Value, Ref, Ptr> self;
+
+    typedef forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+
+    const __fht_ctrl_type* ctrl;        // 当前 slot 的控制字节
+    const __fht_ctrl_type* ctrl_end;    // 控制字节数组的尾端, 即 end()
+    Value* slot;
+
+    __flat_hashtable_iterator() : ctrl(0), ctrl_end(0), slot(0) { }
+    __flat_hashtable_iterator(const __fht_ctrl_type* c, const __fht_ctrl_type* e, Value* s)
+        : ctrl(c), ctrl_end(e), slot(s) { }
+    __flat_hashtable_iterator(const iterator& it)
+        : ctrl(it.ctrl), ctrl_end(it.ctrl_end), slot(it.slot) { }
+
+    // 跳过空的和已删除的 slot
+    void skip_empty()
+    {
+        while (ctrl != ctrl_end && *ctrl < 0) {
+            ++ctrl;
+            ++slot;
+        }
+    }
+
+    reference operator*() const { return *slot; }
+    pointer operator->() const { return &(operator*()); }
+    self& operator++()
+    {
+        ++ctrl;
+        ++slot;
+        skip_empty();
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    bool operator==(const self& x) const { return ctrl == x.ctrl; }
+    bool operator!=(const self& x) const { return ctrl != x.ctrl; }
+};
+
+template <class Value, class Key, class HashFcn,
+          class ExtractKey, class EqualKey, class Alloc = alloc>
+class flat_hashtable {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef HashFcn hasher;
+    typedef EqualKey key_equal;
+
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+
+    typedef __flat_hashtable_iterator<Value, Value&, Value*> iterator;
+    typedef __flat_hashtable_iterator<Value, const Value&, const Value*> const_iterator;
+
+    hasher hash_funct() const { return hash; }
+    key_equal key_eq() const { return equals; }
+
+private:
+    typedef __fht_group group;
+    typedef simple_alloc<value_type, Alloc> slot_allocator;
+    typedef simple_alloc<__fht_ctrl_type, Alloc> ctrl_allocator;
+
+    hasher hash;
+    key_equal equals;
+    ExtractKey get_key;
+
+    // ctrl 共有 capacity + group::width 个字节: 末尾多出的一组是前 group::width 个字节的副本,
+    // 使得从任何位置起都能一次取出完整的一组, 不必处理绕回
+    __fht_ctrl_type* ctrl;
+    value_type* slots;
+    size_type capacity;         // 0 或者 2 的幂次 (至少 group::width)
+    size_type num_elements;
+    size_type growth_left;      // 还能填入多少个空 slot 而不超过最大负载 7/8
+
+    static size_type max_load(size_type n) { return n - n / 8; }
+
+    void set_ctrl(size_type i, __fht_ctrl_type h)
+    {
+        ctrl[i] = h;
+        if (i < group::width) ctrl[capacity + i] = h;
+    }
+
+    // 以 group::width 为步幅的三角探测: pos, pos + 16, pos + 48, pos + 96, ...
+    // capacity 为 2 的幂次时, 必定会走遍每一组
+    size_type find_index(const key_type& k, size_t h) const;
+    size_type find_insert_slot(size_t h) const;
+    void rehash(size_type n);
+    void grow();
+    void initialize(size_type n);
+
+public:
+    flat_hashtable(size_type n, const HashFcn& hf, const EqualKey& eql)
+        : hash(hf), equals(eql), get_key(ExtractKey()),
+          ctrl(0), slots(0), capacity(0), num_elements(0), growth_left(0)
+    {
+        reserve(n);
+    }
+    flat_hashtable(const flat_hashtable& ht)
+        : hash(ht.hash), equals(ht.equals), get_key(ht.get_key),
+          ctrl(0), slots(0), capacity(0), num_elements(0), growth_left(0)
+    {
+        copy_from(ht);
+    }
+    flat_hashtable& operator=(const flat_hashtable& ht)
+    {
+        if (&ht != this) {
+            flat_hashtable tmp(ht);
+            swap(tmp);
+        }
+        return *this;
+    }
+    ~flat_hashtable()
+    {
+        clear();
+        deallocate();
+    }
+
+    size_type size() const { return num_elements; }
+    size_type max_size() const { return size_type(-1) / sizeof(value_type); }
+    bool empty() const { return size() == 0; }
+    size_type bucket_count() const { return capacity; }
+
+    void swap(flat_hashtable& ht)
+    {
+        std::swap(hash, ht.hash);
+        std::swap(equals, ht.equals);
+        std::swap(get_key, ht.get_key);
+        std::swap(ctrl, ht.ctrl);
+        std::swap(slots, ht.slots);
+        std::swap(capacity, ht.capacity);
+        std::swap(num_elements, ht.num_elements);
+        std::swap(growth_left, ht.growth_left);
+    }
+
+    iterator begin()
+    {
+        iterator it(ctrl, ctrl + capacity, slots);
+        it.skip_empty();
+        return it;
+    }
+    iterator end() { return iterator(ctrl + capacity, ctrl + capacity, slots + capacity); }
+    const_iterator begin() const
+    {
+        const_iterator it(ctrl, ctrl + capacity, slots);
+        it.skip_empty();
+        return it;
+    }
+    const_iterator end() const
+    {
+        return const_iterator(ctrl + capacity, ctrl + capacity, slots + capacity);
+    }
+
+    // 预留至少能容纳 n 个元素而不必重新配置的空间
+    void reserve(size_type n);
+
+    pair<iterator, bool> insert_unique(const value_type& obj);
+    template <class InputIterator>
+    void insert_unique(InputIterator f, InputIterator l)
+    {
+        for ( ; f != l; ++f) insert_unique(*f);
+    }
+
+    iterator find(const key_type& key)
+    {
+        size_type i = find_index(key, __stl_hash_mix(hash(key)));
+        return iterator(ctrl + i, ctrl + capacity, slots + i);
+    }
+    const_iterator find(const key_type& key) const
+    {
+        size_type i = find_index(key, __stl_hash_mix(hash(key)));
+        return const_iterator(ctrl + i, ctrl + capacity, slots + i);
+    }
+    size_type count(const key_type& key) const
+    {
+        return find_index(key, __stl_hash_mix(hash(key))) != capacity ? 1 : 0;
+    }
+
+    size_type erase(const key_type& key)
+    {
+        size_type i = find_index(key, __stl_hash_mix(hash(key)));
+        if (i == capacity) return 0;
+        erase_index(i);
+        return 1;
+    }
+    void erase(const const_iterator& it) { erase_index(it.slot - slots); }
+    void erase_index(size_type i);
+    void clear();
+
+private:
+    void copy_from(const flat_hashtable& ht);
+    void deallocate()
+    {
+        if (capacity != 0) {
+            ctrl_allocator::deallocate(ctrl, capacity + group::width);
+            slot_allocator::deallocate(slots, capacity);
+        }
+    }
+};
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename flat_hashtable<V, K, HF, Ex, Eq, A>::size_type
+flat_hashtable<V, K, HF, Ex, Eq, A>::find_index(const key_type& k, size_t h) const
+{
+    if (capacity == 0) return 0;
+    const __fht_ctrl_type h2 = __fht_ctrl_type(h & 0x7f);
+    const size_type mask = capacity - 1;
+    size_type pos = (h >> 7) & mask;
+    for (size_type step = group::width; ; step += group::width) {
+        group g(ctrl + pos);
+        for (unsigned m = g.match(h2); m != 0; m &= m - 1) {
+            size_type i = (pos + __fht_ctz(m)) & mask;
+            if (equals(get_key(slots[i]), k)) return i;
+        }
+        // 这一组中有空 slot, 插入时探测必定止于此, 键值不可能在更后面
+        if (g.match_empty() != 0) return capacity;
+        pos = (pos + step) & mask;
+    }
+}
+
+// 沿与 find_index() 相同的探测序列, 找出第一个空的或已删除的 slot.
+// 负载不超过 7/8, 所以一定找得到
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename flat_hashtable<V, K, HF, Ex, Eq, A>::size_type
+flat_hashtable<V, K, HF, Ex, Eq, A>::find_insert_slot(size_t h) const
+{
+    const size_type mask = capacity - 1;
+    size_type pos = (h >> 7) & mask;
+    for (size_type step = group::width; ; step += group::width) {
+        unsigned m = group(ctrl + pos).match_empty_or_deleted();
+        if (m != 0) return (pos + __fht_ctz(m)) & mask;
+        pos = (pos + step) & mask;
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void flat_hashtable<V, K, HF, Ex, Eq, A>::initialize(size_type n)
+{
+    ctrl = ctrl_allocator::allocate(n + group::width);
+    __STL_TRY {
+        slots = slot_allocator::allocate(n);
+    }
+    __STL_UNWIND(ctrl_allocator::deallocate(ctrl, n + group::width));
+    for (size_type i = 0; i < n + group::width; ++i) ctrl[i] = __fht_empty;
+    capacity = n;
+    num_elements = 0;
+    growth_left = max_load(n);
+}
+
+// 把所有元素搬到容量为 n 的新数组中, 顺便清除所有已删除标记.
+// 复制元素时若发生异常, 新数组整个放弃, 原有内容不受影响
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void flat_hashtable<V, K, HF, Ex, Eq, A>::rehash(size_type n)
+{
+    flat_hashtable tmp(0, hash, equals);
+    tmp.initialize(n);
+    for (size_type i = 0; i < capacity; ++i) {
+        if (ctrl[i] >= 0) {
+            const size_t h = __stl_hash_mix(hash(get_key(slots[i])));
+            const size_type j = tmp.find_insert_slot(h);
+            construct(tmp.slots + j, slots[i]);
+            tmp.set_ctrl(j, __fht_ctrl_type(h & 0x7f));
+            ++tmp.num_elements;
+            --tmp.growth_left;
+        }
+    }
+    swap(tmp);
+}
+
+// 没有空间时: 已删除的 slot 若占了相当比例, 以原容量重建即可回收它们; 否则加倍
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void flat_hashtable<V, K, HF, Ex, Eq, A>::grow()
+{
+    if (capacity == 0) {
+        rehash(group::width);
+    } else if (num_elements * 16 <= capacity * 7) {
+        rehash(capacity);
+    } else {
+        rehash(capacity * 2);
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void flat_hashtable<V, K, HF, Ex, Eq, A>::reserve(size_type n)
+{
+    if (n == 0) return;
+    size_type cap = group::width;
+    while (max_load(cap) < n) cap *= 2;
+    if (cap > capacity) rehash(cap);
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+pair<typename flat_hashtable<V, K, HF, Ex, Eq, A>::iterator, bool>
+flat_hashtable<V, K, HF, Ex, Eq, A>::insert_unique(const value_type& obj)
+{
+    const size_t h = __stl_hash_mix(hash(get_key(obj)));
+    size_type i = find_index(get_key(obj), h);
+    if (i != capacity) {
+        return pair<iterator, bool>(iterator(ctrl + i, ctrl + capacity, slots + i), false);
+    }
+    i = capacity != 0 ? find_insert_slot(h) : 0;
+    // 重用已删除的 slot 不会增加负载; 用掉空 slot 时才需要检查剩余空间
+    if (capacity == 0 || (ctrl[i] == __fht_empty && growth_left == 0)) {
+        grow();
+        i = find_insert_slot(h);
+    }
+    construct(slots + i, obj);
+    if (ctrl[i] == __fht_empty) --growth_left;
+    set_ctrl(i, __fht_ctrl_type(h & 0x7f));
+    ++num_elements;
+    return pair<iterator, bool>(iterator(ctrl + i, ctrl + capacity, slots + i), true);
+}
+
+// 删除时尽量不留已删除标记: 若包含 i 的任何一组 16 个 slot 从来不曾全满, 就不会有探测
+// 因为这一组而继续往后走, 直接标为空即可. 以 i 之前与之后最近的空 slot 的距离来判断
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void flat_hashtable<V, K, HF, Ex, Eq, A>::erase_index(size_type i)
+{
+    ::destroy(slots + i);
+    --num_elements;
+    const size_type before = (i - group::width) & (capacity - 1);
+    const unsigned empty_after = group(ctrl + i).match_empty();
+    const unsigned empty_before = group(ctrl + before).match_empty();
+    const bool was_never_full = empty_before != 0 && empty_after != 0
+        && __fht_ctz(empty_after) + __fht_clz16(empty_before) < int(group::width);
+    if (was_never_full) {
+        set_ctrl(i, __fht_empty);
+        ++growth_left;
+    } else {
+        set_ctrl(i, __fht_deleted);
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void flat_hashtable<V, K, HF, Ex, Eq, A>::clear()
+{
+    for (size_type i = 0; i < capacity; ++i) {
+        if (ctrl[i] >= 0) ::destroy(slots + i);
+    }
+    for (size_type i = 0; i < capacity + (capacity != 0 ? group::width : 0); ++i) {
+        ctrl[i] = __fht_empty;
+    }
+    num_elements = 0;
+    growth_left = max_load(capacity);
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void flat_hashtable<V, K, HF, Ex, Eq, A>::copy_from(const flat_hashtable& ht)
+{
+    if (ht.num_elements == 0) return;
+    reserve(ht.num_elements);
+    __STL_TRY {
+        for (const_iterator it = ht.begin(); it != ht.end(); ++it) {
+            insert_unique(*it);
+        }
+    }
+    __STL_UNWIND(clear(); deallocate());
+}
+
+#endif /* __STL_FLAT_HASHTABLE_H */
@@ -0,0 +1,205 @@
+#ifndef __STL_FLAT_MAP_H
+#define __STL_FLAT_MAP_H
+
+#include "stl_config.h"
+#include "stl_pair.h"
+#include "stl_function.h"
+#include "stl_alloc.h"
+#include "stl_algo.h"
+#include "stl_vector.h"
+
+namespace cstl
+{
+
+// 以有序 vector 表现的 map, 取舍与 flat_set 相同, 见 stl_flat_set.h
+//
+// 注意: 元素型别为 pair<Key, T> 而非 pair<const Key, T>, 因为 vector 在插入, 删除和排序时
+// 需要对元素赋值. 用户不得经由迭代器修改键值
+
+template <class Key, class T, class Compare = less<Key>, class Alloc = alloc>
+class flat_map {
+public:
+    // typedefs:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<Key, T> value_type;
+    typedef Compare key_compare;
+
+    // 既可比较两个元素, 也可比较元素与键值, 供 lower_bound()/sort() 等算法使用
+    class value_compare : public binary_function<value_type, value_type, bool> {
+        friend class flat_map<Key, T, Compare, Alloc>;
+    protected:
+        Compare comp;
+        value_compare(Compare c) : comp(c) { }
+    public:
+        bool operator() (const value_type& x, const value_type& y) const
+        {
+            return comp(x.first, y.first);
+        }
+        bool operator() (const value_type& x, const key_type& k) const
+        {
+            return comp(x.first, k);
+        }
+        bool operator() (const key_type& k, const value_type& y) const
+        {
+            return comp(k, y.first);
+        }
+    };
+
+private:
+    typedef vector<value_type, Alloc> rep_type;
+    rep_type c;
+    value_compare comp;
+
+public:
+    typedef typename rep_type::pointer pointer;
+    typedef const value_type* const_pointer;
+    typedef typename rep_type::reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    // allocation/deallocation
+    flat_map() : comp(Compare()) { }
+    explicit flat_map(const Compare& cmp) : comp(cmp) { }
+
+    template <class InputIterator>
+    flat_map(InputIterator first, InputIterator last)
+        : comp(Compare()) { insert(first, last); }
+
+    template <class InputIterator>
+    flat_map(InputIterator first, InputIterator last, const Compare& cmp)
+        : comp(cmp) { insert(first, last); }
+
+    // accessors:
+    key_compare key_comp() const { return comp.comp; }
+    value_compare value_comp() const { return comp; }
+    iterator begin() { return c.begin(); }
+    const_iterator begin() const { return c.begin(); }
+    iterator end() { return c.end(); }
+    const_iterator end() const { return c.end(); }
+    bool empty() const { return c.empty(); }
+    size_type size() const { return c.size(); }
+    size_type max_size() const { return size_type(-1) / sizeof(value_type); }
+    size_type capacity() const { return c.capacity(); }
+    void reserve(size_type n) { c.reserve(n); }
+
+    T& operator[](const key_type& k)
+    {
+        iterator i = lower_bound(k);
+        if (i == end() || comp(k, *i)) {
+            i = c.insert(i, value_type(k, T()));
+        }
+        return (*i).second;
+    }
+    void swap(flat_map<Key, T, Compare, Alloc>& x)
+    {
+        c.swap(x.c);
+        std::swap(comp, x.comp);
+    }
+
+    // 直接接收 v 的空间作为本容器的内容, 不复制任何元素; 原有内容交给 v.
+    // v 必须已按键值排序, 且没有重复的键值
+    void adopt_sorted(rep_type& v) { c.swap(v); }
+
+    // insert/erase
+    pair<iterator, bool> insert(const value_type& x)
+    {
+        iterator i = lower_bound(x.first);
+        if (i != end() && !comp(x, *i)) {
+            return pair<iterator, bool>(i, false);
+        }
+        return pair<iterator, bool>(c.insert(i, x), true);
+    }
+    // position 为提示: 若 x 恰好应该放在 position 之前, 不必二分查找
+    iterator insert(iterator position, const value_type& x)
+    {
+        if ((position == end() || comp(x, *position))
+            && (position == begin() || comp(*(position - 1), x))) {
+            return c.insert(position, x);
+        }
+        return insert(x).first;
+    }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last);
+
+    void erase(iterator position) { c.erase(position); }
+    size_type erase(const key_type& x)
+    {
+        iterator i = find(x);
+        if (i == end()) return 0;
+        erase(i);
+        return 1;
+    }
+    void erase(iterator first, iterator last) { c.erase(first, last); }
+    void clear() { c.clear(); }
+
+    // map operations:
+    iterator find(const key_type& x)
+    {
+        iterator i = lower_bound(x);
+        return (i == end() || comp(x, *i)) ? end() : i;
+    }
+    const_iterator find(const key_type& x) const
+    {
+        const_iterator i = lower_bound(x);
+        return (i == end() || comp(x, *i)) ? end() : i;
+    }
+    size_type count(const key_type& x) const { return find(x) == end() ? 0 : 1; }
+    iterator lower_bound(const key_type& x)
+    {
+        return cstl::lower_bound(begin(), end(), x, comp);
+    }
+    const_iterator lower_bound(const key_type& x) const
+    {
+        return cstl::lower_bound(begin(), end(), x, comp);
+    }
+    iterator upper_bound(const key_type& x)
+    {
+        return cstl::upper_bound(begin(), end(), x, comp);
+    }
+    const_iterator upper_bound(const key_type& x) const
+    {
+        return cstl::upper_bound(begin(), end(), x, comp);
+    }
+    pair<iterator, iterator> equal_range(const key_type& x)
+    {
+        iterator i = lower_bound(x);
+        if (i == end() || comp(x, *i)) return pair<iterator, iterator>(i, i);
+        return pair<iterator, iterator>(i, i + 1);
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& x) const
+    {
+        const_iterator i = lower_bound(x);
+        if (i == end() || comp(x, *i)) return pair<const_iterator, const_iterator>(i, i);
+        return pair<const_iterator, const_iterator>(i, i + 1);
+    }
+};
+
+// 与 flat_set::insert(first, last) 相同: 附加, 排序, inplace_merge, 去除重复键值.
+// 键值重复时保留原有元素
+template <class Key, class T, class Compare, class Alloc>
+template <class InputIterator>
+void flat_map<Key, T, Compare, Alloc>::insert(InputIterator first, InputIterator last)
+{
+    const size_type old_size = c.size();
+    for ( ; first != last; ++first) c.push_back(*first);
+    if (c.size() == old_size) return;
+
+    iterator middle = c.begin() + old_size;
+    cstl::sort(middle, c.end(), comp);
+    cstl::inplace_merge(c.begin(), middle, c.end(), comp);
+
+    iterator result = c.begin();
+    for (iterator i = c.begin() + 1; i != c.end(); ++i) {
+        if (comp(*result, *i) && ++result != i) *result = *i;
+    }
+    c.erase(result + 1, c.end());
+}
+
+} // namespace cstl
+
+#endif /* __STL_FLAT_MAP_H */
@@ -0,0 +1,166 @@
+#ifndef __STL_FLAT_SET_H
+#define __STL_FLAT_SET_H
+
+#include "stl_config.h"
+#include "stl_pair.h"
+#include "stl_function.h"
+#include "stl_alloc.h"
+#include "stl_algo.h"
+#include "stl_vector.h"
+
+namespace cstl
+{
+
+// 以有序 vector 表现的 set
+// 元素连续存放, 没有任何节点开销; 查找是对连续空间的二分查找, 遍历只是指针加 1,
+// 都远快于 rb_tree. 代价是单个元素的插入和删除为 O(n), 所以适合 "建好之后以查询为主" 的场合.
+// 大批元素应该以 insert(first, last) 一次加入, 或者以 adopt_sorted() 直接接收一个已排序的 vector
+//
+// 注意: 插入和删除会使迭代器失效, 与 vector 相同
+
+template <class Key, class Compare = less<Key>, class Alloc = alloc>
+class flat_set {
+public:     // typedefs
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+private:
+    typedef vector<Key, Alloc> rep_type;
+public:
+    typedef const value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef const value_type& reference;
+    typedef const value_type& const_reference;
+    // 与 set 相同, 不允许经由迭代器修改元素
+    typedef typename rep_type::const_iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+private:
+    rep_type c;
+    Compare comp;
+
+    typename rep_type::iterator mutable_iterator(const_iterator it)
+    {
+        return c.begin() + (it - c.begin());
+    }
+
+public:
+    // allocation/deallocation
+    flat_set() : comp(Compare()) { }
+    explicit flat_set(const Compare& cmp) : comp(cmp) { }
+
+    template <class InputIterator>
+    flat_set(InputIterator first, InputIterator last)
+        : comp(Compare()) { insert(first, last); }
+
+    template <class InputIterator>
+    flat_set(InputIterator first, InputIterator last, const Compare& cmp)
+        : comp(cmp) { insert(first, last); }
+
+    // accessors:
+    key_compare key_comp() const { return comp; }
+    value_compare value_comp() const { return comp; }
+    iterator begin() const { return c.begin(); }
+    iterator end() const { return c.end(); }
+    bool empty() const { return c.empty(); }
+    size_type size() const { return c.size(); }
+    size_type max_size() const { return size_type(-1) / sizeof(Key); }
+    size_type capacity() const { return c.capacity(); }
+    void reserve(size_type n) { c.reserve(n); }
+    void swap(flat_set<Key, Compare, Alloc>& x)
+    {
+        c.swap(x.c);
+        std::swap(comp, x.comp);
+    }
+
+    // 直接接收 v 的空间作为本容器的内容, 不复制任何元素; 原有内容交给 v.
+    // v 必须已按 comp 排序, 且没有重复的元素
+    void adopt_sorted(rep_type& v) { c.swap(v); }
+
+    // insert/erase
+    pair<iterator, bool> insert(const value_type& x)
+    {
+        typename rep_type::iterator i = cstl::lower_bound(c.begin(), c.end(), x, comp);
+        if (i != c.end() && !comp(x, *i)) {
+            return pair<iterator, bool>(i, false);
+        }
+        return pair<iterator, bool>(c.insert(i, x), true);
+    }
+    // position 为提示: 若 x 恰好应该放在 position 之前, 不必二分查找
+    iterator insert(iterator position, const value_type& x)
+    {
+        if ((position == end() || comp(x, *position))
+            && (position == begin() || comp(*(position - 1), x))) {
+            return c.insert(mutable_iterator(position), x);
+        }
+        return insert(x).first;
+    }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last);
+
+    void erase(iterator position) { c.erase(mutable_iterator(position)); }
+    size_type erase(const key_type& x)
+    {
+        iterator i = find(x);
+        if (i == end()) return 0;
+        erase(i);
+        return 1;
+    }
+    void erase(iterator first, iterator last)
+    {
+        c.erase(mutable_iterator(first), mutable_iterator(last));
+    }
+    void clear() { c.clear(); }
+
+    // set operations:
+    iterator find(const key_type& x) const
+    {
+        iterator i = lower_bound(x);
+        return (i == end() || comp(x, *i)) ? end() : i;
+    }
+    size_type count(const key_type& x) const { return find(x) == end() ? 0 : 1; }
+    iterator lower_bound(const key_type& x) const
+    {
+        return cstl::lower_bound(begin(), end(), x, comp);
+    }
+    iterator upper_bound(const key_type& x) const
+    {
+        return cstl::upper_bound(begin(), end(), x, comp);
+    }
+    pair<iterator, iterator> equal_range(const key_type& x) const
+    {
+        iterator i = lower_bound(x);
+        if (i == end() || comp(x, *i)) return pair<iterator, iterator>(i, i);
+        return pair<iterator, iterator>(i, i + 1);
+    }
+};
+
+// 新元素先全部附加于尾端, 单独排序后与原有内容 inplace_merge 成一个有序序列,
+// 最后一趟去除重复 (inplace_merge 是稳定的, 所以原有元素优先保留).
+// 复杂度 O(n + m log m), 逐一插入则为 O(n * m)
+template <class Key, class Compare, class Alloc>
+template <class InputIterator>
+void flat_set<Key, Compare, Alloc>::insert(InputIterator first, InputIterator last)
+{
+    const size_type old_size = c.size();
+    for ( ; first != last; ++first) c.push_back(*first);
+    if (c.size() == old_size) return;
+
+    typename rep_type::iterator middle = c.begin() + old_size;
+    cstl::sort(middle, c.end(), comp);
+    cstl::inplace_merge(c.begin(), middle, c.end(), comp);
+
+    // 相邻而不 "小于" 即为重复
+    typename rep_type::iterator result = c.begin();
+    for (typename rep_type::iterator i = c.begin() + 1; i != c.end(); ++i) {
+        if (comp(*result, *i) && ++result != i) *result = *i;
+    }
+    c.erase(result + 1, c.end());
+}
+
+} // namespace cstl
+
+#endif /* __STL_FLAT_SET_H */
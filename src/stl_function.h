@@ -98,6 +98,16 @@ struct equal_to : public binary_function<T,T,bool>
   bool operator()(const T& x, const T& y) const { return x == y; }
 };
 
+// 透明(transparent)版本: 两个参数可以是不同的型别. 以之作为 hash_* 容器的 EqualKey,
+// 查找时可直接传入任何能与键值比较相等的型别, 不必先构造出一个 key_type
+template <>
+struct equal_to<void>
+{
+  typedef void is_transparent;
+  template <class T, class U>
+  bool operator()(const T& x, const U& y) const { return x == y; }
+};
+
 template <class T>
 struct not_equal_to : public binary_function<T,T,bool> 
 {
@@ -116,6 +126,16 @@ struct less : public binary_function<T,T,bool>
   bool operator()(const T& x, const T& y) const { return x < y; }
 };
 
+// 透明版本. 以之作为 set/map 的 Compare, 例如 map<std::string, int, less<void> >,
+// 就能以 const char* 查找而不必构造临时的 std::string
+template <>
+struct less<void>
+{
+  typedef void is_transparent;
+  template <class T, class U>
+  bool operator()(const T& x, const U& y) const { return x < y; }
+};
+
 template <class T>
 struct greater_equal : public binary_function<T,T,bool>
 {
@@ -733,6 +753,20 @@ inline const_mem_fun1_ref_t<Ret,T,Arg>
 mem_fun1_ref(Ret (T::*f)(Arg) const)
   { return const_mem_fun1_ref_t<Ret,T,Arg>(f); }
 
+// 异质查找(heterogeneous lookup)的开关: F 定义了 is_transparent 时, type 即为 R;
+// 否则没有 type, 使得以之为返回型别的成员模板不参与重载决议.
+// K 为查找所用的型别, 它只是让整个型别依赖于成员模板自己的参数, 替换失败才不算错误
+template <class T>
+struct __void_type { typedef void type; };
+
+template <class F, class K, class R, class = void>
+struct __if_transparent { };
+
+template <class F, class K, class R>
+struct __if_transparent<F, K, R, typename __void_type<typename F::is_transparent>::type> {
+  typedef R type;
+};
+
 } // namespace cstl
 
 #endif /* __SGI_STL_INTERNAL_FUNCTION_H */
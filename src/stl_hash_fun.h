@@ -48,6 +48,42 @@ inline size_t __stl_hash_string(const char* __s)
   return size_t(__h);
 }
 
+inline size_t __stl_hash_string(const char* __s, size_t __n)
+{
+  unsigned long __h = 0;
+  for ( ; __n != 0; --__n, ++__s)
+    __h = 5*__h + *__s;
+
+  return size_t(__h);
+}
+
+// 把杂凑值打散, 供以 2 的幂次为容量, 只取低位的杂凑表使用.
+// hash<int> 等只是恒等函数, 低位往往不够随机, 所以先乘以黄金分割常数, 再把高位折回低位
+inline size_t __stl_hash_mix(size_t __h)
+{
+#if defined(__LP64__) || defined(_WIN64)
+  __h *= size_t(0x9E3779B97F4A7C15ULL);
+  return __h ^ (__h >> 32);
+#else
+  __h *= size_t(0x9E3779B9UL);
+  return __h ^ (__h >> 16);
+#endif
+}
+
+// 透明的字符串杂凑函数 (not part of the C++ standard). const char* 与任何具有
+// data()/size() 的字符串型别 (如 std::string), 内容相同时杂凑值也相同.
+// 与 equal_to<void> 合用: hash_map<std::string, T, string_hash, equal_to<void> >
+// 即可直接以 const char* 查找, 不必构造临时的 std::string
+struct string_hash
+{
+  typedef void is_transparent;
+  size_t operator()(const char* __s) const { return __stl_hash_string(__s); }
+  size_t operator()(char* __s) const { return __stl_hash_string(__s); }
+  template <class _Str>
+  size_t operator()(const _Str& __s) const
+    { return __stl_hash_string(__s.data(), __s.size()); }
+};
+
 template<> struct hash<char*>
 {
   size_t operator()(const char* __s) const { return __stl_hash_string(__s); }
@@ -27,6 +27,7 @@ public:
 
     typedef typename ht::size_type size_type;
     typedef typename ht::difference_type difference_type;
+    typedef typename ht::node_type node_type;
     typedef typename ht::pointer pointer;
     typedef typename ht::const_pointer const_pointer;
     typedef typename ht::reference reference;
@@ -66,8 +67,8 @@ public:
     void swap(hash_multimap& hs) { rep.swap(hs.rep); }
     friend bool operator== __STL_NULL_TMPL_ARGS (const hash_multimap&, const hash_multimap&);
 
-    iterator begin() const { return rep.begin(); }
-    iterator end() const { return rep.end(); }
+    iterator begin() { return rep.begin(); }
+    iterator end() { return rep.end(); }
     const_iterator begin() const { return rep.begin(); }
     const_iterator end() const { return rep.end(); }
 
@@ -75,16 +76,19 @@ public:
     iterator insert(const value_type& obj) { return rep.insert_equal(obj); }
     template <class InputIterator>
     void insert(InputIterator f, InputIterator l) { rep.insert_equal(f, l); }
+    // 批次插入: 预取 bucket 与节点, 使一组元素的内存访问重叠, 见 hashtable::find_batch
+    template <class ForwardIterator>
+    void insert_batch(ForwardIterator f, ForwardIterator l) { rep.insert_equal_batch(f, l); }
     iterator insert_noresize(const value_type& obj)
     {
         return rep.insert_equal_noresize(obj);
     }
 
-    iterator find(const key_type& key) const { return rep.find(key); }
+    iterator find(const key_type& key) { return rep.find(key); }
     const_iterator find(const key_type& key) const { return rep.find(key); }
     size_type count(const key_type& key) const { return rep.count(key); }
 
-    pair<iterator, iterator> equal_range(const key_type& key) const
+    pair<iterator, iterator> equal_range(const key_type& key)
     {
         return rep.equal_range(key);
     }
@@ -93,15 +97,61 @@ public:
         return rep.equal_range(key);
     }
 
-    size_type erase(conset key_type& key) { return rep.erase(key); }
+    // 异质查找: 仅当 HashFcn 与 EqualKey 都定义了 is_transparent 时可用, 见 stl_hashtable.h
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, iterator>::type
+    find(const KT& key) { return rep.find(key); }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, const_iterator>::type
+    find(const KT& key) const { return rep.find(key); }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, size_type>::type
+    count(const KT& key) const { return rep.count(key); }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, pair<iterator, iterator> >::type
+    equal_range(const KT& key)
+    {
+        return rep.equal_range(key);
+    }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT,
+                                   pair<const_iterator, const_iterator> >::type
+    equal_range(const KT& key) const
+    {
+        return rep.equal_range(key);
+    }
+
+    size_type erase(const key_type& key) { return rep.erase(key); }
     void erase(iterator it) { rep.erase(it); }
     void erase(iterator f, iterator l) { rep.erase(f, l); }
     void clear() { rep.clear(); }
 
+    // 节点把手: 在容器之间搬移元素, 或者修改键值后放回, 都不必配置节点或复制元素
+    node_type extract(iterator it) { return rep.extract(it); }
+    node_type extract(const key_type& key) { return rep.extract(key); }
+    iterator insert(const node_type& nh) { return rep.insert_equal(nh); }
+    void merge(hash_multimap& src) { rep.merge_equal(src.rep); }
+
 public:
-    void resize(size_type& hint) { rep.resize(hint); }
+    void resize(size_type hint) { rep.resize(hint); }
+    // 预留能容纳 n 个元素而不必重建表格的 buckets
+    void reserve(size_type n) { rep.reserve(n); }
+    // bucket 个数至少为 n 且足以容纳现有元素, 可以缩小表格
+    void rehash(size_type n) { rep.rehash(n); }
+    float load_factor() const { return rep.load_factor(); }
+    float max_load_factor() const { return rep.max_load_factor(); }
+    void max_load_factor(float z) { rep.max_load_factor(z); }
+    // 低水位: erase(key) 与范围 erase 使负载低于 z 时缩小表格, 0 表示不缩小(缺省)
+    float min_load_factor() const { return rep.min_load_factor(); }
+    void min_load_factor(float z) { rep.min_load_factor(z); }
+    // 渐进式 rehash, 每次操作搬移 n 个 bucket, 0 表示一次重建. 见 stl_hashtable.h
+    void set_incremental_rehash(size_type n) { rep.set_incremental_rehash(n); }
+    bool rehashing() const { return rep.rehashing(); }
     size_type bucket_count() const { return rep.bucket_count(); }
     size_type max_bucket_count() const { return rep.max_bucket_count(); }
+    // 健康统计, 见 hashtable::stats(). max_chains 不为 0 时只抽样走访这么多个非空串行
+    typedef typename ht::stats_type stats_type;
+    stats_type stats(size_type max_chains = 0) const { return rep.stats(max_chains); }
     size_type elems_in_bucket(size_type n) const
     {
         return rep.elems_in_bucket(n);
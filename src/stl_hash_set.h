@@ -23,6 +23,7 @@ public:
 
     typedef typename ht::size_type size_type;
     typedef typename ht::difference_type difference_type;
+    typedef typename ht::node_type node_type;
     typedef typename ht::const_pointer pointer;
     typedef typename ht::const_pointer const_pointer;
     typedef typename ht::const_reference reference;
@@ -47,20 +48,20 @@ public:
         : rep(100, hasher(), key_equal()) { rep.insert_unique(f, l); }
     template <class InputIterator>
     hash_set(InputIterator f, InputIterator l, size_type n)
-        : ht(n, hasher(), key_equal()) { ht.insert_unique(f, l); }
+        : rep(n, hasher(), key_equal()) { rep.insert_unique(f, l); }
     template <class InputIterator>
     hash_set(InputIterator f, InputIterator l, size_type n, const hasher& hf)
-        : ht(n, hf, key_equal()) { ht.insert_unique(f, l); }
+        : rep(n, hf, key_equal()) { rep.insert_unique(f, l); }
     template <class InputIterator>
     hash_set(InputIterator f, InputIterator l, size_type n,
-             const hasher& hf, const key_equal& eql,)
-        : ht(n, hf, eql, a) { ht.insert_unique(f, l); }
+             const hasher& hf, const key_equal& eql)
+        : rep(n, hf, eql) { rep.insert_unique(f, l); }
 
 public:
-    size_type size() const { return ht.size(); }
-    size_type max_size() const { return ht.max_size(); }
-    bool empty() const { return ht.empty(); }
-    void swap(hash_set& hs) { ht.swap(hs.ht); }
+    size_type size() const { return rep.size(); }
+    size_type max_size() const { return rep.max_size(); }
+    bool empty() const { return rep.empty(); }
+    void swap(hash_set& hs) { rep.swap(hs.rep); }
     friend bool operator== __STL_NULL_TMPL_ARGS (const hash_set&, const hash_set&);
 
     iterator begin() const { return rep.begin(); }
@@ -70,10 +71,13 @@ public:
     pair<iterator, bool> insert(const value_type& obj)
     {
         pair<typename ht::iterator, bool> p = rep.insert_unique(obj);
-        retrun pair<iterator, bool>(p.first, p.second);
+        return pair<iterator, bool>(p.first, p.second);
     }
     template <class InputIterator>
     void insert(InputIterator f, InputIterator l) { rep.insert_unique(f, l); }
+    // 批次插入/查找: 预取 bucket 与节点, 使一组元素的内存访问重叠, 见 hashtable::find_batch
+    template <class ForwardIterator>
+    void insert_batch(ForwardIterator f, ForwardIterator l) { rep.insert_unique_batch(f, l); }
     pair<iterator, bool> insert_noresize(const value_type& obj)
     {
         pair<typename ht::iterator, bool> p = rep.insert_unique_noresize(obj);
@@ -81,6 +85,12 @@ public:
     }
 
     iterator find(const key_type& key) const { return rep.find(key); }
+    // 依序把 [f, l) 中每个键值的 find() 结果写到 out
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator f, ForwardIterator l, OutputIterator out) const
+    {
+        return rep.find_batch(f, l, out);
+    }
 
     size_type count(const key_type& key) const { return rep.count(key); }
 
@@ -89,15 +99,55 @@ public:
         return rep.equal_range(key);
     }
 
+    // 异质查找: 仅当 HashFcn 与 EqualKey 都定义了 is_transparent 时可用, 见 stl_hashtable.h
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, iterator>::type
+    find(const KT& key) const { return rep.find(key); }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, size_type>::type
+    count(const KT& key) const { return rep.count(key); }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, pair<iterator, iterator> >::type
+    equal_range(const KT& key) const
+    {
+        return rep.equal_range(key);
+    }
+
     size_type erase(const key_type& key) { return rep.erase(key); }
     void erase(iterator it) { rep.erase(it); }
     void erase(iterator f, iterator l) { rep.erase(f, l); }
     void clear() { rep.clear(); }
 
+    // 节点把手: 在容器之间搬移元素, 或者修改键值后放回, 都不必配置节点或复制元素
+    node_type extract(iterator it) { return rep.extract(it); }
+    node_type extract(const key_type& key) { return rep.extract(key); }
+    pair<iterator, bool> insert(const node_type& nh)
+    {
+        pair<typename ht::iterator, bool> p = rep.insert_unique(nh);
+        return pair<iterator, bool>(p.first, p.second);
+    }
+    void merge(hash_set& src) { rep.merge_unique(src.rep); }
+
 public:
     void resize(size_type hint) { rep.resize(hint); }
+    // 预留能容纳 n 个元素而不必重建表格的 buckets
+    void reserve(size_type n) { rep.reserve(n); }
+    // bucket 个数至少为 n 且足以容纳现有元素, 可以缩小表格
+    void rehash(size_type n) { rep.rehash(n); }
+    float load_factor() const { return rep.load_factor(); }
+    float max_load_factor() const { return rep.max_load_factor(); }
+    void max_load_factor(float z) { rep.max_load_factor(z); }
+    // 低水位: erase(key) 与范围 erase 使负载低于 z 时缩小表格, 0 表示不缩小(缺省)
+    float min_load_factor() const { return rep.min_load_factor(); }
+    void min_load_factor(float z) { rep.min_load_factor(z); }
+    // 渐进式 rehash, 每次操作搬移 n 个 bucket, 0 表示一次重建. 见 stl_hashtable.h
+    void set_incremental_rehash(size_type n) { rep.set_incremental_rehash(n); }
+    bool rehashing() const { return rep.rehashing(); }
     size_type bucket_count() const { return rep.bucket_count(); }
     size_type max_bucket_count() const { return rep.max_bucket_count(); }
+    // 健康统计, 见 hashtable::stats(). max_chains 不为 0 时只抽样走访这么多个非空串行
+    typedef typename ht::stats_type stats_type;
+    stats_type stats(size_type max_chains = 0) const { return rep.stats(max_chains); }
     size_type elems_in_bucket(size_type n) const
     {
         return rep.elems_in_bucket(n);
@@ -106,8 +156,8 @@ public:
 
 template <class Value, class HashFcn, class EqualKey, class Alloc>
 inline bool
-operator==(const hash_set<class Value, class HashFcn, class EqualKey, class Alloc>& hs1,
-           const hash_set<class Value, class HashFcn, class EqualKey, class Alloc>& hs2)
+operator==(const hash_set<Value, HashFcn, EqualKey, Alloc>& hs1,
+           const hash_set<Value, HashFcn, EqualKey, Alloc>& hs2)
 {
     return hs1.rep == hs2.rep;
 }
@@ -2,18 +2,57 @@
 #define __STL_HASHTABLE_H
 
 #include <algorithm>
+#include <cmath>
+#include <string>
 
+#include "../src/type_traits.h"
 #include "../src/stl_iterator.h"
 #include "../src/stl_alloc.h"
 #include "../src/stl_vector.h"
 #include "../src/stl_pair.h"
+#include "../src/stl_function.h"
+#include "../src/stl_hash_fun.h"
+
+// HashFcn 与 EqualKey 都定义了 is_transparent 时, type 即为 R, 见 hashtable::find
+template <class HashFcn, class EqualKey, class K, class R, class = void>
+struct __if_transparent_hash { };
+
+template <class HashFcn, class EqualKey, class K, class R>
+struct __if_transparent_hash<HashFcn, EqualKey, K, R,
+    typename __if_transparent<HashFcn, K,
+             typename __if_transparent<EqualKey, K, void>::type>::type> {
+    typedef R type;
+};
 
-template <class Value>
+// 键值的杂凑代价高(必须走访整个键值)时, 节点中保存完整的杂凑值, 见 __hashtable_node.
+// 缺省不保存; 自定义的键值型别可以特化本模版, 令 cached 为 __true_type
+template <class Key>
+struct __hash_code_traits {
+    typedef __false_type cached;
+};
+
+template <> struct __hash_code_traits<char*> { typedef __true_type cached; };
+template <> struct __hash_code_traits<const char*> { typedef __true_type cached; };
+template <class CharT, class Traits, class A>
+struct __hash_code_traits<std::basic_string<CharT, Traits, A> > {
+    typedef __true_type cached;
+};
+
+template <class Value, class CacheHashCode = __false_type>
 struct __hashtable_node {
     __hashtable_node* next;
     Value val;
 };
 
+// 保存杂凑值的节点: 表格重建与迭代器前进时不必再调用 hash function,
+// 查找时杂凑值不同的节点直接略过, 不必比较键值
+template <class Value>
+struct __hashtable_node<Value, __true_type> {
+    __hashtable_node* next;
+    size_t hash_code;
+    Value val;
+};
+
 template <class Value, class Key, class HashFcn,
           class ExtractKey, class EqualKey, class Alloc = alloc>
 class hashtable;
@@ -36,7 +75,7 @@ struct __hashtable_iterator {
     typedef __hashtable_const_iterator<Value, Key, HashFcn,
                                        ExtractKey, EqualKey, Alloc>
         const_iterator;
-    typedef __hashtable_node<Value> node;
+    typedef __hashtable_node<Value, typename __hash_code_traits<Key>::cached> node;
 
     typedef forward_iterator_tag iterator_category;
     typedef Value value_type;
@@ -47,8 +86,15 @@ struct __hashtable_iterator {
 
     node* cur;      // 迭代器目前所指的节点
     hashtable* ht;  // 保持对容器的连结关系(因为可能需要从 bucket 跳到 bucket)
-
-    __hashtable_iterator(node* n, hashtable* tab) : cur(n), ht(tab) { }
+    // cur 所在的 bucket, 走到串行尾端时由此找下一个 bucket, 不必重新计算杂凑值.
+    // 渐进式 rehash 期间, 旧表格的 #i bucket 记为 buckets.size() + i.
+    // 由 find() 等取得的迭代器不知道所在 bucket, 记为 size_type(-1), 需要时才计算
+    size_type bucket;
+
+    __hashtable_iterator(node* n, hashtable* tab)
+        : cur(n), ht(tab), bucket(size_type(-1)) { }
+    __hashtable_iterator(node* n, hashtable* tab, size_type b)
+        : cur(n), ht(tab), bucket(b) { }
     __hashtable_iterator() { }
     reference operator*() const { return cur->val; }
     pointer operator->() const { return &(operator*()); }
@@ -65,11 +111,9 @@ __hashtable_iterator<V, K, HF, ExK, EqK, A>::operator++()
     const node* old = cur;
     cur = cur->next;        // 如果存在, 就是它. 否则进入以下 if 流程
     if (!cur) {
-        // 根据元素值, 定位出下一个 bucket. 其起头处就是我们的目的地
-        size_type bucket = ht->bkt_num(old->val);
-        while (!cur && ++bucket < ht->buckets.size()) {
-            cur = ht->buckets[bucket];
-        }
+        // 从所在 bucket 之后找出下一个非空的 bucket. 其起头处就是我们的目的地
+        bucket = ht->bucket_of(old, bucket);    // 记下的 bucket 可能已过时, 见 bucket_of()
+        cur = ht->first_chain(++bucket);
     }
     return *this;
 }
@@ -94,7 +138,7 @@ struct __hashtable_const_iterator {
   typedef __hashtable_const_iterator<Value, Key, HashFcn, 
                                      ExtractKey, EqualKey, Alloc>
           const_iterator;
-  typedef __hashtable_node<Value> node;
+  typedef __hashtable_node<Value, typename __hash_code_traits<Key>::cached> node;
 
   typedef forward_iterator_tag iterator_category;
   typedef Value value_type;
@@ -105,12 +149,15 @@ struct __hashtable_const_iterator {
 
   const node* cur;
   const hashtable* ht;
+  size_type bucket;     // 见 __hashtable_iterator::bucket
 
   __hashtable_const_iterator(const node* n, const hashtable* tab)
-    : cur(n), ht(tab) {}
+    : cur(n), ht(tab), bucket(size_type(-1)) {}
+  __hashtable_const_iterator(const node* n, const hashtable* tab, size_type b)
+    : cur(n), ht(tab), bucket(b) {}
   __hashtable_const_iterator() {}
   __hashtable_const_iterator(const iterator& it) 
-    : cur(it.cur), ht(it.ht) {}
+    : cur(it.cur), ht(it.ht), bucket(it.bucket) {}
   reference operator*() const { return cur->val; }
   pointer operator->() const { return &(operator*()); }
 
@@ -127,9 +174,8 @@ __hashtable_const_iterator<Value, Key, HF, ExK, EqK, A>::operator++()
   const node* old = cur;
   cur = cur->next;
   if (!cur) {
-    size_type bucket = ht->bkt_num(old->val);
-    while (!cur && ++bucket < ht->buckets.size())
-      cur = ht->buckets[bucket];
+    bucket = ht->bucket_of(old, bucket);
+    cur = ht->first_chain(++bucket);
   }
   return *this;
 }
@@ -143,6 +189,270 @@ __hashtable_const_iterator<Value, Key, HF, ExK, EqK, A>::operator++(int)
   return tmp;
 }
 
+// 注意: 假设 long 至少有 32 bits. size_t 为 64 bits 时再接上 32 个质数,
+// bucket 个数不再受限于 4294967291
+static const size_t __stl_prime_list[] =
+{
+    53ul,         97ul,         193ul,       389ul,       769ul,
+    1543ul,       3079ul,       6151ul,      12289ul,     24593ul,
+    49157ul,      98317ul,      196613ul,    393241ul,    786433ul,
+    1572869ul,    3145739ul,    6291469ul,   12582917ul,  25165843ul,
+    50331653ul,   100663319ul,  201326611ul, 402653189ul, 805306457ul, 
+    1610612741ul, 3221225473ul, 4294967291ul,
+#if defined(__LP64__) || defined(_WIN64)
+    size_t(6442450967ull),          size_t(12884901893ull),
+    size_t(25769803799ull),         size_t(51539607599ull),
+    size_t(103079215111ull),        size_t(206158430209ull),
+    size_t(412316860441ull),        size_t(824633720837ull),
+    size_t(1649267441681ull),       size_t(3298534883417ull),
+    size_t(6597069766657ull),       size_t(13194139533349ull),
+    size_t(26388279066671ull),      size_t(52776558133303ull),
+    size_t(105553116266509ull),     size_t(211106232533047ull),
+    size_t(422212465066001ull),     size_t(844424930132057ull),
+    size_t(1688849860263953ull),    size_t(3377699720527897ull),
+    size_t(6755399441055827ull),    size_t(13510798882111519ull),
+    size_t(27021597764223071ull),   size_t(54043195528445957ull),
+    size_t(108086391056891941ull),  size_t(216172782113783843ull),
+    size_t(432345564227567621ull),  size_t(864691128455135281ull),
+    size_t(1729382256910270481ull), size_t(3458764513820540933ull),
+    size_t(6917529027641081903ull), size_t(13835058055282163729ull)
+#endif
+};
+static const int __stl_num_primes = sizeof(__stl_prime_list) / sizeof(__stl_prime_list[0]);
+
+// 以下找出上述质数之中, 最接近并大于或等于 n 的那个质数
+inline size_t __stl_next_prime(size_t n)
+{
+  const size_t* first = __stl_prime_list;
+  const size_t* last = __stl_prime_list + (int)__stl_num_primes;
+  const size_t* pos = std::lower_bound(first, last, n);
+  // 使用 lower_bound(), 序列需先排序
+  return pos == last ? *(last - 1) : *pos;
+}
+
+// bucket 个数策略: 决定 bucket 个数, 以及杂凑值如何对应到 bucket.
+// state_type 是 n 个 buckets 之下预先算好的状态, 由 hashtable 随 bucket vector 一起保存
+#ifndef __STL_HASHTABLE_POW2_BUCKETS
+
+// 缺省: 质数个 buckets. 取余不用 20~40 cycles 的除法指令, 而是乘以预先算好的倒数
+// (Lemire 的 fastmod: M = 2^64 / d 取上整, h mod d = ((M * h) mod 2^64) * d / 2^64).
+// 这要求 h 与 d 都在 32 bits 以内, 所以先把杂凑值的高 32 bits 折进低 32 bits;
+// 超过 32 bits 的质数, 或编译器没有 128 bits 整数时, 仍然使用 %
+struct __hashtable_prime_state {
+    size_t divisor;
+    unsigned long long reciprocal;  // 0 表示使用 %
+};
+
+struct __hashtable_bucket_policy {
+    typedef __hashtable_prime_state state_type;
+
+    static size_t next_size(size_t n) { return __stl_next_prime(n); }
+    static size_t max_size() { return __stl_prime_list[__stl_num_primes - 1]; }
+    static state_type state(size_t n)
+    {
+        state_type s;
+        s.divisor = n;
+        s.reciprocal = 0;
+#if defined(__SIZEOF_INT128__)
+        if (n != 0 && n <= 0xffffffffUL) {
+            s.reciprocal = ~0ULL / n + 1;
+        }
+#endif
+        return s;
+    }
+    static size_t index(size_t h, const state_type& s)
+    {
+#if defined(__SIZEOF_INT128__)
+        if (s.reciprocal != 0) {
+            const unsigned long long x = (unsigned long long)h;
+            const unsigned long long low = s.reciprocal * (unsigned int)(x ^ (x >> 32));
+            return size_t(((unsigned __int128)low * s.divisor) >> 64);
+        }
+#endif
+        return h % s.divisor;
+    }
+};
+
+#else /* __STL_HASHTABLE_POW2_BUCKETS */
+
+// 2 的幂次个 buckets, 以 mask 取打散后杂凑值的低位, 见 __stl_hash_mix
+struct __hashtable_bucket_policy {
+    typedef size_t state_type;  // mask, 即 n - 1
+
+    static size_t next_size(size_t n)
+    {
+        size_t result = 64;
+        while (result < n && result < max_size()) {
+            result <<= 1;
+        }
+        return result;
+    }
+    static size_t max_size() { return size_t(1) << (sizeof(size_t) * 8 - 1); }
+    static state_type state(size_t n) { return n - 1; }
+    static size_t index(size_t h, state_type mask) { return __stl_hash_mix(h) & mask; }
+};
+
+#endif /* __STL_HASHTABLE_POW2_BUCKETS */
+
+inline int __stl_bucket_ctz(size_t x)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll((unsigned long long)x);
+#else
+    int n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+inline int __stl_bucket_popcount(size_t x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll((unsigned long long)x);
+#else
+    int n = 0;
+    for ( ; x != 0; x &= x - 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// 提示处理器预先把 p 所在的 cache line 载入. 只是提示, 不影响语义, p 可以为 0
+inline void __stl_prefetch(const void* p)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
+// bucket 占用位图: 每个 bucket 一个 bit, 其串行非空时为 1.
+// begin() 与迭代器前进时以 ctz 一次略过一整个 word 的空 bucket,
+// 所以走访一个大量删除后变得稀疏的表格, 代价与元素个数而不是 bucket 个数成正比
+template <class Alloc>
+class __hashtable_bucket_bitmap {
+    typedef size_t word_type;
+    enum { word_bits = sizeof(word_type) * 8 };
+
+    vector<word_type, Alloc> words;
+
+public:
+    // 改为 n 个全空的 bucket
+    void assign(size_t n)
+    {
+        vector<word_type, Alloc>((n + word_bits - 1) / word_bits, word_type(0)).swap(words);
+    }
+    void release() { vector<word_type, Alloc>().swap(words); }
+    void swap(__hashtable_bucket_bitmap& x) { words.swap(x.words); }
+
+    void set(size_t i) { words[i / word_bits] |= word_type(1) << (i % word_bits); }
+    void reset(size_t i) { words[i / word_bits] &= ~(word_type(1) << (i % word_bits)); }
+
+    // 不小于 i 的第一个非空 bucket, 没有时返回 n(bucket 个数)
+    size_t find_next(size_t i, size_t n) const
+    {
+        if (i >= n) {
+            return n;
+        }
+        size_t w = i / word_bits;
+        word_type bits = words[w] & (~word_type(0) << (i % word_bits));
+        while (bits == 0) {
+            if (++w == words.size()) {
+                return n;
+            }
+            bits = words[w];
+        }
+        return w * word_bits + __stl_bucket_ctz(bits);
+    }
+
+    // 非空 bucket 的个数
+    size_t count() const
+    {
+        size_t n = 0;
+        for (size_t w = 0; w < words.size(); ++w) {
+            n += __stl_bucket_popcount(words[w]);
+        }
+        return n;
+    }
+    size_t bytes() const { return words.capacity() * sizeof(word_type); }
+};
+
+// hashtable::stats() 的结果
+struct __hashtable_stats {
+    enum { histogram_size = 8 };
+
+    size_t elements;
+    size_t bucket_count;        // 渐进式 rehash 期间包括旧表格
+    size_t empty_buckets;
+    float load_factor;          // 同 hashtable::load_factor()
+    float empty_ratio;          // empty_buckets / bucket_count
+    size_t longest_chain;
+    // histogram[i] 为长度 i 的串行个数, 最后一格计入所有更长的串行. histogram[0] 即空 bucket 个数
+    size_t histogram[histogram_size];
+    size_t chains_examined;     // 实际走访过的非空串行个数
+    size_t bucket_bytes;        // buckets 数组与占用位图
+    size_t node_bytes;
+    size_t grow_count;          // 表格扩大的次数
+    size_t shrink_count;        // 表格缩小的次数
+};
+
+// 节点把手(node handle), 由 hashtable::extract() 返回
+// 它拥有一个已从表格中摘下的节点: 可以修改其键值, 再以 insert 放回同一个或另一个表格,
+// 全程不配置也不释放节点, 元素也不被复制. 把手被销毁时若仍拥有节点, 才析构并释放之.
+// 与 rb_tree 的节点把手相同, 复制把手即转移所有权
+template <class Value, class Key, class ExtractKey, class Alloc>
+class __hashtable_node_handle {
+    template <class V, class K, class HF, class ExK, class EqK, class A> friend class hashtable;
+
+    typedef __hashtable_node<Value, typename __hash_code_traits<Key>::cached> node;
+    typedef simple_alloc<node, Alloc> node_allocator;
+
+    mutable node* cur;
+
+    explicit __hashtable_node_handle(node* n) : cur(n) { }
+    node* release() const
+    {
+        node* n = cur;
+        cur = 0;
+        return n;
+    }
+
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+
+    __hashtable_node_handle() : cur(0) { }
+    __hashtable_node_handle(const __hashtable_node_handle& x) : cur(x.release()) { }
+    __hashtable_node_handle& operator=(const __hashtable_node_handle& x)
+    {
+        if (&x != this) {
+            clear();
+            cur = x.release();
+        }
+        return *this;
+    }
+    ~__hashtable_node_handle() { clear(); }
+
+    bool empty() const { return cur == 0; }
+    value_type& value() const { return cur->val; }
+    key_type& key() const { return const_cast<key_type&>(ExtractKey()(cur->val)); }
+    void swap(__hashtable_node_handle& x) { std::swap(cur, x.cur); }
+
+    void clear()
+    {
+        if (cur != 0) {
+            destory(&cur->val);
+            node_allocator::deallocate(cur);
+            cur = 0;
+        }
+    }
+};
+
 // hashtable 的模版参数
 // Value: 节点的实值型别
 // Key: 节点的键值型别
@@ -153,6 +463,8 @@ __hashtable_const_iterator<Value, Key, HF, ExK, EqK, A>::operator++(int)
 template <class Value, class Key, class HashFcn,
           class ExtractKey, class EqualKey, class Alloc>
 class hashtable {
+    friend struct __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
+    friend struct __hashtable_const_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
 public:
     typedef Key key_type;
     typedef Value value_type;
@@ -164,6 +476,7 @@ public:
     typedef HashFcn           hasher;        // 为 template 型别参数重新定义一个别称
     typedef EqualKey          key_equal;     // 为 template 型别参数重新定义一个别称
     typedef size_t            size_type;
+    typedef __hashtable_node_handle<Value, Key, ExtractKey, Alloc> node_type;
 
     hasher hash_funct() const { return hash; }
     key_equal key_eq() const { return equals; }
@@ -175,11 +488,29 @@ private:
     key_equal equals;
     ExtractKey get_key;
 
-    typedef __hashtable_node<Value> node;
+    typedef typename __hash_code_traits<Key>::cached cache_hash_code;
+    typedef __hashtable_node<Value, cache_hash_code> node;
     typedef simple_alloc<node, Alloc> node_allocator;
+    typedef __hashtable_bucket_policy bucket_policy;
+    typedef bucket_policy::state_type bucket_state_type;
 
     vector<node*, Alloc> buckets;
     size_type num_elements;
+    bucket_state_type bucket_state;     // buckets.size() 之下的取 bucket 状态, 见 bucket_policy
+    __hashtable_bucket_bitmap<Alloc> occupied;  // buckets 的占用位图
+
+    // 渐进式 rehash(见 set_incremental_rehash()). 搬移期间 buckets 为新表格,
+    // old_buckets 为旧表格, 其中 [0, rehash_index) 已搬空; 不在搬移时 old_buckets 为空
+    vector<node*, Alloc> old_buckets;
+    size_type rehash_index;
+    size_type rehash_step_buckets;  // 每次操作搬移的 bucket 个数, 0 表示一次重建完毕(缺省)
+    bucket_state_type old_bucket_state;
+    __hashtable_bucket_bitmap<Alloc> old_occupied;
+
+    float max_load;     // 元素个数超过 bucket 个数乘以此值时扩大表格(缺省 1.0)
+    float min_load;     // 低水位: 删除后负载低于此值时缩小表格, 0 表示从不缩小(缺省)
+    size_type num_grows;    // 表格扩大与缩小的次数, 见 stats()
+    size_type num_shrinks;
 
 public:
   typedef __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>
@@ -190,7 +521,9 @@ public:
 
 public:
     hashtable(size_type n, const HashFcn& hf, const EqualKey& eql)
-        : hash(hf), equals(eql), get_key(ExtractKey()), num_elements(0)
+        : hash(hf), equals(eql), get_key(ExtractKey()), num_elements(0), bucket_state(),
+          rehash_index(0), rehash_step_buckets(0), old_bucket_state(),
+          max_load(1.0f), min_load(0.0f), num_grows(0), num_shrinks(0)
     {
         initialize_buckets(n);
     }
@@ -207,39 +540,54 @@ public:
         std::swap(get_key, ht.get_key);
         buckets.swap(ht.buckets);
         std::swap(num_elements, ht.num_elements);
+        std::swap(bucket_state, ht.bucket_state);
+        occupied.swap(ht.occupied);
+        old_buckets.swap(ht.old_buckets);
+        std::swap(old_bucket_state, ht.old_bucket_state);
+        old_occupied.swap(ht.old_occupied);
+        std::swap(rehash_index, ht.rehash_index);
+        std::swap(rehash_step_buckets, ht.rehash_step_buckets);
+        std::swap(max_load, ht.max_load);
+        std::swap(min_load, ht.min_load);
+        std::swap(num_grows, ht.num_grows);
+        std::swap(num_shrinks, ht.num_shrinks);
     }
 
+    // 迭代顺序: 先是新表格的各个 bucket, 搬移期间再接着旧表格中尚未搬移的部分
     iterator begin()
-    { 
-        for (size_type n = 0; n < buckets.size(); ++n) {
-            if (buckets[n]) {
-                return iterator(buckets[n], this);
-            }
-        }
-        return end();
+    {
+        size_type b = 0;
+        node* first = first_chain(b);
+        return iterator(first, this, b);
     }
 
     iterator end() { return iterator(0, this); }
 
     const_iterator begin() const
     {
-        for (size_type n = 0; n < buckets.size(); ++n) {
-            if (buckets[n]) {
-                return const_iterator(buckets[n], this);
-            }
-        }
-        return end();
+        size_type b = 0;
+        const node* first = first_chain(b);
+        return const_iterator(first, this, b);
     }
 
     const_iterator end() const { return const_iterator(0, this); }
 
 public:
-    // bucket 个数即 buckets vector 的大小
+    // bucket 个数即 buckets vector 的大小. 渐进式 rehash 期间指的是新表格
     size_type bucket_count() const { return buckets.size(); }
 
     // 总共可以有多少 buckets
     size_type max_bucket_count() const
-        { return __stl_prime_list[__stl_num_primes - 1]; }
+        { return bucket_policy::max_size(); }
+
+    // 健康统计: 负载, 最长串行, 串行长度直方图, 空 bucket 比例, 内存用量与重建次数.
+    // 以占用位图略过空 bucket, 代价为 O(size() + bucket_count() / 64).
+    // max_chains 不为 0 时只均匀抽样走访至多这么多个非空串行, 其余节点完全不碰, 适合
+    // 线上定期取样; 此时最长串行与直方图(histogram[0] 除外)只依据被抽中的串行.
+    // 杂凑函数与键值不配(例如恒等的 hash<int> 遇上等距的键值)时, 最长串行与直方图的
+    // 尾部会明显偏大, 空 bucket 比例也远高于负载所应有的 e^(-load_factor)
+    typedef __hashtable_stats stats_type;
+    stats_type stats(size_type max_chains = 0) const;
 
     size_type elems_in_bucket(size_type bucket) const
     {
@@ -259,6 +607,7 @@ public:
     // 插入元素, 不允许重复
     pair<iterator, bool> insert_unique(const value_type& obj)
     {
+        rehash_step();
         resize(num_elements + 1);
         return insert_unique_noresize(obj);
     }
@@ -269,9 +618,18 @@ public:
         insert_unique(f, l, iterator_category(f));
     }
 
+    template <class InputIterator>
+    void insert_unique(InputIterator f, InputIterator l, input_iterator_tag)
+    {
+        for ( ; f != l; ++f) {
+            insert_unique(*f);
+        }
+    }
+
     // 插入元素, 允许重复
     iterator insert_equal(const value_type& obj)
     {
+        rehash_step();
         resize(num_elements + 1);   // 判断是否需要重建表格, 如需要就扩充
         return insert_equal_noresize(obj);
     }
@@ -290,48 +648,140 @@ public:
         }
     }
 
+    // 批次插入. 每 batch_size 个元素一组: 先扩大表格并算出全部杂凑值, 预取(prefetch)
+    // 它们的 bucket, 再预取各串行的第一个节点, 最后才逐一插入, 见 find_batch()
+    template <class ForwardIterator>
+    void insert_unique_batch(ForwardIterator first, ForwardIterator last)
+    {
+        __insert_batch(first, last, true);
+    }
+    template <class ForwardIterator>
+    void insert_equal_batch(ForwardIterator first, ForwardIterator last)
+    {
+        __insert_batch(first, last, false);
+    }
+
     // 判断是否需要重建表格. 如果不需要, 立即返回. 如果需要, 则进一步处理
     void resize(size_type num_elements_hint);
 
-    reference find_or_insert(const value_type& obj);
+    // 预留能容纳 n 个元素而不必重建表格的 buckets
+    void reserve(size_type n) { resize(n); }
+    // 令 bucket 个数至少为 n, 又足以容纳现有元素而不超过最大负载.
+    // 可以比现在少, 例如大量删除之后以 rehash(0) 缩小表格, 归还内存
+    void rehash(size_type n);
 
-    iterator find(const key_type& key) 
+    // 负载: 平均每个 bucket 的元素个数
+    float load_factor() const
     {
-        size_type n = bkt_num_key(key);
-        node* first;
-        for ( first = buckets[n];
-            first && !equals(get_key(first->val), key);
-            first = first->next)
-        {}
-        return iterator(first, this);
-    } 
+        return buckets.empty() ? 0.0f : float(num_elements) / float(buckets.size());
+    }
+    float max_load_factor() const { return max_load; }
+    // 设定最大负载(必须大于 0). 现有元素因此超过时立即扩大表格
+    void max_load_factor(float z)
+    {
+        max_load = z;
+        resize(num_elements);
+    }
+    float min_load_factor() const { return min_load; }
+    // 设定低水位. 之后 erase(key) 与范围 erase 若使负载低于 z, 就把表格缩小到负载约为
+    // 最大负载的一半; z 应明显小于最大负载的一半, 否则缩小之后很快又要扩大.
+    // 缩小与扩大一样会使迭代器失效; erase(iterator) 不缩小, 所以边走访边删除仍然安全.
+    // clear() 也不缩小, 之后可以 rehash(0)
+    void min_load_factor(float z)
+    {
+        min_load = z;
+        shrink_if_sparse();
+    }
 
-    const_iterator find(const key_type& key) const
+    // 渐进式 rehash. n > 0 时, 表格需要扩大的那一次插入只配置新的 buckets, 不搬移节点;
+    // 之后每次 insert(包括 operator[]) 与 erase(key) 顺带把旧表格的 n 个 bucket 搬到新表格,
+    // 把一次 O(size()) 的停顿分摊到后续操作上. 搬移期间查找两个表格都要看.
+    // 键值相同的元素总在同一个表格中: 插入前先把该键值所在的旧 bucket 整个搬走.
+    // 搬移与一次重建相同, 会使迭代器失效. 只有修改容器的操作才搬移: find, count,
+    // equal_range 与 find_batch 从不搬移, 边走访边查找不会漏掉或重复元素;
+    // erase(iterator) 也不搬移, 所以边走访边以迭代器删除仍然安全.
+    // n 为 0 时(缺省)恢复一次重建, 进行中的搬移立即完成
+    void set_incremental_rehash(size_type n)
     {
-        size_type n = bkt_num_key(key);
-        const node* first;
-        for ( first = buckets[n];
-            first && !equals(get_key(first->val), key);
-            first = first->next)
-        {}
-        return const_iterator(first, this);
-    } 
+        rehash_step_buckets = n;
+        if (n == 0) {
+            finish_rehash();
+        }
+    }
+    bool rehashing() const { return !old_buckets.empty(); }
+
+    reference find_or_insert(const value_type& obj);
 
-    size_type count(const key_type& key) const
+    iterator find(const key_type& key)
     {
-        const size_type n = bkt_num_key(key);
-        size_type result = 0;
+        return iterator(__find_node(key), this);
+    }
+    const_iterator find(const key_type& key) const
+    {
+        return const_iterator(__find_node(key), this);
+    }
+    size_type count(const key_type& key) const { return __count(key); }
+
+    // 批次查找: 依序把 [first, last) 中每个键值的 find() 结果写到 out, 返回 out 的尾端.
+    // 逐一 find() 时, 每次查找都要先等 bucket 载入, 再等节点载入. 这里每 batch_size 个
+    // 键值一组: 先算出全部杂凑值并预取它们的 bucket, 再预取各串行的第一个节点,
+    // 最后才比较键值, 一组的内存访问因而得以重叠. 表格远大于 cache 时效果最明显.
+    // 与 find() 相同, 渐进式 rehash 期间不做搬移, 先写出的迭代器一直有效
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out)
+    {
+        return __find_batch(first, last, out, (iterator*)0);
+    }
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last,
+                              OutputIterator out) const
+    {
+        return __find_batch(first, last, out, (const_iterator*)0);
+    }
 
-        for (const node* cur = buckets[n]; cur; cur = cur->next) {
-            if (equals(get_key(cur->val), key)) {
-                ++result;
-            }
-        }
-        return result;
+    pair<iterator, iterator> equal_range(const key_type& key)
+    {
+        pair<node*, node*> p = __equal_range(key);
+        return pair<iterator, iterator>(iterator(p.first, this), iterator(p.second, this));
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+    {
+        pair<node*, node*> p = __equal_range(key);
+        return pair<const_iterator, const_iterator>(const_iterator(p.first, this),
+                                                    const_iterator(p.second, this));
     }
 
-    pair<iterator, iterator> equal_range(const key_type& key);
-    pair<const_iterator, const_iterator> equal_range(const key_type& key) const;
+    // 异质查找: HashFcn 与 EqualKey 都定义了 is_transparent 时, 可以任何能计算杂凑值,
+    // 又能与 key_type 比较相等的型别查找, 不必先构造出一个 key_type.
+    // 两者必须对 "相等" 的键值算出相同的杂凑值, 例如 const char* 与 std::string, 见 string_hash
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, iterator>::type
+    find(const KT& key)
+    {
+        return iterator(__find_node(key), this);
+    }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, const_iterator>::type
+    find(const KT& key) const { return const_iterator(__find_node(key), this); }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, size_type>::type
+    count(const KT& key) const { return __count(key); }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT, pair<iterator, iterator> >::type
+    equal_range(const KT& key)
+    {
+        pair<node*, node*> p = __equal_range(key);
+        return pair<iterator, iterator>(iterator(p.first, this), iterator(p.second, this));
+    }
+    template <class KT>
+    typename __if_transparent_hash<HashFcn, EqualKey, KT,
+                                   pair<const_iterator, const_iterator> >::type
+    equal_range(const KT& key) const
+    {
+        pair<node*, node*> p = __equal_range(key);
+        return pair<const_iterator, const_iterator>(const_iterator(p.first, this),
+                                                    const_iterator(p.second, this));
+    }
 
     size_type erase(const key_type& key);
     void erase(const iterator& it);
@@ -341,25 +791,111 @@ public:
 
     void clear();
 
-private:
-    size_type bkt_num_key(const key_type& key) const
+    // 节点把手. extract() 摘下节点交给把手; 键值不存在时返回空把手.
+    // 以把手插入时不配置节点. insert_unique(nh) 若键值重复, 节点仍留在 nh 中
+    node_type extract(const iterator& it) { return node_type(unlink_node(it.cur, it.bucket)); }
+    node_type extract(const const_iterator& it)
     {
-        return bkt_num_key(key, buckets.size());
+        return node_type(unlink_node(const_cast<node*>(it.cur), it.bucket));
     }
+    node_type extract(const key_type& key) { return extract(find(key)); }
+    pair<iterator, bool> insert_unique(const node_type& nh);
+    iterator insert_equal(const node_type& nh);
+
+    // 把 src 的节点直接移到 *this, 不配置也不复制. merge_unique() 会把与 *this 键值
+    // 重复的节点留在 src 中. 注意迭代器记录着所属的表格, 所以指向被移走节点的迭代器失效
+    void merge_unique(hashtable& src);
+    void merge_equal(hashtable& src);
 
-    size_type bkt_num(const value_type& obj) const
+private:
+    // 查找的本体. KT 可以是 key_type, 也可以是透明的 HashFcn/EqualKey 所能接受的其他型别
+    // 搬移期间两个表格都要查找, 杂凑值只计算一次
+    template <class KT>
+    node* __find_node(const KT& key) const { return __find_node(key, hash(key)); }
+    template <class KT>
+    node* __find_node(const KT& key, size_type h) const
     {
-        return bkt_num_key(get_key(obj));
+        node* first = __find_node(false, h, key);
+        if (!first && rehashing()) {
+            first = __find_node(true, h, key);
+        }
+        return first;
     }
-
-    size_type bkt_num_key(const key_type& key, size_t n) const
+    template <class KT>
+    node* __find_node(bool in_old, size_type h, const KT& key) const
+    {
+        node* first;
+        for (first = in_old ? old_buckets[old_bkt_index(h)] : buckets[bkt_index(h)];
+             first && !node_equals(first, h, key);
+             first = first->next)
+        {}
+        return first;
+    }
+    template <class KT>
+    size_type __count(const KT& key) const
+    {
+        const size_type h = hash(key);
+        size_type result = __count(false, h, key);
+        if (result == 0 && rehashing()) {
+            result = __count(true, h, key);
+        }
+        return result;
+    }
+    template <class KT>
+    size_type __count(bool in_old, size_type h, const KT& key) const
     {
-        return hash(key) % n;
+        size_type result = 0;
+        const node* cur = in_old ? old_buckets[old_bkt_index(h)] : buckets[bkt_index(h)];
+        for ( ; cur; cur = cur->next) {
+            if (node_equals(cur, h, key)) {
+                ++result;
+            }
+        }
+        return result;
+    }
+    // 返回 [first, last) 两个节点, last 为 0 表示 end()
+    template <class KT>
+    pair<node*, node*> __equal_range(const KT& key) const;
+
+    enum { batch_size = 16 };   // 批次操作每组的元素个数, 即同时在途的内存访问个数
+    template <class ForwardIterator, class OutputIterator, class Iterator>
+    OutputIterator __find_batch(ForwardIterator first, ForwardIterator last,
+                                OutputIterator out, Iterator*) const;
+    template <class ForwardIterator>
+    void __insert_batch(ForwardIterator first, ForwardIterator last, bool unique);
+    pair<iterator, bool> insert_unique_noresize(const value_type& obj, size_type h);
+
+    // 杂凑值 h 落在新表格(old_bkt_index: 旧表格)的哪一个 bucket
+    size_type bkt_index(size_type h) const { return bucket_policy::index(h, bucket_state); }
+    size_type old_bkt_index(size_type h) const
+    {
+        return bucket_policy::index(h, old_bucket_state);
     }
 
-    size_type bkt_num(const value_type& obj, size_t n) const
+    // 节点的杂凑值: 节点保存有杂凑值时直接取用, 否则重新计算
+    size_type node_hash(const node* p) const { return node_hash(p, cache_hash_code()); }
+    size_type node_hash(const node* p, __true_type) const { return p->hash_code; }
+    size_type node_hash(const node* p, __false_type) const { return hash(get_key(p->val)); }
+
+    void set_node_hash(node* p, size_type h) { set_node_hash(p, h, cache_hash_code()); }
+    void set_node_hash(node* p, size_type h, __true_type) { p->hash_code = h; }
+    void set_node_hash(node*, size_type, __false_type) { }
+
+    // 节点 p 的键值是否等于 key(其杂凑值为 h). 节点保存有杂凑值时, 杂凑值不同就不必比较键值
+    template <class KT>
+    bool node_equals(const node* p, size_type h, const KT& key) const
+    {
+        return node_equals(p, h, key, cache_hash_code());
+    }
+    template <class KT>
+    bool node_equals(const node* p, size_type h, const KT& key, __true_type) const
+    {
+        return p->hash_code == h && equals(get_key(p->val), key);
+    }
+    template <class KT>
+    bool node_equals(const node* p, size_type, const KT& key, __false_type) const
     {
-        return bkt_num_key(get_key(obj), n);
+        return equals(get_key(p->val), key);
     }
 
     node* new_node(const value_type& obj)
@@ -373,23 +909,153 @@ private:
         __STL_UNWIND(node_allocator::deallocate(n));
     }
 
+    node* new_node(const value_type& obj, size_type h)
+    {
+        node* n = new_node(obj);
+        set_node_hash(n, h);
+        return n;
+    }
+
+    // 复制节点, 连同保存的杂凑值
+    node* clone_node(const node* p) { return clone_node(p, cache_hash_code()); }
+    node* clone_node(const node* p, __true_type) { return new_node(p->val, p->hash_code); }
+    node* clone_node(const node* p, __false_type) { return new_node(p->val); }
+
     void delete_node(node* n)
     {
         destory(&n->val);
         node_allocator::deallocate(n);
     }
 
+    // 把节点 p 从其 bucket 串行中摘下, 但不析构也不释放. p 为 0 时返回 0
+    // b 为 p 所在的 bucket(见 __hashtable_iterator::bucket), 不知道时由 p 的杂凑值定位
+    node* unlink_node(node* p, size_type b = size_type(-1));
+    node* unlink_node(node*& head, node* p);
+    // 把 p 从 bucket b(须为现存的 bucket) 的串行中摘下, 并维护占用位图. 不在其中时返回 false
+    bool unlink_from_bucket(size_type b, node* p);
+    // 将节点 tmp(其杂凑值为 h) 串接到适当的 bucket 中:
+    // 有相同键值的节点时放在其后, 否则放在串行头部
+    iterator link_equal_noresize(node* tmp, size_type h);
+
     void initialize_buckets(size_type n)
     {
         const size_type n_buckets = next_size(n);
         // 举例: 传入 50, 返回 53. 以下首先保留 53 个元素空间, 然后将其全部填 0
         buckets.reserve(n_buckets);
         buckets.insert(buckets.end(), n_buckets, (node*)0);
+        bucket_state = bucket_policy::state(n_buckets);
+        occupied.assign(n_buckets);
         num_elements = 0;
     }
 
-    // 返回最接近 n 并大于或等于 n 的质数
-    size_type next_size(size_type n) const { return __stl_next_prime(n); }
+    // 依 table 的内容重建其占用位图
+    static void build_bitmap(__hashtable_bucket_bitmap<Alloc>& bits,
+                             const vector<node*, Alloc>& table)
+    {
+        bits.assign(table.size());
+        for (size_type i = 0; i < table.size(); ++i) {
+            if (table[i]) {
+                bits.set(i);
+            }
+        }
+    }
+
+    // 返回不小于 n 的下一个 bucket 个数: 缺省为质数, 见 __hashtable_bucket_policy
+    size_type next_size(size_type n) const { return bucket_policy::next_size(n); }
+    // 容纳 n 个元素而不超过最大负载所需的 bucket 个数
+    size_type buckets_for(size_type n) const
+    {
+        return size_type(std::ceil(double(n) / max_load));
+    }
+    // 把所有节点搬到 n 个 buckets 的新表格(可大可小)
+    void rehash_to(size_type n);
+    // 每隔 step 个非空串行走访一个, 计入 s. skip 为跨表格延续的计数
+    void collect_chains(stats_type& s, const vector<node*, Alloc>& table,
+                        const __hashtable_bucket_bitmap<Alloc>& bits,
+                        size_type step, size_type& skip) const;
+    void shrink_if_sparse();
+
+    // 从 bucket b 开始(编号方式见 __hashtable_iterator::bucket), 按迭代顺序找出第一个
+    // 非空串行, 返回其头部并令 b 为其 bucket. 找不到时返回 0
+    node* first_chain(size_type& b) const
+    {
+        const size_type n = buckets.size();
+        if (b < n) {
+            b = occupied.find_next(b, n);
+            if (b < n) {
+                return buckets[b];
+            }
+            b = n + rehash_index;   // 接着走访旧表格中尚未搬移的部分
+        }
+        const size_type i = old_occupied.find_next(b - n, old_buckets.size());
+        b = n + i;
+        return i < old_buckets.size() ? old_buckets[i] : 0;
+    }
+
+    // 节点 p 所在的 bucket(编号方式同上)
+    size_type bucket_of(const node* p) const
+    {
+        const size_type h = node_hash(p);
+        if (rehashing()) {
+            const size_type n = old_bkt_index(h);
+            for (const node* cur = old_buckets[n]; cur; cur = cur->next) {
+                if (cur == p) {
+                    return buckets.size() + n;
+                }
+            }
+        }
+        return bkt_index(h);
+    }
+    // 同上, b 为迭代器记下的 bucket, 只作为提示: 渐进式 rehash 期间它所指的旧 bucket
+    // 可能已被搬空, 旧表格也可能已经释放. b 仍然有效且 p 确实在其中时才采用, 否则重新定位.
+    // 不在搬移时新表格的 bucket 不会过时(重建表格会使迭代器失效), 不必检查
+    size_type bucket_of(const node* p, size_type b) const
+    {
+        if (live_bucket(b) && (!rehashing() || chain_contains(b, p))) {
+            return b;
+        }
+        return bucket_of(p);
+    }
+    // b 是否为现存的 bucket: 新表格, 或旧表格中尚未搬移的部分
+    bool live_bucket(size_type b) const
+    {
+        const size_type n = buckets.size();
+        return b < n || (b - n >= rehash_index && b - n < old_buckets.size());
+    }
+    bool chain_contains(size_type b, const node* p) const
+    {
+        const size_type n = buckets.size();
+        for (const node* cur = b < n ? buckets[b] : old_buckets[b - n]; cur; cur = cur->next) {
+            if (cur == p) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 把旧表格的 #n bucket 整个搬到新表格
+    void rehash_bucket(size_type n);
+    // 搬移至多 n 个非空的旧 bucket, 全部搬完时释放旧表格
+    void rehash_some(size_type n);
+    void rehash_step()
+    {
+        if (rehashing()) {
+            rehash_some(rehash_step_buckets);
+        }
+    }
+    void finish_rehash()
+    {
+        if (rehashing()) {
+            rehash_some(old_buckets.size());
+        }
+    }
+    // 插入前调用: 把杂凑值为 h 的键值所在的旧 bucket 先搬走, 使相同键值的元素不致分居两个表格
+    void rehash_for(size_type h)
+    {
+        if (rehashing()) {
+            rehash_bucket(old_bkt_index(h));
+        }
+    }
 
     void erase_bucket(const size_type n, node* first, node* last);
     void erase_bucket(const size_type n, node* last);
@@ -397,61 +1063,195 @@ private:
     void copy_from(const hashtable& ht);
 };
 
-// 注意: 假设 long 至少有 32 bits
-static const int __stl_num_primes = 28;
-static const unsigned long __stl_prime_list[__stl_num_primes] =
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void hashtable<V, K, HF, Ex, Eq, A>::resize(size_type num_elements_hint)
 {
-    53ul,         97ul,         193ul,       389ul,       769ul,
-    1543ul,       3079ul,       6151ul,      12289ul,     24593ul,
-    49157ul,      98317ul,      196613ul,    393241ul,    786433ul,
-    1572869ul,    3145739ul,    6291469ul,   12582917ul,  25165843ul,
-    50331653ul,   100663319ul,  201326611ul, 402653189ul, 805306457ul, 
-    1610612741ul, 3221225473ul, 4294967291ul
-};
+    // 以下, "表格重建与否" 的原则, 是拿元素个数(把新增元素计入后)和 bucket vector 的大小
+    // 乘以最大负载来比. 如果前者大于后者, 就重建表格
+    // 由此可知, 缺省(最大负载 1.0)时每个 bucket(list) 的最大容量和 buckets vector 的大小相同
+    const size_type old_n = buckets.size();
+    if (double(num_elements_hint) > double(old_n) * max_load) {     // 确定真的需要重新配置
+        // 找出下一个 bucket 个数(缺省为质数)
+        const size_type n = next_size(buckets_for(num_elements_hint));
+        if (n > old_n) {
+            rehash_to(n);
+        }
+    }
+}
 
-// 以下找出上述 28 个质数之中, 最接近并大于或等于 n 的那个质数
-inline unsigned long __stl_next_prime(unsigned long n)
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void hashtable<V, K, HF, Ex, Eq, A>::rehash(size_type n)
 {
-  const unsigned long* first = __stl_prime_list;
-  const unsigned long* last = __stl_prime_list + (int)__stl_num_primes;
-  const unsigned long* pos = std::lower_bound(first, last, n);
-  // 使用 lower_bound(), 序列需先排序
-  return pos == last ? *(last - 1) : *pos;
+    const size_type need = buckets_for(num_elements);
+    const size_type target = next_size(n > need ? n : need);
+    if (target != buckets.size()) {
+        rehash_to(target);
+    }
 }
 
+// 负载低于低水位时, 缩小到负载约为最大负载的一半
 template <class V, class K, class HF, class Ex, class Eq, class A>
-void hashtable<V, K, HF, Ex, Eq, A>::resize(size_type num_elements_hint)
+void hashtable<V, K, HF, Ex, Eq, A>::shrink_if_sparse()
+{
+    if (min_load > 0 && double(num_elements) < double(buckets.size()) * min_load) {
+        const size_type n = next_size(buckets_for(num_elements * 2));
+        if (n < buckets.size()) {
+            rehash_to(n);
+        }
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void hashtable<V, K, HF, Ex, Eq, A>::rehash_to(size_type n)
 {
-    // 以下, "表格重建与否" 的原则, 是拿元素个数(把新增元素计入后)和 bucket vector 的大小来比.
-    // 如果前者大于后者, 就重建表格
-    // 由此可知, 每个 bucket(list) 的最大容量和 buckets vector 的大小相同
     const size_type old_n = buckets.size();
-    if (num_elements_hint > old_n) {    // 确定真的需要重新配置
-        const size_type n = next_size(num_elements_hint);   // 找出下一个质数
-        if (n > old_n) {
-            vector<node*, A> tmp(n, (node*)0);  // 设立新的 buckets
-            __STL_TRY {
-                // 以下处理每一个旧的 bucket
-                for (size_type bucket = 0; bucket < old_n; ++bucket) {
-                    node* first = buckets[bucket];  // 指向节点所对应的串行的起始节点
-                    // 以下处理每一个旧 bucket 所含(串行)的每一个节点
-                    while (first) {     // 串行还没结束时
-                        // 以下找出节点落在哪一个新 bucket 内
-                        size_type new_bucket = bkt_num(first->val, n);
-                        // (1) 令旧 bucket 指向其所对应的串行的下一个节点(以便迭代处理)
-                        buckets[bucket] = first->next;
-                        // (2) (3)将当前节点插入到新 bucket 内, 成为其对应串行的第一个节点
-                        first->next = tmp[new_bucket];
-                        tmp[new_bucket] = first;
-                        // (4) 回到旧 bucket 所指的待处理串行, 准备处理下一个节点
-                        first = buckets[bucket];
-                    }
-                }
-                buckets.swap(tmp);  // vector::swap 新旧两个 buckets 对调
-                // 注意, 对调两方如果大小不同, 大的会变小, 小的会变大
-                // 离开时释放 local tmp的内存
+    if (n > old_n) {
+        ++num_grows;
+    } else if (n < old_n) {
+        ++num_shrinks;
+    }
+    // 渐进式 rehash: 上一次搬移尚未完成就又要重建时, 先把它做完(通常不会发生,
+    // 因为元素个数增加一倍所需的插入次数, 远多于搬完旧表格所需的操作次数)
+    finish_rehash();
+    vector<node*, A> tmp(n, (node*)0);  // 设立新的 buckets
+    __hashtable_bucket_bitmap<A> tmp_occupied;
+    tmp_occupied.assign(n);
+    const bucket_state_type state = bucket_policy::state(n);
+    if (rehash_step_buckets != 0) {
+        // 只换上新表格, 节点留在旧表格中由后续操作逐步搬移
+        old_buckets.swap(buckets);
+        old_bucket_state = bucket_state;
+        old_occupied.swap(occupied);
+        buckets.swap(tmp);
+        bucket_state = state;
+        occupied.swap(tmp_occupied);
+        rehash_index = 0;
+        return;
+    }
+    __STL_TRY {
+        // 以下处理每一个旧的 bucket
+        for (size_type bucket = 0; bucket < old_n; ++bucket) {
+            node* first = buckets[bucket];  // 指向节点所对应的串行的起始节点
+            // 以下处理每一个旧 bucket 所含(串行)的每一个节点
+            while (first) {     // 串行还没结束时
+                // 以下找出节点落在哪一个新 bucket 内
+                size_type new_bucket = bucket_policy::index(node_hash(first), state);
+                // (1) 令旧 bucket 指向其所对应的串行的下一个节点(以便迭代处理)
+                buckets[bucket] = first->next;
+                // (2) (3)将当前节点插入到新 bucket 内, 成为其对应串行的第一个节点
+                first->next = tmp[new_bucket];
+                tmp[new_bucket] = first;
+                tmp_occupied.set(new_bucket);
+                // (4) 回到旧 bucket 所指的待处理串行, 准备处理下一个节点
+                first = buckets[bucket];
+            }
+        }
+        buckets.swap(tmp);  // vector::swap 新旧两个 buckets 对调
+        bucket_state = state;
+        occupied.swap(tmp_occupied);
+        // 注意, 对调两方如果大小不同, 大的会变小, 小的会变大
+        // 离开时释放 local tmp的内存
+    }
+    // hash function 抛出异常时, 已经移入新 buckets 的节点只能释放掉
+    __STL_CATCH_ALL {
+        for (size_type bucket = 0; bucket < tmp.size(); ++bucket) {
+            while (tmp[bucket]) {
+                node* next = tmp[bucket]->next;
+                delete_node(tmp[bucket]);
+                --num_elements;
+                tmp[bucket] = next;
             }
         }
+        build_bitmap(occupied, buckets);
+        __STL_RETHROW;
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename hashtable<V, K, HF, Ex, Eq, A>::stats_type
+hashtable<V, K, HF, Ex, Eq, A>::stats(size_type max_chains) const
+{
+    stats_type s;
+    const size_type used = occupied.count() + old_occupied.count();
+    s.elements = num_elements;
+    s.bucket_count = buckets.size() + old_buckets.size();
+    s.empty_buckets = s.bucket_count - used;
+    s.load_factor = load_factor();
+    s.empty_ratio = s.bucket_count ? float(s.empty_buckets) / float(s.bucket_count) : 0.0f;
+    s.longest_chain = 0;
+    for (int i = 0; i < stats_type::histogram_size; ++i) {
+        s.histogram[i] = 0;
+    }
+    s.histogram[0] = s.empty_buckets;
+    s.chains_examined = 0;
+    const size_type step = (max_chains != 0 && used > max_chains)
+                         ? (used + max_chains - 1) / max_chains : 1;
+    size_type skip = 0;
+    collect_chains(s, buckets, occupied, step, skip);
+    collect_chains(s, old_buckets, old_occupied, step, skip);
+    s.bucket_bytes = (buckets.capacity() + old_buckets.capacity()) * sizeof(node*)
+                   + occupied.bytes() + old_occupied.bytes();
+    s.node_bytes = num_elements * sizeof(node);
+    s.grow_count = num_grows;
+    s.shrink_count = num_shrinks;
+    return s;
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void hashtable<V, K, HF, Ex, Eq, A>::collect_chains(stats_type& s,
+                                                    const vector<node*, A>& table,
+                                                    const __hashtable_bucket_bitmap<A>& bits,
+                                                    size_type step, size_type& skip) const
+{
+    const size_type n = table.size();
+    for (size_type i = bits.find_next(0, n); i < n; i = bits.find_next(i + 1, n)) {
+        if (skip++ % step != 0) {
+            continue;
+        }
+        size_type len = 0;
+        for (const node* cur = table[i]; cur; cur = cur->next) {
+            ++len;
+        }
+        if (len > s.longest_chain) {
+            s.longest_chain = len;
+        }
+        ++s.histogram[len < size_type(stats_type::histogram_size)
+                      ? len : size_type(stats_type::histogram_size - 1)];
+        ++s.chains_examined;
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void hashtable<V, K, HF, Ex, Eq, A>::rehash_bucket(size_type n)
+{
+    node* first;
+    while ((first = old_buckets[n]) != 0) {
+        // 先算出新 bucket 再摘下节点: hash function 抛出异常时两个表格都仍然完好
+        const size_type new_bucket = bkt_index(node_hash(first));
+        old_buckets[n] = first->next;
+        first->next = buckets[new_bucket];
+        buckets[new_bucket] = first;
+        occupied.set(new_bucket);
+    }
+    old_occupied.reset(n);
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void hashtable<V, K, HF, Ex, Eq, A>::rehash_some(size_type n)
+{
+    // 空的 bucket 由占用位图一次略过, 不必像 Redis dict 那样限制每次看过的空 bucket 个数
+    while (n != 0 && rehash_index < old_buckets.size()) {
+        rehash_index = old_occupied.find_next(rehash_index, old_buckets.size());
+        if (rehash_index < old_buckets.size()) {
+            rehash_bucket(rehash_index);
+            ++rehash_index;
+            --n;
+        }
+    }
+    if (rehash_index >= old_buckets.size()) {
+        vector<node*, A>().swap(old_buckets);   // 真正释放旧表格的空间
+        old_occupied.release();
+        rehash_index = 0;
     }
 }
 
@@ -459,133 +1259,304 @@ template <class V, class K, class HF, class Ex, class Eq, class A>
 pair<typename hashtable<V, K, HF, Ex, Eq, A>::iterator, bool>
 hashtable<V, K, HF, Ex, Eq, A>::insert_unique_noresize(const value_type& obj)
 {
-    const size_type n = bkt_num(obj);   // 决定 obj 应位于 #n bucket
+    return insert_unique_noresize(obj, hash(get_key(obj)));
+}
+
+// 同上, 杂凑值 h 已由调用者算出
+template <class V, class K, class HF, class Ex, class Eq, class A>
+pair<typename hashtable<V, K, HF, Ex, Eq, A>::iterator, bool>
+hashtable<V, K, HF, Ex, Eq, A>::insert_unique_noresize(const value_type& obj, size_type h)
+{
+    rehash_for(h);
+    const size_type n = bkt_index(h);   // 决定 obj 应位于 #n bucket
     node* first = buckets[n];           // 令 first 指向 bucket 对应的串行头部
 
     // 如果 buckets[n] 已被占用, 此时 first 将不为 0, 于是进入以下循环,
     // 走过 bucket 所对应的整个链表
     for (node* cur = first; cur; cur = cur->next) {
-        if (equals(get_key(cur->val), get_key(obj))) {
+        if (node_equals(cur, h, get_key(obj))) {
             // 如果发现与链表中的某键值相同, 就不插入, 立刻返回
-            return pair<iterator, bool>(iterator(cur, this), false);
+            return pair<iterator, bool>(iterator(cur, this, n), false);
         }
     }
     // 离开以上循环(或根本未进入循环)时, first 指向 bucket 所指链表的头部节点
-    node* tmp = new_node(obj);      // 产生新节点
+    node* tmp = new_node(obj, h);   // 产生新节点
     tmp->next = first;
     buckets[n] = tmp;               // 令新节点成为链表的第一个节点
+    occupied.set(n);
     ++num_elements;                 // 节点个数累加 1
-    return pair<iterator, bool>(iterator(tmp, this), true);
+    return pair<iterator, bool>(iterator(tmp, this, n), true);
 }
 
 template <class V, class K, class HF, class Ex, class Eq, class A>
-typename hashtable<V, K, HF, Ex, Eq, A>::iterator
+inline typename hashtable<V, K, HF, Ex, Eq, A>::iterator
 hashtable<V, K, HF, Ex, Eq, A>::insert_equal_noresize(const value_type& obj)
 {
-    const size_type n = bkt_num(obj);   // 决定 obj 应位于 #n bucket
-    node* first = buckets[n];           // 令 first 指向 bucket 对应的串行头部
+    const size_type h = hash(get_key(obj));
+    return link_equal_noresize(new_node(obj, h), h);    // 产生新节点, 串接到表格中
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename hashtable<V, K, HF, Ex, Eq, A>::iterator
+hashtable<V, K, HF, Ex, Eq, A>::link_equal_noresize(node* tmp, size_type h)
+{
+    rehash_for(h);
+    const size_type n = bkt_index(h);  // 决定 tmp 应位于 #n bucket
+    node* first = buckets[n];               // 令 first 指向 bucket 对应的串行头部
 
     // 如果 buckets[n] 已被占用, 此时 first 将不为 0, 于是进入以下循环,
     // 走过 bucket 所对应的整个链表
     for (node* cur = first; cur; cur = cur->next) {
-        if (equals(get_key(cur->val), get_key(obj))) {
+        if (node_equals(cur, h, get_key(tmp->val))) {
             // 如果发现与链表中的某键值相同, 就马上插入, 然后返回
-            node* tmp = new_node(obj);      // 产生新节点
             tmp->next = cur->next;          // 将新节点插入于目前位置之后
             cur->next = tmp;
             ++num_elements;                 // 节点个数累加 1
-            return iterator(tmp, this);     // 返回一个迭代器, 指向新增节点
+            return iterator(tmp, this, n);  // 返回一个迭代器, 指向新增节点
         }
     }
 
     // 进行至此, 表示没有发现重复的键值
-    node* tmp = new_node(obj);      // 产生新节点
     tmp->next = first;              // 将新节点插入于链头部
     buckets[n] = tmp;
+    occupied.set(n);
     ++num_elements;                 // 节点个数累加 1
-    return iterator(tmp, this);     // 返回一个迭代器, 指向新增节点
+    return iterator(tmp, this, n);  // 返回一个迭代器, 指向新增节点
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+pair<typename hashtable<V, K, HF, Ex, Eq, A>::iterator, bool>
+hashtable<V, K, HF, Ex, Eq, A>::insert_unique(const node_type& nh)
+{
+    if (nh.empty()) {
+        return pair<iterator, bool>(end(), false);
+    }
+    rehash_step();
+    // 把手中的键值可能已被修改, 杂凑值必须重新计算
+    const size_type h = hash(get_key(nh.cur->val));
+    if (node* p = __find_node(get_key(nh.cur->val), h)) {
+        return pair<iterator, bool>(iterator(p, this), false);
+    }
+    resize(num_elements + 1);
+    rehash_for(h);
+    const size_type n = bkt_index(h);
+    node* tmp = nh.release();
+    set_node_hash(tmp, h);
+    tmp->next = buckets[n];
+    buckets[n] = tmp;
+    occupied.set(n);
+    ++num_elements;
+    return pair<iterator, bool>(iterator(tmp, this, n), true);
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename hashtable<V, K, HF, Ex, Eq, A>::iterator
+hashtable<V, K, HF, Ex, Eq, A>::insert_equal(const node_type& nh)
+{
+    if (nh.empty()) {
+        return end();
+    }
+    rehash_step();
+    const size_type h = hash(get_key(nh.cur->val));
+    resize(num_elements + 1);
+    node* tmp = nh.release();
+    set_node_hash(tmp, h);
+    return link_equal_noresize(tmp, h);
+}
+
+// 逐一走过 src 的每个 bucket 串行, 把可以移动的节点摘下, 直接串接进 *this
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void hashtable<V, K, HF, Ex, Eq, A>::merge_unique(hashtable& src)
+{
+    if (&src == this) return;
+    src.finish_rehash();    // 以下只走访 src 的新表格
+    for (size_type bucket = 0; bucket < src.buckets.size(); ++bucket) {
+        node* prev = 0;
+        node* cur = src.buckets[bucket];
+        while (cur) {
+            node* next = cur->next;
+            const size_type h = src.node_hash(cur);
+            rehash_step();
+            if (__find_node(get_key(cur->val), h) != 0) {
+                prev = cur;     // 键值重复, 留在 src 中
+            } else {
+                // 先扩充表格(可能抛出 bad_alloc)再摘下节点, 失败时两边都保持原样
+                resize(num_elements + 1);
+                rehash_for(h);
+                if (prev) {
+                    prev->next = next;
+                } else if ((src.buckets[bucket] = next) == 0) {
+                    src.occupied.reset(bucket);
+                }
+                --src.num_elements;
+                const size_type n = bkt_index(h);
+                cur->next = buckets[n];
+                buckets[n] = cur;
+                occupied.set(n);
+                ++num_elements;
+            }
+            cur = next;
+        }
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void hashtable<V, K, HF, Ex, Eq, A>::merge_equal(hashtable& src)
+{
+    if (&src == this) return;
+    src.finish_rehash();
+    resize(num_elements + src.num_elements);    // 一次扩充到位
+    for (size_type bucket = 0; bucket < src.buckets.size(); ++bucket) {
+        node* cur = src.buckets[bucket];
+        src.buckets[bucket] = 0;
+        while (cur) {
+            node* next = cur->next;
+            link_equal_noresize(cur, src.node_hash(cur));
+            cur = next;
+        }
+    }
+    src.occupied.assign(src.buckets.size());
+    src.num_elements = 0;
+}
+
+// Iterator 为 iterator 或 const_iterator. 新表格中找不到时才查旧表格, 旧表格不预取
+template <class V, class K, class HF, class Ex, class Eq, class A>
+template <class ForwardIterator, class OutputIterator, class Iterator>
+OutputIterator
+hashtable<V, K, HF, Ex, Eq, A>::__find_batch(ForwardIterator first, ForwardIterator last,
+                                             OutputIterator out, Iterator*) const
+{
+    hashtable* self = const_cast<hashtable*>(this);     // 供产生 iterator, 不会经由它修改
+    size_type h[batch_size];
+    size_type b[batch_size];
+    while (first != last) {
+        // (1) 算出一组键值的杂凑值, 预取各自的 bucket
+        ForwardIterator block = first;
+        size_type n = 0;
+        for ( ; n < batch_size && first != last; ++first, ++n) {
+            h[n] = hash(*first);
+            b[n] = bkt_index(h[n]);
+            __stl_prefetch(&buckets[b[n]]);
+        }
+        // (2) 预取各串行的第一个节点
+        for (size_type i = 0; i < n; ++i) {
+            __stl_prefetch(buckets[b[i]]);
+        }
+        // (3) 比较键值
+        for (size_type i = 0; i < n; ++i, ++block) {
+            node* cur = buckets[b[i]];
+            for ( ; cur && !node_equals(cur, h[i], *block); cur = cur->next)
+            {}
+            if (cur) {
+                *out++ = Iterator(cur, self, b[i]);
+            } else {
+                *out++ = Iterator(rehashing() ? __find_node(true, h[i], *block) : 0, self);
+            }
+        }
+    }
+    return out;
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+template <class ForwardIterator>
+void hashtable<V, K, HF, Ex, Eq, A>::__insert_batch(ForwardIterator first, ForwardIterator last,
+                                                    bool unique)
+{
+    size_type h[batch_size];
+    size_type b[batch_size];
+    while (first != last) {
+        ForwardIterator block = first;
+        size_type n = 0;
+        for ( ; n < batch_size && first != last; ++first, ++n)
+        {}
+        // 先扩大表格: 一组之内 bucket 个数不再改变, 预先算出的 bucket 才一直有效
+        rehash_step();
+        resize(num_elements + n);
+        ForwardIterator it = block;
+        for (size_type i = 0; i < n; ++i, ++it) {
+            h[i] = hash(get_key(*it));
+            b[i] = bkt_index(h[i]);
+            __stl_prefetch(&buckets[b[i]]);
+        }
+        for (size_type i = 0; i < n; ++i) {
+            __stl_prefetch(buckets[b[i]]);
+        }
+        for (size_type i = 0; i < n; ++i, ++block) {
+            if (unique) {
+                insert_unique_noresize(*block, h[i]);
+            } else {
+                link_equal_noresize(new_node(*block, h[i]), h[i]);
+            }
+        }
+    }
 }
 
 template <class V, class K, class HF, class Ex, class Eq, class A>
 typename hashtable<V, K, HF, Ex, Eq, A>::reference 
 hashtable<V, K, HF, Ex, Eq, A>::find_or_insert(const value_type& obj)
 {
+    rehash_step();
     resize(num_elements + 1);
+    const size_type h = hash(get_key(obj));
+    rehash_for(h);
 
-    size_type n = bkt_num(obj);
+    size_type n = bkt_index(h);
     node* first = buckets[n];
 
     for (node* cur = first; cur; cur = cur->next) {
-        if (equals(get_key(cur->val), get_key(obj))) {
+        if (node_equals(cur, h, get_key(obj))) {
             return cur->val;
         }
     }
 
-    node* tmp = new_node(obj);
+    node* tmp = new_node(obj, h);
     tmp->next = first;
     buckets[n] = tmp;
+    occupied.set(n);
     ++num_elements;
 
     return tmp->val;
 }
 
 template <class V, class K, class HF, class Ex, class Eq, class A>
-pair<typename hashtable<V, K, HF, Ex, Eq, A>::iterator,
-     typename hashtable<V, K, HF, Ex, Eq, A>::iterator>
-hashtable<V, K, HF, Ex, Eq, A>::equal_range(const key_type& key)
-{
-    typedef pair<iterator, iterator> Pii;
-    const size_type n = bkt_num_key(key);
-
-    for (node* first = buckets[n]; first; first = first->next) {
-        if (equals(get_key(first->val), key)) {
-            for (node* cur = first->next; cur; cur = cur->next) {
-                if (!equals(get_key(cur->val), key)) {
-                    return Pii(iterator(first, this), iterator(cur, this));
-                }
-            }
-            for (size_type m = n + 1; m < buckets.size(); ++m) {
-                if (buckets[m]) {
-                    return Pii(iterator(first, this), iterator(buckets[m], this));
-                }
-            }
-            return Pii(iterator(first, this), end());
+template <class KT>
+pair<typename hashtable<V, K, HF, Ex, Eq, A>::node*,
+     typename hashtable<V, K, HF, Ex, Eq, A>::node*>
+hashtable<V, K, HF, Ex, Eq, A>::__equal_range(const KT& key) const
+{
+    typedef pair<node*, node*> Pnn;
+    const size_type h = hash(key);
+
+    // 相同键值的元素总在同一个表格中, 所以在哪个表格找到, 就在哪个表格找出范围的尾端
+    for (int in_old = 0; in_old < 2; ++in_old) {
+        const vector<node*, A>& table = in_old ? old_buckets : buckets;
+        if (table.empty()) {
+            break;
         }
-    }
-    return Pii(end(), end());
-}
-
-template <class V, class K, class HF, class Ex, class Eq, class A>
-pair<typename hashtable<V, K, HF, Ex, Eq, A>::const_iterator,
-     typename hashtable<V, K, HF, Ex, Eq, A>::const_iterator>
-hashtable<V, K, HF, Ex, Eq, A>::equal_range(const key_type& key) const
-{
-    typedef pair<const_iterator, const_iterator> Pii;
-    const size_type n = bkt_num_key(key);
-
-    for (const node* first = buckets[n]; first; first = first->next) {
-        if (equals(get_key(first->val), key)) {
-            for (const node* cur = first->next; cur; cur = cur->next) {
-                if (!equals(get_key(cur->val), key)) {
-                    return Pii(const_iterator(first, this), const_iterator(cur, this));
-                }
-            }
-            for (size_type m = n + 1; m < buckets.size(); ++m) {
-                if (buckets[m]) {
-                    return Pii(const_iterator(first, this), const_iterator(buckets[m], this));
+        const size_type n = in_old ? old_bkt_index(h) : bkt_index(h);
+        for (node* first = table[n]; first; first = first->next) {
+            if (node_equals(first, h, key)) {
+                for (node* cur = first->next; cur; cur = cur->next) {
+                    if (!node_equals(cur, h, key)) {
+                        return Pnn(first, cur);
+                    }
                 }
+                size_type b = (in_old ? buckets.size() : 0) + n + 1;
+                return Pnn(first, first_chain(b));
             }
-            return Pii(const_iterator(first, this), end());
         }
     }
-    return Pii(end(), end());
+    return Pnn(0, 0);
 }
 
 template <class V, class K, class HF, class Ex, class Eq, class A>
 typename hashtable<V, K, HF, Ex, Eq, A>::size_type 
 hashtable<V, K, HF, Ex, Eq, A>::erase(const key_type& key)
 {
-    const size_type n = bkt_num_key(key);
+    rehash_step();
+    const size_type h = hash(key);
+    rehash_for(h);      // 此后 key 只可能在新表格中
+    const size_type n = bkt_index(h);
     node* first = buckets[n];
     size_type erased = 0;
 
@@ -593,7 +1564,7 @@ hashtable<V, K, HF, Ex, Eq, A>::erase(const key_type& key)
         node* cur = first;
         node* next = cur->next;
         while (next) {
-            if (equals(get_key(next->val), key)) {
+            if (node_equals(next, h, key)) {
                 cur->next = next->next;
                 delete_node(next);
                 next = cur->next;
@@ -604,12 +1575,18 @@ hashtable<V, K, HF, Ex, Eq, A>::erase(const key_type& key)
                 next = cur->next;
             }
         }
-        if (equals(get_key(first->val), key)) {
+        if (node_equals(first, h, key)) {
             buckets[n] = first->next;
             delete_node(first);
             ++erased;
             --num_elements;
         }
+        if (!buckets[n]) {
+            occupied.reset(n);
+        }
+    }
+    if (erased) {
+        shrink_if_sparse();
     }
     return erased;
 }
@@ -617,37 +1594,87 @@ hashtable<V, K, HF, Ex, Eq, A>::erase(const key_type& key)
 template <class V, class K, class HF, class Ex, class Eq, class A>
 void hashtable<V, K, HF, Ex, Eq, A>::erase(const iterator& it)
 {
-    node* p = it.cur;
+    if (node* p = unlink_node(it.cur, it.bucket)) {
+        delete_node(p);
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename hashtable<V, K, HF, Ex, Eq, A>::node*
+hashtable<V, K, HF, Ex, Eq, A>::unlink_node(node* p, size_type b)
+{
     if (p) {
-        const size_type n = bkt_num(p->val);
-        node* cur = buckets[n];
+        // b 只是提示, 渐进式 rehash 之后可能已经过时: 不在其中时根据元素值重新定位
+        if (live_bucket(b) && unlink_from_bucket(b, p)) {
+            return p;
+        }
+        if (unlink_from_bucket(bucket_of(p), p)) {
+            return p;
+        }
+    }
+    return 0;
+}
 
-        if (cur == p) {
-            buckets[n] = cur->next;
-            delete_node(cur);
-            --num_elements;
-        } else {
-            node* next = cur->next;
-            while (next) {
-                if (next == p) {
-                    cur->next = next->next;
-                    delete_node(next);
-                    --num_elements;
-                    break;
-                } else {
-                    cur = next;
-                    next = cur->next;
-                }
+template <class V, class K, class HF, class Ex, class Eq, class A>
+bool hashtable<V, K, HF, Ex, Eq, A>::unlink_from_bucket(size_type b, node* p)
+{
+    const size_type n = buckets.size();
+    if (b < n) {
+        if (unlink_node(buckets[b], p)) {
+            if (!buckets[b]) {
+                occupied.reset(b);
             }
+            return true;
+        }
+    } else if (unlink_node(old_buckets[b - n], p)) {
+        if (!old_buckets[b - n]) {
+            old_occupied.reset(b - n);
         }
+        return true;
     }
+    return false;
+}
+
+// 在以 head 起头的串行中找出 p 并摘下. 不在其中时返回 0
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename hashtable<V, K, HF, Ex, Eq, A>::node*
+hashtable<V, K, HF, Ex, Eq, A>::unlink_node(node*& head, node* p)
+{
+    node* cur = head;
+    if (cur == p) {
+        head = cur->next;
+        --num_elements;
+        return p;
+    } else if (cur) {
+        node* next = cur->next;
+        while (next) {
+            if (next == p) {
+                cur->next = next->next;
+                --num_elements;
+                return p;
+            } else {
+                cur = next;
+                next = cur->next;
+            }
+        }
+    }
+    return 0;
 }
 
 template <class V, class K, class HF, class Ex, class Eq, class A>
 void hashtable<V, K, HF, Ex, Eq, A>::erase(iterator first, iterator last)
 {
-    size_type f_bucket = first.cur ? bkt_num(first.cur->val) : buckets.size();
-    size_type l_bucket = last.cur ? bkt_num(last.cur->val) : buckets.size();
+    if (rehashing()) {
+        // 范围可能跨越两个表格, 逐一删除. erase(iterator) 不做搬移, 迭代顺序不变
+        while (first != last) {
+            erase(first++);
+        }
+        shrink_if_sparse();
+        return;
+    }
+    // 迭代器可能取自刚结束的搬移期间, 记下的是旧表格的 bucket, 由 bucket_of() 核对
+    size_type f_bucket = !first.cur ? buckets.size() : bucket_of(first.cur, first.bucket);
+    size_type l_bucket = !last.cur ? buckets.size() : bucket_of(last.cur, last.bucket);
 
     if (first.cur == last.cur) {
         return;
@@ -662,21 +1689,24 @@ void hashtable<V, K, HF, Ex, Eq, A>::erase(iterator first, iterator last)
             erase_bucket(l_bucket, last.cur);
         }
     }
+    shrink_if_sparse();
 }
 
 template <class V, class K, class HF, class Ex, class Eq, class A>
 inline void
 hashtable<V, K, HF, Ex, Eq, A>::erase(const_iterator first, const_iterator last)
 {
-    erase(iterator(const_cast<node*>(first.cur), const_cast<hashtable*>(first.ht)),
-          iterator(const_cast<node*>(last.cur), const_cast<hashtable*>(last.ht)));
+    erase(iterator(const_cast<node*>(first.cur), const_cast<hashtable*>(first.ht),
+                   first.bucket),
+          iterator(const_cast<node*>(last.cur), const_cast<hashtable*>(last.ht),
+                   last.bucket));
 }
 
 template <class V, class K, class HF, class Ex, class Eq, class A>
 inline void
 hashtable<V, K, HF, Ex, Eq, A>::erase(const const_iterator& it)
 {
-    erase(iterator(const_cast<node*>(it.cur), const_cast<hashtable*>(it.ht)));
+    erase(iterator(const_cast<node*>(it.cur), const_cast<hashtable*>(it.ht), it.bucket));
 }
 
 template <class V, class K, class _HF, class _Ex, class _Eq, class _All>
@@ -709,13 +1739,17 @@ void hashtable<V, K,_HF,_Ex,_Eq,_All> ::erase_bucket(const size_type n, node* la
         buckets[n] = cur;
         --num_elements;
     }
+    if (!cur) {
+        occupied.reset(n);
+    }
 }
 
 template <class V, class K, class HF, class Ex, class Eq, class A>
 void hashtable<V, K, HF, Ex, Eq, A>::clear()
 {
-    // 针对每一个 bucket
-    for (size_type i = 0; i < buckets.size(); ++i) {
+    // 针对每一个非空的 bucket
+    for (size_type i = occupied.find_next(0, buckets.size()); i < buckets.size();
+         i = occupied.find_next(i + 1, buckets.size())) {
         node* cur = buckets[i];
         // 将 bucket list 中的每一个节点删除掉
         while (cur != 0) {
@@ -724,7 +1758,20 @@ void hashtable<V, K, HF, Ex, Eq, A>::clear()
             cur = next;
         }
         buckets[i] = 0;     // 令 bucket 内容为 null 指针
+        occupied.reset(i);
+    }
+    // 渐进式 rehash 进行中时, 旧表格尚未搬移的节点也要删除, 并释放旧表格
+    for (size_type i = rehash_index; i < old_buckets.size(); ++i) {
+        node* cur = old_buckets[i];
+        while (cur != 0) {
+            node* next = cur->next;
+            delete_node(cur);
+            cur = next;
+        }
     }
+    vector<node*, A>().swap(old_buckets);
+    old_occupied.release();
+    rehash_index = 0;
     num_elements = 0;       // 令总节点个数为 0
 
     // 注意, buckets vector 并未释放掉空间, 仍保有原来大小
@@ -739,21 +1786,30 @@ void hashtable<V, K, HF, Ex, Eq, A>::copy_from(const hashtable& ht)
     // 从己方的 buckets vector 尾端开始, 插入 n 个元素, 其值为 null 指针
     // 注意, 此时 buckets vector 为空, 所以所谓尾端, 就是起头处
     buckets.insert(buckets.end(), ht.buckets.size(), (node*)0);
+    bucket_state = ht.bucket_state;
+    occupied.assign(buckets.size());
     __STL_TRY {
         // 针对 buckets vector
-        for (size_type i = 0; i < ht.buckets.size()l ++i) {
+        for (size_type i = 0; i < ht.buckets.size(); ++i) {
             // 复制 vector 的每一个元素(是个指针, 指向 hashtable node)
             if (const node* cur = ht.buckets[i]) {
-                node* copy = new_node(cur->val);
+                node* copy = clone_node(cur);
                 buckets[i] = copy;
+                occupied.set(i);
 
                 // 针对同一个 bucket list, 复制每一个节点
                 for (node* next = cur->next; next; cur = next, next = cur->next) {
-                    copy->next = new_node(next->val);
+                    copy->next = clone_node(next);
                     copy = copy->next;
                 }
             }
         }
+        // 对方正在渐进式 rehash 时, 其旧表格中的节点直接放进己方的表格
+        for (size_type i = ht.rehash_index; i < ht.old_buckets.size(); ++i) {
+            for (const node* cur = ht.old_buckets[i]; cur; cur = cur->next) {
+                link_equal_noresize(clone_node(cur), ht.node_hash(cur));
+            }
+        }
         num_elements = ht.num_elements;     // 重新记录节点个数(hashtable 的大小)
     }
     __STL_UNWIND(clear());
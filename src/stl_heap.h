@@ -1,6 +1,8 @@
 #ifndef __STL_HEAP_H
 #define __STL_HEAP_H
 
+#include "stl_iterator.h"
+
 template <class RandomAccessIterator>
 inline void push_heap(RandomAccessIterator first, RandomAccessIterator last)
 {
@@ -128,4 +130,90 @@ void __make_heap(RandomAccessIterator first, RandomAccessIterator last, T*, Dist
     }
 }
 
-#endif
\ No newline at end of file
+// 以下各函数为以上同名函数的版本二, 以 comp 取代 operator< 作为 "大小比较标准".
+// 其间的互相调用都以 :: 限定, 以免元素型别来自 std 时, 经由 ADL 与标准库的同名函数冲突;
+// value_type() 与 distance_type() 位于 cstl 之中, 以 cstl:: 限定
+template <class RandomAccessIterator, class Distance, class T, class Compare>
+void __push_heap(RandomAccessIterator first, Distance holeIndex,
+                 Distance topIndex, T value, Compare comp)
+{
+    Distance parent = (holeIndex - 1) / 2;
+    while (holeIndex > topIndex && comp(*(first + parent), value)) {
+        *(first + holeIndex) = *(first + parent);
+        holeIndex = parent;
+        parent = (holeIndex - 1) / 2;
+    }
+    *(first + holeIndex) = value;
+}
+
+template <class RandomAccessIterator, class Distance, class T, class Compare>
+void __adjust_heap(RandomAccessIterator first, Distance holeIndex, Distance len,
+                   T value, Compare comp)
+{
+    Distance topIndex = holeIndex;
+    Distance secondChild = 2 * holeIndex + 2;
+    while (secondChild < len) {
+        if (comp(*(first + secondChild), *(first + (secondChild - 1)))) {
+            secondChild--;
+        }
+        *(first + holeIndex) = *(first + secondChild);
+        holeIndex = secondChild;
+        secondChild = 2 * (secondChild + 1);
+    }
+    if (secondChild == len) {
+        *(first + holeIndex) = *(first + (secondChild - 1));
+        holeIndex = secondChild - 1;
+    }
+    ::__push_heap(first, holeIndex, topIndex, value, comp);
+}
+
+template <class RandomAccessIterator, class T, class Compare, class Distance>
+inline void __pop_heap(RandomAccessIterator first, RandomAccessIterator last,
+                       RandomAccessIterator result, T value, Compare comp, Distance*)
+{
+    *result = *first;
+    ::__adjust_heap(first, Distance(0), Distance(last - first), value, comp);
+}
+
+template <class RandomAccessIterator, class T, class Compare>
+inline void __pop_heap_aux(RandomAccessIterator first, RandomAccessIterator last,
+                           T*, Compare comp)
+{
+    ::__pop_heap(first, last - 1, last - 1, T(*(last - 1)), comp, cstl::distance_type(first));
+}
+
+template <class RandomAccessIterator, class Compare>
+inline void pop_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+{
+    ::__pop_heap_aux(first, last, cstl::value_type(first), comp);
+}
+
+template <class RandomAccessIterator, class Compare>
+void sort_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+{
+    while (last - first > 1) {
+        ::pop_heap(first, last--, comp);
+    }
+}
+
+template <class RandomAccessIterator, class T, class Distance, class Compare>
+void __make_heap(RandomAccessIterator first, RandomAccessIterator last,
+                 T*, Distance*, Compare comp)
+{
+    if (last - first < 2) return;
+    Distance len = last - first;
+    Distance holeIndex = (len - 2) / 2;
+    while (true) {
+        ::__adjust_heap(first, holeIndex, len, T(*(first + holeIndex)), comp);
+        if (holeIndex == 0) return;
+        holeIndex--;
+    }
+}
+
+template <class RandomAccessIterator, class Compare>
+inline void make_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+{
+    ::__make_heap(first, last, cstl::value_type(first), cstl::distance_type(first), comp);
+}
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef __STL_INTRUSIVE_LIST_H
+#define __STL_INTRUSIVE_LIST_H
+
+#include <cstddef>
+
+#include "stl_iterator.h"
+#include "stl_list.h"
+
+namespace cstl
+{
+
+// 侵入式双向链表
+// list 为每个元素配置一个 __list_node, 而 intrusive_list 要求用户对象自己内嵌
+// 一个 list_hook, 容器只负责串接指针, 插入和删除都不配置任何内存.
+// 同一个对象可以内嵌多个 hook, 同时出现在多个 intrusive_list 之中.
+// 容器不拥有元素: 元素的生命期由用户管理, 元素在被析构前必须先从容器中移除
+//
+// 用法:
+//     struct conn {
+//         int fd;
+//         list_hook all_hook;
+//         list_hook idle_hook;
+//     };
+//     intrusive_list<conn, &conn::all_hook> all;
+//     intrusive_list<conn, &conn::idle_hook> idle;
+
+struct list_hook {
+    list_hook* prev;
+    list_hook* next;
+
+    list_hook() : prev(0), next(0) { }
+    bool is_linked() const { return next != 0; }
+};
+
+// 由 hook 的地址反推出内嵌它的对象的地址
+template <class T, list_hook T::*Hook>
+inline T* __list_hook_owner(const list_hook* h)
+{
+    const size_t offset = (size_t)&(((T*)0)->*Hook);
+    return (T*)((char*)h - offset);
+}
+
+template <class T, list_hook T::*Hook, class Ref, class Ptr>
+struct __intrusive_list_iterator {
+    typedef __intrusive_list_iterator<T, Hook, T&, T*> iterator;
+    typedef __intrusive_list_iterator<T, Hook, Ref, Ptr> self;
+
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef Ptr pointer;
+    typedef Ref reference;
+    typedef list_hook* link_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    link_type node;
+
+    __intrusive_list_iterator(link_type x) : node(x) { }
+    __intrusive_list_iterator() { }
+    __intrusive_list_iterator(const iterator& x) : node(x.node) { }
+
+    bool operator==(const self& x) const { return node == x.node; }
+    bool operator!=(const self& x) const { return node != x.node; }
+    reference operator*() const { return *__list_hook_owner<T, Hook>(node); }
+    pointer operator->() const { return &(operator*()); }
+
+    self& operator++()
+    {
+        node = node->next;
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    self& operator--()
+    {
+        node = node->prev;
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+};
+
+template <class T, list_hook T::*Hook>
+class intrusive_list {
+public:
+    typedef __intrusive_list_iterator<T, Hook, T&, T*>             iterator;
+    typedef __intrusive_list_iterator<T, Hook, const T&, const T*> const_iterator;
+
+    typedef T                 value_type;
+    typedef value_type*       pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type&       reference;
+    typedef const value_type& const_reference;
+    typedef size_t            size_type;
+    typedef ptrdiff_t         difference_type;
+    typedef list_hook*        link_type;
+
+protected:
+    list_hook node;     // 环状链表的头节点, 内嵌于容器, 不必配置
+
+public:
+    intrusive_list() { node.next = &node; node.prev = &node; }
+    ~intrusive_list() { clear(); }
+
+    iterator begin() { return node.next; }
+    iterator end() { return &node; }
+    const_iterator begin() const { return node.next; }
+    const_iterator end() const { return const_cast<link_type>(&node); }
+    bool empty() const { return node.next == &node; }
+    size_type size() const
+    {
+        size_type result = 0;
+        for (const list_hook* p = node.next; p != &node; p = p->next) ++result;
+        return result;
+    }
+
+    reference front() { return *begin(); }
+    reference back() { return *(--end()); }
+
+    // 由元素取得指向它的迭代器. O(1)
+    iterator iterator_to(reference x) { return &(x.*Hook); }
+
+    void push_front(reference x) { insert(begin(), x); }
+    void push_back(reference x) { insert(end(), x); }
+    void pop_front() { erase(begin()); }
+    void pop_back()
+    {
+        iterator tmp = end();
+        erase(--tmp);
+    }
+
+    // 将 x 串接于 position 之前. 不配置内存
+    iterator insert(iterator position, reference x)
+    {
+        link_type tmp = &(x.*Hook);
+        tmp->next = position.node;
+        tmp->prev = position.node->prev;
+        position.node->prev->next = tmp;
+        position.node->prev = tmp;
+        return tmp;
+    }
+
+    // 将 position 所指元素摘下. 不析构元素, 不释放内存
+    iterator erase(iterator position)
+    {
+        link_type next_node = position.node->next;
+        link_type prev_node = position.node->prev;
+        prev_node->next = next_node;
+        next_node->prev = prev_node;
+        position.node->next = position.node->prev = 0;
+        return next_node;
+    }
+
+    iterator erase(iterator first, iterator last)
+    {
+        while (first != last) first = erase(first);
+        return last;
+    }
+
+    void remove(reference x) { erase(iterator_to(x)); }
+
+    // 摘下所有元素. 各元素的 hook 被重置为未串接状态
+    void clear() { erase(begin(), end()); }
+
+    // 以下三个 splice 与 list 相同, 都是调用 __list_transfer(), 只动指针
+    void splice(iterator position, intrusive_list& x)
+    {
+        if (!x.empty()) {
+            __list_transfer(position.node, x.begin().node, x.end().node);
+        }
+    }
+
+    void splice(iterator position, intrusive_list&, iterator i)
+    {
+        iterator j = i;
+        ++j;
+        if (position == i || position == j) return;
+        __list_transfer(position.node, i.node, j.node);
+    }
+
+    void splice(iterator position, intrusive_list&, iterator first, iterator last)
+    {
+        if (first != last) {
+            __list_transfer(position.node, first.node, last.node);
+        }
+    }
+
+    // 头节点内嵌于容器之中, 所以不能像 list 那样交换指针, 改以三次 splice 完成
+    void swap(intrusive_list& x)
+    {
+        intrusive_list tmp;
+        tmp.splice(tmp.end(), *this);
+        splice(end(), x);
+        x.splice(x.end(), tmp);
+    }
+
+private:
+    // 元素不属于容器, 复制容器没有意义
+    intrusive_list(const intrusive_list&);
+    intrusive_list& operator=(const intrusive_list&);
+};
+
+} // namespace cstl
+
+#endif /* __STL_INTRUSIVE_LIST_H */
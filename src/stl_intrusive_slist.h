@@ -0,0 +1,141 @@
+#ifndef __STL_INTRUSIVE_SLIST_H
+#define __STL_INTRUSIVE_SLIST_H
+
+#include <cstddef>
+
+#include "../src/stl_config.h"
+#include "../src/stl_iterator.h"
+#include "../src/stl_slist.h"
+
+// 侵入式单向链表
+// 用户对象内嵌一个 slist_hook (亦即 __slist_node_base), 容器只串接 next 指针,
+// 插入和删除都不配置内存. 元素的生命期由用户管理
+//
+// 用法:
+//     struct timer {
+//         long expire;
+//         slist_hook wheel_hook;
+//     };
+//     intrusive_slist<timer, &timer::wheel_hook> slot;
+
+typedef __slist_node_base slist_hook;
+
+template <class T, slist_hook T::*Hook>
+inline T* __slist_hook_owner(const slist_hook* h)
+{
+    const size_t offset = (size_t)&(((T*)0)->*Hook);
+    return (T*)((char*)h - offset);
+}
+
+template <class T, slist_hook T::*Hook, class Ref, class Ptr>
+struct __intrusive_slist_iterator : public __slist_iterator_base {
+    typedef __intrusive_slist_iterator<T, Hook, T&, T*> iterator;
+    typedef __intrusive_slist_iterator<T, Hook, const T&, const T*> const_iterator;
+    typedef __intrusive_slist_iterator<T, Hook, Ref, Ptr> self;
+
+    typedef T value_type;
+    typedef Ptr pointer;
+    typedef Ref reference;
+
+    __intrusive_slist_iterator(slist_hook* x) : __slist_iterator_base(x) { }
+    __intrusive_slist_iterator() : __slist_iterator_base(0) { }
+    __intrusive_slist_iterator(const iterator& x) : __slist_iterator_base(x.node) { }
+
+    reference operator*() const { return *__slist_hook_owner<T, Hook>(node); }
+    pointer operator->() const { return &(operator*()); }
+
+    self& operator++()
+    {
+        incr();
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        incr();
+        return tmp;
+    }
+};
+
+template <class T, slist_hook T::*Hook>
+class intrusive_slist {
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    typedef __intrusive_slist_iterator<T, Hook, T&, T*> iterator;
+    typedef __intrusive_slist_iterator<T, Hook, const T&, const T*> const_iterator;
+
+private:
+    slist_hook head;    // 头部, 注意不是指针
+
+public:
+    intrusive_slist() { head.next = 0; }
+    ~intrusive_slist() { clear(); }
+
+public:
+    // before_begin() 不可提领, 只用于 insert_after/erase_after 操作第一个元素
+    iterator before_begin() { return iterator(&head); }
+    iterator begin() { return iterator(head.next); }
+    iterator end() { return iterator(0); }
+    size_type size() const { return __slist_size(head.next); }
+    bool empty() const { return head.next == 0; }
+
+    reference front() { return *begin(); }
+
+    iterator iterator_to(reference x) { return iterator(&(x.*Hook)); }
+
+    void push_front(reference x) { __slist_make_link(&head, &(x.*Hook)); }
+
+    void pop_front()
+    {
+        slist_hook* node = head.next;
+        head.next = node->next;
+        node->next = 0;
+    }
+
+    // 将 x 串接于 position 之后. 不配置内存
+    iterator insert_after(iterator position, reference x)
+    {
+        return iterator(__slist_make_link(position.node, &(x.*Hook)));
+    }
+
+    // 摘下 position 之后的那个元素. 不析构元素, 不释放内存
+    iterator erase_after(iterator position)
+    {
+        slist_hook* next = position.node->next;
+        position.node->next = next->next;
+        next->next = 0;
+        return iterator(position.node->next);
+    }
+
+    // 摘下所有元素
+    void clear()
+    {
+        slist_hook* cur = head.next;
+        while (cur != 0) {
+            slist_hook* next = cur->next;
+            cur->next = 0;
+            cur = next;
+        }
+        head.next = 0;
+    }
+
+    void swap(intrusive_slist& L)
+    {
+        slist_hook* tmp = head.next;
+        head.next = L.head.next;
+        L.head.next = tmp;
+    }
+
+private:
+    intrusive_slist(const intrusive_slist&);
+    intrusive_slist& operator=(const intrusive_slist&);
+};
+
+#endif /* __STL_INTRUSIVE_SLIST_H */
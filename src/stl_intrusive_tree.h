@@ -0,0 +1,305 @@
+#ifndef __STL_INTRUSIVE_TREE_H
+#define __STL_INTRUSIVE_TREE_H
+
+#include <cstddef>
+
+#include "../src/stl_pair.h"
+#include "../src/stl_config.h"
+#include "../src/stl_iterator.h"
+#include "../src/stl_tree.h"
+
+// 侵入式红黑树
+// 用户对象内嵌一个 rb_tree_hook (亦即 __rb_tree_node_base, 含颜色/父/左/右),
+// 容器不配置节点, 直接以 __rb_tree_rebalance() 和 __rb_tree_rebalance_for_erase()
+// 维持平衡. 同一个对象可以内嵌多个 hook, 同时出现在多棵树中
+//
+// 用法:
+//     struct conn {
+//         int fd;
+//         long deadline;
+//         rb_tree_hook by_fd;
+//         rb_tree_hook by_deadline;
+//     };
+//     struct conn_fd { const int& operator()(const conn& c) const { return c.fd; } };
+//     intrusive_rb_tree<int, conn, &conn::by_fd, conn_fd, less<int> > table;
+
+typedef __rb_tree_node_base rb_tree_hook;
+
+template <class Value, rb_tree_hook Value::*Hook>
+inline Value* __rb_tree_hook_owner(const rb_tree_hook* h)
+{
+    const size_t offset = (size_t)&(((Value*)0)->*Hook);
+    return (Value*)((char*)h - offset);
+}
+
+// 迭代器的 increment()/decrement() 完全沿用 __rb_tree_base_iterator
+template <class Value, rb_tree_hook Value::*Hook, class Ref, class Ptr>
+struct __intrusive_rb_tree_iterator : public __rb_tree_base_iterator {
+    typedef Value value_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+    typedef __intrusive_rb_tree_iterator<Value, Hook, Value&, Value*> iterator;
+    typedef __intrusive_rb_tree_iterator<Value, Hook, const Value&, const Value*> const_iterator;
+    typedef __intrusive_rb_tree_iterator<Value, Hook, Ref, Ptr> self;
+
+    __intrusive_rb_tree_iterator() { }
+    __intrusive_rb_tree_iterator(base_ptr x) { node = x; }
+    __intrusive_rb_tree_iterator(const iterator& it) { node = it.node; }
+
+    reference operator*() const { return *__rb_tree_hook_owner<Value, Hook>(node); }
+    pointer operator->() const { return &(operator*()); }
+
+    self& operator++() { increment(); return *this; }
+    self operator++(int) { self tmp = *this; increment(); return tmp; }
+
+    self& operator--() { decrement(); return *this; }
+    self operator--(int) { self tmp = *this; decrement(); return tmp; }
+};
+
+template <class Key, class Value, rb_tree_hook Value::*Hook,
+          class KeyOfValue, class Compare>
+class intrusive_rb_tree {
+protected:
+    typedef __rb_tree_node_base* base_ptr;
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    typedef __intrusive_rb_tree_iterator<Value, Hook, Value&, Value*> iterator;
+    typedef __intrusive_rb_tree_iterator<Value, Hook, const Value&, const Value*>
+        const_iterator;
+
+protected:
+    size_type node_count;
+    rb_tree_hook header;    // 与 rb_tree 的 header 同样用途, 但内嵌于容器, 不必配置
+    Compare key_compare;
+
+    base_ptr& root() { return header.parent_slot(); }
+    base_ptr& leftmost() { return header.left; }
+    base_ptr& rightmost() { return header.right; }
+    base_ptr root() const { return header.get_parent(); }
+
+    static const Key& key(base_ptr x)
+    {
+        return KeyOfValue()(*__rb_tree_hook_owner<Value, Hook>(x));
+    }
+
+    void init()
+    {
+        header.set_color(__rb_tree_red);    // 用来区分 header 和 root, 见 decrement()
+        header.parent_slot() = 0;
+        header.left = &header;
+        header.right = &header;
+    }
+
+    iterator __link(base_ptr x, base_ptr y, reference v);
+
+public:
+    intrusive_rb_tree(const Compare& comp = Compare()) : node_count(0), key_compare(comp)
+    {
+        init();
+    }
+    ~intrusive_rb_tree() { clear(); }
+
+    Compare key_comp() const { return key_compare; }
+    iterator begin() { return header.left; }
+    iterator end() { return &header; }
+    const_iterator begin() const { return header.left; }
+    const_iterator end() const { return const_cast<base_ptr>(&header); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+
+    iterator iterator_to(reference v) { return &(v.*Hook); }
+
+public:
+    // 以下插入操作都不配置节点. v 的 hook 此前不得已串接于本树
+    pair<iterator, bool> insert_unique(reference v);
+    iterator insert_equal(reference v);
+
+    // 摘下节点. 不析构元素, 不释放内存
+    void erase(iterator position)
+    {
+        base_ptr y = __rb_tree_rebalance_for_erase(position.node,
+                                                   header.parent_slot(),
+                                                   header.left,
+                                                   header.right);
+        y->left = y->right = 0;
+        y->set_parent(0);
+        --node_count;
+    }
+    void erase(reference v) { erase(iterator_to(v)); }
+    size_type erase(const key_type& k);
+
+    // 摘下所有节点. 逐一重置 hook, 不做任何再平衡
+    void clear()
+    {
+        __unlink(root());
+        init();
+        node_count = 0;
+    }
+
+public:
+    iterator find(const Key& k);
+    iterator lower_bound(const Key& k);
+    iterator upper_bound(const Key& k);
+    pair<iterator, iterator> equal_range(const Key& k)
+    {
+        return pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+    }
+    size_type count(const Key& k)
+    {
+        pair<iterator, iterator> p = equal_range(k);
+        size_type n = 0;
+        for ( ; p.first != p.second; ++p.first) ++n;
+        return n;
+    }
+
+private:
+    static void __unlink(base_ptr x)
+    {
+        while (x != 0) {
+            __unlink(x->right);
+            base_ptr y = x->left;
+            x->left = x->right = 0;
+            x->set_parent(0);
+            x = y;
+        }
+    }
+
+    intrusive_rb_tree(const intrusive_rb_tree&);
+    intrusive_rb_tree& operator=(const intrusive_rb_tree&);
+};
+
+// 与 rb_tree::__insert() 相同, 只是节点由用户提供
+template <class K, class V, rb_tree_hook V::*H, class KoV, class Cmp>
+typename intrusive_rb_tree<K, V, H, KoV, Cmp>::iterator
+intrusive_rb_tree<K, V, H, KoV, Cmp>::__link(base_ptr x, base_ptr y, reference v)
+{
+    base_ptr z = &(v.*H);
+    if (y == &header || x != 0 || key_compare(KoV()(v), key(y))) {
+        y->left = z;        // 这使得当 y 即为 header 时, leftmost() = z
+        if (y == &header) {
+            root() = z;
+            rightmost() = z;
+        } else if (y == leftmost()) {
+            leftmost() = z;
+        }
+    } else {
+        y->right = z;
+        if (y == rightmost()) {
+            rightmost() = z;
+        }
+    }
+    z->set_parent(y);
+    z->left = 0;
+    z->right = 0;
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    z->size = 1;
+    for (base_ptr p = y; p != &header; p = p->get_parent()) {
+        ++p->size;
+    }
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+    __rb_tree_rebalance(z, header.parent_slot());
+    ++node_count;
+    return iterator(z);
+}
+
+template <class K, class V, rb_tree_hook V::*H, class KoV, class Cmp>
+pair<typename intrusive_rb_tree<K, V, H, KoV, Cmp>::iterator, bool>
+intrusive_rb_tree<K, V, H, KoV, Cmp>::insert_unique(reference v)
+{
+    base_ptr y = &header;
+    base_ptr x = root();
+    bool comp = true;
+    while (x != 0) {
+        y = x;
+        comp = key_compare(KoV()(v), key(x));
+        x = comp ? x->left : x->right;
+    }
+    iterator j = iterator(y);
+    if (comp) {
+        if (j == begin()) {
+            return pair<iterator, bool>(__link(x, y, v), true);
+        } else {
+            --j;
+        }
+    }
+    if (key_compare(key(j.node), KoV()(v))) {
+        return pair<iterator, bool>(__link(x, y, v), true);
+    }
+    return pair<iterator, bool>(j, false);
+}
+
+template <class K, class V, rb_tree_hook V::*H, class KoV, class Cmp>
+typename intrusive_rb_tree<K, V, H, KoV, Cmp>::iterator
+intrusive_rb_tree<K, V, H, KoV, Cmp>::insert_equal(reference v)
+{
+    base_ptr y = &header;
+    base_ptr x = root();
+    while (x != 0) {
+        y = x;
+        x = key_compare(KoV()(v), key(x)) ? x->left : x->right;
+    }
+    return __link(x, y, v);
+}
+
+template <class K, class V, rb_tree_hook V::*H, class KoV, class Cmp>
+typename intrusive_rb_tree<K, V, H, KoV, Cmp>::size_type
+intrusive_rb_tree<K, V, H, KoV, Cmp>::erase(const key_type& k)
+{
+    pair<iterator, iterator> p = equal_range(k);
+    size_type n = 0;
+    while (p.first != p.second) {
+        erase(p.first++);
+        ++n;
+    }
+    return n;
+}
+
+template <class K, class V, rb_tree_hook V::*H, class KoV, class Cmp>
+typename intrusive_rb_tree<K, V, H, KoV, Cmp>::iterator
+intrusive_rb_tree<K, V, H, KoV, Cmp>::find(const K& k)
+{
+    iterator j = lower_bound(k);
+    return (j == end() || key_compare(k, key(j.node))) ? end() : j;
+}
+
+template <class K, class V, rb_tree_hook V::*H, class KoV, class Cmp>
+typename intrusive_rb_tree<K, V, H, KoV, Cmp>::iterator
+intrusive_rb_tree<K, V, H, KoV, Cmp>::lower_bound(const K& k)
+{
+    base_ptr y = &header;   // last node which is not less than k
+    base_ptr x = root();
+    while (x != 0) {
+        if (!key_compare(key(x), k)) {
+            y = x, x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+    return iterator(y);
+}
+
+template <class K, class V, rb_tree_hook V::*H, class KoV, class Cmp>
+typename intrusive_rb_tree<K, V, H, KoV, Cmp>::iterator
+intrusive_rb_tree<K, V, H, KoV, Cmp>::upper_bound(const K& k)
+{
+    base_ptr y = &header;   // last node which is greater than k
+    base_ptr x = root();
+    while (x != 0) {
+        if (key_compare(k, key(x))) {
+            y = x, x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+    return iterator(y);
+}
+
+#endif /* __STL_INTRUSIVE_TREE_H */
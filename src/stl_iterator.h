@@ -109,6 +109,13 @@ inline typename iterator_traits<InputIterator>::difference_type
     return __distance(first, last, category());
 }
 
+// 旧式的 distance(), 将结果累加到 n. stl_algo.h 和 stl_tempbuf.h 仍在使用
+template <class InputIterator, class Distance>
+inline void distance(InputIterator first, InputIterator last, Distance& n)
+{
+    n += cstl::distance(first, last);
+}
+
 // 以下是整组 advance 函数
 template <class InputIterator, class Distance>
 inline void __advance(InputIterator& i, Distance n, bidirectional_iterator_tag)
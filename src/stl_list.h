@@ -17,6 +17,22 @@ struct __list_node {
     T data;
 };
 
+// 全局函数: 将 [first, last) 内的所有节点移动到 position 之前
+// 只调整指针, 不配置也不释放任何节点. list 与 intrusive_list 共用
+template <class LinkType>
+inline void __list_transfer(LinkType position, LinkType first, LinkType last)
+{
+    if (position != last) {
+        (*(LinkType((*last).prev))).next = position;
+        (*(LinkType((*first).prev))).next = last;
+        (*(LinkType((*position).prev))).next = first;
+        LinkType tmp = LinkType((*position).prev);
+        (*position).prev = (*last).prev;
+        (*last).prev = (*first).prev;
+        (*first).prev = tmp;
+    }
+}
+
 // list 迭代器
 template <class T, class Ref, class Ptr>
 struct __list_iterator {
@@ -217,15 +233,7 @@ protected:
     // 将 [first, last) 内的所有元素移动到 position 之前
     void transfer(iterator position, iterator first, iterator last)
     {
-        if (position != last) {
-            (*(link_type((*last.node).prev))).next = position.node;
-            (*(link_type((*first.node).prev))).next = last.node;
-            (*(link_type((*position.node).prev))).next = first.node;
-            link_type tmp = link_type((*position.node).prev);
-            (*position.node).prev = (*last.node).prev;
-            (*last.node).prev = (*first.node).prev;
-            (*first.node).prev = tmp;
-        }
+        __list_transfer(position.node, first.node, last.node);
     }
 };
 
@@ -48,6 +48,7 @@ public:
     typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
     typedef typename rep_type::size_type size_type;
     typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::node_type node_type;
 
     // allocation/deallocation
     // 注意, map 一定使用底层 RB-tree 的 insert_unique() 而非 insert_equal()
@@ -120,6 +121,12 @@ public:
     void erase(iterator first, iterator last) { t.erase(first, last); }
     void clear() { t.clear(); }
 
+    // 节点把手: 在容器之间搬移元素, 或者修改键值后放回, 都不必配置节点或复制元素
+    node_type extract(iterator position) { return t.extract(position); }
+    node_type extract(const key_type& x) { return t.extract(x); }
+    pair<iterator, bool> insert(const node_type& nh) { return t.insert_unique(nh); }
+    void merge(map<Key, T, Compare, Alloc>& src) { t.merge_unique(src.t); }
+
     // map operations:
     
     iterator find(const key_type& x) { return t.find(x); }
@@ -130,6 +137,11 @@ public:
     {
         return t.lower_bound(x);
     }
+    iterator upper_bound(const key_type& x) { return t.upper_bound(x); }
+    const_iterator upper_bound(const key_type& x) const
+    {
+        return t.upper_bound(x);
+    }
 
     pair<iterator, iterator> equal_range(const key_type& x)
     {
@@ -140,6 +152,68 @@ public:
     {
         return t.equal_range(x);
     }
+
+    // 异质查找: 仅当 Compare 定义了 is_transparent 时参与重载决议, 见 stl_tree.h
+    template <class K>
+    typename __if_transparent<Compare, K, iterator>::type find(const K& x) { return t.find(x); }
+    template <class K>
+    typename __if_transparent<Compare, K, const_iterator>::type find(const K& x) const
+    {
+        return t.find(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, size_type>::type count(const K& x) const
+    {
+        return t.count(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, iterator>::type lower_bound(const K& x)
+    {
+        return t.lower_bound(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, const_iterator>::type lower_bound(const K& x) const
+    {
+        return t.lower_bound(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, iterator>::type upper_bound(const K& x)
+    {
+        return t.upper_bound(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, const_iterator>::type upper_bound(const K& x) const
+    {
+        return t.upper_bound(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& x)
+    {
+        return t.equal_range(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, pair<const_iterator, const_iterator> >::type
+    equal_range(const K& x) const
+    {
+        return t.equal_range(x);
+    }
+
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    // 顺序统计, 皆为 O(log n). 需要定义 __STL_RB_TREE_SUBTREE_SIZE, 见 stl_config.h
+    iterator select(size_type k) { return t.select(k); }
+    const_iterator select(size_type k) const { return t.select(k); }
+    size_type rank(const key_type& x) const { return t.rank(x); }
+    difference_type distance(const_iterator first, const_iterator last) const
+    {
+        return t.distance(first, last);
+    }
+    iterator advance(iterator it, difference_type n) { return t.advance(it, n); }
+    const_iterator advance(const_iterator it, difference_type n) const
+    {
+        return t.advance(it, n);
+    }
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
     friend bool operator== __STL_NULL_TMPL_ARGS (const map&, const map&);
     friend bool operator< __STL_NULL_TMPL_ARGS (const map&, const map&);
 };
@@ -0,0 +1,315 @@
+#ifndef __STL_MPMC_QUEUE_H
+#define __STL_MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <climits>
+
+#if defined(__linux__)
+#   include <unistd.h>
+#   include <sys/syscall.h>
+#   include <linux/futex.h>
+#else
+#   include <thread>
+#endif
+
+#include "../src/stl_config.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_construct.h"
+
+// 多生产者/多消费者有界无锁队列 (Dmitry Vyukov 的 bounded MPMC queue)
+// 环形数组的每个槽位(cell)带一个序号 sequence:
+//   sequence == pos       表示槽位空闲, 生产者可以写入位置 pos
+//   sequence == pos + 1   表示槽位已写入, 消费者可以读出位置 pos
+// 读出后消费者把 sequence 设为 pos + capacity, 留给下一圈的生产者
+// 生产者与消费者只在 enqueue_pos / dequeue_pos 上各自竞争一次 CAS
+
+enum { __mpmc_cache_line = 64 };   // 用于隔开 enqueue_pos 与 dequeue_pos, 避免伪共享
+enum { __mpmc_spin_count = 128 };  // 阻塞版本在休眠前的自旋次数
+
+// futex 等待/唤醒. 非 linux 平台退化为让出 CPU
+inline void __mpmc_futex_wait(std::atomic<int>* addr, int expected)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, (int*)addr, FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
+#else
+    if (addr->load(std::memory_order_acquire) == expected) {
+        std::this_thread::yield();
+    }
+#endif
+}
+
+inline void __mpmc_futex_wake(std::atomic<int>* addr)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, (int*)addr, FUTEX_WAKE_PRIVATE, INT_MAX, 0, 0, 0);
+#else
+    (void)addr;
+#endif
+}
+
+template <class T>
+struct __mpmc_cell {
+    std::atomic<size_t> sequence;
+    T data;     // 只有在 sequence == pos + 1 时才是已构造的对象
+};
+
+template <class T, class Alloc = alloc>
+class mpmc_queue {
+public:
+    typedef T value_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+
+private:
+    typedef __mpmc_cell<T> cell;
+    typedef simple_alloc<cell, Alloc> cell_allocator;
+
+    // 每个热点成员独占一条 cache line
+    char pad0[__mpmc_cache_line];
+    cell* buffer;
+    size_type mask;
+    char pad1[__mpmc_cache_line - sizeof(cell*) - sizeof(size_type)];
+    std::atomic<size_type> enqueue_pos;
+    char pad2[__mpmc_cache_line - sizeof(std::atomic<size_type>)];
+    std::atomic<size_type> dequeue_pos;
+    char pad3[__mpmc_cache_line - sizeof(std::atomic<size_type>)];
+
+    // 阻塞版本使用的 futex 字及其等待者计数
+    std::atomic<int> not_full;
+    std::atomic<int> full_waiters;
+    std::atomic<int> not_empty;
+    std::atomic<int> empty_waiters;
+
+    // 容量上调至 2 的幂, 以便用 & mask 取代 % capacity
+    static size_type round_up(size_type n)
+    {
+        size_type result = 2;
+        while (result < n) result <<= 1;
+        return result;
+    }
+
+public:
+    explicit mpmc_queue(size_type n)
+        : mask(round_up(n) - 1), enqueue_pos(0), dequeue_pos(0),
+          not_full(0), full_waiters(0), not_empty(0), empty_waiters(0)
+    {
+        buffer = cell_allocator::allocate(mask + 1);
+        for (size_type i = 0; i <= mask; ++i) {
+            construct(&buffer[i].sequence, i);
+        }
+    }
+
+    ~mpmc_queue()
+    {
+        // 析构尚未取出的元素
+        size_type last = enqueue_pos.load(std::memory_order_relaxed);
+        for (size_type pos = dequeue_pos.load(std::memory_order_relaxed); pos != last; ++pos) {
+            destroy(&buffer[pos & mask].data);
+        }
+        cell_allocator::deallocate(buffer, mask + 1);
+    }
+
+    size_type capacity() const { return mask + 1; }
+
+    // 近似值: 并发情况下只能作为参考
+    size_type size() const
+    {
+        size_type head = dequeue_pos.load(std::memory_order_relaxed);
+        size_type tail = enqueue_pos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+    bool empty() const { return size() == 0; }
+
+public:
+    // 非阻塞: 队列满时立即返回 false
+    bool try_push(const value_type& x)
+    {
+        cell* c;
+        size_type pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            c = &buffer[pos & mask];
+            size_type seq = c->sequence.load(std::memory_order_acquire);
+            ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)pos;
+            if (dif == 0) {         // 槽位空闲, 尝试占有位置 pos
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {   // 上一圈的元素还未被取走: 队列已满
+                return false;
+            } else {                // 被其他生产者抢先, 重新读取位置
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        construct(&c->data, x);
+        c->sequence.store(pos + 1, std::memory_order_release);
+        notify(not_empty, empty_waiters);
+        return true;
+    }
+
+    // 非阻塞: 队列空时立即返回 false
+    bool try_pop(value_type& x)
+    {
+        cell* c;
+        size_type pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            c = &buffer[pos & mask];
+            size_type seq = c->sequence.load(std::memory_order_acquire);
+            ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+            if (dif == 0) {         // 槽位已写入, 尝试占有位置 pos
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {   // 生产者尚未写入: 队列为空
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        x = c->data;
+        destroy(&c->data);
+        c->sequence.store(pos + mask + 1, std::memory_order_release);
+        notify(not_full, full_waiters);
+        return true;
+    }
+
+    // 批量写入 [first, last): 一次 CAS 占有连续的若干槽位. 返回实际写入的个数
+    template <class ForwardIterator>
+    size_type try_push_batch(ForwardIterator first, ForwardIterator last);
+
+    // 批量取出最多 n 个元素写到 result. 返回实际取出的个数
+    template <class OutputIterator>
+    size_type try_pop_batch(OutputIterator result, size_type n);
+
+    // 阻塞: 先自旋, 仍然失败就在 futex 上休眠, 直到有空位
+    void push(const value_type& x)
+    {
+        for (int i = 0; i < __mpmc_spin_count; ++i) {
+            if (try_push(x)) return;
+        }
+        while (!wait_push(x)) { }
+    }
+
+    // 阻塞: 先自旋, 仍然失败就在 futex 上休眠, 直到有元素
+    void pop(value_type& x)
+    {
+        for (int i = 0; i < __mpmc_spin_count; ++i) {
+            if (try_pop(x)) return;
+        }
+        while (!wait_pop(x)) { }
+    }
+
+private:
+    // 先登记为等待者, 再重试一次, 最后才休眠. 与 notify() 中的 fence 配对,
+    // 保证 "操作完成后才看到等待者为 0" 与 "登记后重试看到操作" 二者必居其一
+    bool wait_push(const value_type& x)
+    {
+        full_waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int seq = not_full.load(std::memory_order_acquire);
+        bool done = try_push(x);
+        if (!done) __mpmc_futex_wait(&not_full, seq);
+        full_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return done;
+    }
+
+    bool wait_pop(value_type& x)
+    {
+        empty_waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int seq = not_empty.load(std::memory_order_acquire);
+        bool done = try_pop(x);
+        if (!done) __mpmc_futex_wait(&not_empty, seq);
+        empty_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return done;
+    }
+
+    // 只有确实有人在等待时才进入内核
+    static void notify(std::atomic<int>& word, std::atomic<int>& waiters)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) != 0) {
+            word.fetch_add(1, std::memory_order_release);
+            __mpmc_futex_wake(&word);
+        }
+    }
+
+private:
+    // 禁止复制
+    mpmc_queue(const mpmc_queue&);
+    mpmc_queue& operator=(const mpmc_queue&);
+};
+
+template <class T, class Alloc>
+template <class ForwardIterator>
+typename mpmc_queue<T, Alloc>::size_type
+mpmc_queue<T, Alloc>::try_push_batch(ForwardIterator first, ForwardIterator last)
+{
+    size_type total = 0;
+    while (first != last) {
+        size_type pos = enqueue_pos.load(std::memory_order_relaxed);
+        size_type n = 0;
+        // 从 pos 开始, 数出连续空闲且不超过剩余元素个数的槽位
+        ForwardIterator cur = first;
+        for ( ; cur != last && n <= mask; ++cur, ++n) {
+            size_type seq = buffer[(pos + n) & mask].sequence.load(std::memory_order_acquire);
+            if (seq != pos + n) break;
+        }
+        if (n == 0) {
+            size_type seq = buffer[pos & mask].sequence.load(std::memory_order_acquire);
+            if ((ptrdiff_t)seq - (ptrdiff_t)pos < 0) break;     // 队列已满
+            continue;                                           // 被抢先, 重试
+        }
+        // 一次占有 [pos, pos + n). 成功之后, 其他生产者无法再碰这些槽位
+        if (!enqueue_pos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            continue;
+        }
+        for (size_type i = 0; i < n; ++i, ++first) {
+            cell* c = &buffer[(pos + i) & mask];
+            construct(&c->data, *first);
+            c->sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        total += n;
+    }
+    if (total != 0) notify(not_empty, empty_waiters);
+    return total;
+}
+
+template <class T, class Alloc>
+template <class OutputIterator>
+typename mpmc_queue<T, Alloc>::size_type
+mpmc_queue<T, Alloc>::try_pop_batch(OutputIterator result, size_type n)
+{
+    size_type total = 0;
+    while (total < n) {
+        size_type pos = dequeue_pos.load(std::memory_order_relaxed);
+        size_type k = 0;
+        // 从 pos 开始, 数出连续已写入的槽位
+        for ( ; total + k < n && k <= mask; ++k) {
+            size_type seq = buffer[(pos + k) & mask].sequence.load(std::memory_order_acquire);
+            if (seq != pos + k + 1) break;
+        }
+        if (k == 0) {
+            size_type seq = buffer[pos & mask].sequence.load(std::memory_order_acquire);
+            if ((ptrdiff_t)seq - (ptrdiff_t)(pos + 1) < 0) break;  // 队列为空
+            continue;
+        }
+        if (!dequeue_pos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+            continue;
+        }
+        for (size_type i = 0; i < k; ++i, ++result) {
+            cell* c = &buffer[(pos + i) & mask];
+            *result = c->data;
+            destroy(&c->data);
+            c->sequence.store(pos + i + mask + 1, std::memory_order_release);
+        }
+        total += k;
+    }
+    if (total != 0) notify(not_full, full_waiters);
+    return total;
+}
+
+#endif /* __STL_MPMC_QUEUE_H */
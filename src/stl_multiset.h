@@ -37,6 +37,7 @@ public:
     typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
     typedef typename rep_type::size_type size_type;
     typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::node_type node_type;
 
     // allocation/deallocation
     // 注意, multiset 一定使用 insert_equal() 而不使用 insert_unique()
@@ -107,6 +108,16 @@ public:
     }
     void clear() { t.clear(); }
 
+    // 节点把手: 在容器之间搬移元素, 或者修改键值后放回, 都不必配置节点或复制元素
+    node_type extract(iterator position)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        return t.extract((rep_iterator&)position);
+    }
+    node_type extract(const key_type& x) { return t.extract(x); }
+    iterator insert(const node_type& nh) { return t.insert_equal(nh); }
+    void merge(multiset<Key, Compare, Alloc>& src) { t.merge_equal(src.t); }
+
     // multiset operations
     iterator find(const key_type& x) const { return t.find(x); }
     size_type count(const key_type& x) const { return t.count(x); }
@@ -122,6 +133,45 @@ public:
     {
         return t.equal_range(x);
     }
+
+    // 异质查找: 仅当 Compare 定义了 is_transparent 时参与重载决议, 见 stl_tree.h
+    template <class K>
+    typename __if_transparent<Compare, K, iterator>::type find(const K& x) const
+    {
+        return t.find(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, size_type>::type count(const K& x) const
+    {
+        return t.count(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, iterator>::type lower_bound(const K& x) const
+    {
+        return t.lower_bound(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, iterator>::type upper_bound(const K& x) const
+    {
+        return t.upper_bound(x);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& x) const
+    {
+        return t.equal_range(x);
+    }
+
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    // 顺序统计, 皆为 O(log n). 需要定义 __STL_RB_TREE_SUBTREE_SIZE, 见 stl_config.h
+    iterator select(size_type k) const { return t.select(k); }
+    size_type rank(const key_type& x) const { return t.rank(x); }
+    difference_type distance(iterator first, iterator last) const
+    {
+        return t.distance(first, last);
+    }
+    iterator advance(iterator it, difference_type n) const { return t.advance(it, n); }
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
     // 以下的 __STL_NULL_TMPL_ARGS 被定义为 <>, 详见 1.9.1 节
     friend bool operator== __STL_NULL_TMPL_ARGS (const multiset&, const multiset&);
     friend bool operator< __STL_NULL_TMPL_ARGS (const multiset&, const multiset&);
@@ -0,0 +1,117 @@
+#ifndef __STL_PERSISTENT_MAP_H
+#define __STL_PERSISTENT_MAP_H
+
+#include "../src/stl_function.h"
+#include "../src/stl_pair.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_persistent_tree.h"
+
+// 持久化的 map: 复制为 O(1), 复制之后两者各自修改, 互不影响, 见 stl_persistent_tree.h.
+// 可以随时以复制的方式保留一个快照(snapshot), 代价只是后续修改路径上的节点复制.
+//
+// 没有 operator[]: 元素可能为多个版本所共享, 不能交出可修改的引用. 以 insert_or_assign() 代之
+template <class Key, class T, class Compare = less<Key>, class Alloc = malloc_alloc>
+class persistent_map {
+public:
+    // typedefs:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<const Key, T> value_type;
+    typedef Compare key_compare;
+
+    class value_compare : public binary_function<value_type, value_type, bool> {
+        friend class persistent_map<Key, T, Compare, Alloc>;
+    protected:
+        Compare comp;
+        value_compare(Compare c) : comp(c) { }
+    public:
+        bool operator() (const value_type& x, const value_type& y) const
+        {
+            return comp(x.first, y.first);
+        }
+    };
+
+private:
+    typedef persistent_tree<key_type, value_type,
+                            select1st<value_type>, key_compare, Alloc> rep_type;
+    rep_type t;
+
+public:
+    typedef typename rep_type::pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::reverse_iterator reverse_iterator;
+    typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    // allocation/deallocation
+    persistent_map() : t(Compare()) { }
+    explicit persistent_map(const Compare& comp) : t(comp) { }
+
+    template <class InputIterator>
+    persistent_map(InputIterator first, InputIterator last)
+        : t(Compare()) { t.insert_unique(first, last); }
+
+    template <class InputIterator>
+    persistent_map(InputIterator first, InputIterator last, const Compare& comp)
+        : t(comp) { t.insert_unique(first, last); }
+
+    // O(1), 与 x 共享所有节点
+    persistent_map(const persistent_map<Key, T, Compare, Alloc>& x) : t(x.t) { }
+    persistent_map<Key, T, Compare, Alloc>&
+    operator=(const persistent_map<Key, T, Compare, Alloc>& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+    // accessors:
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+    const_iterator begin() const { return t.begin(); }
+    const_iterator end() const { return t.end(); }
+    const_reverse_iterator rbegin() const { return t.rbegin(); }
+    const_reverse_iterator rend() const { return t.rend(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+    void swap(persistent_map<Key, T, Compare, Alloc>& x) { t.swap(x.t); }
+    bool same_version(const persistent_map<Key, T, Compare, Alloc>& x) const
+    {
+        return t.same_version(x.t);
+    }
+
+    // insert/erase
+    pair<iterator, bool> insert(const value_type& x) { return t.insert_unique(x); }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_unique(first, last);
+    }
+    iterator insert_or_assign(const key_type& k, const T& obj)
+    {
+        return t.insert_or_assign(value_type(k, obj));
+    }
+
+    void erase(iterator position) { t.erase(position); }
+    size_type erase(const key_type& x) { return t.erase(x); }
+    void erase(iterator first, iterator last) { t.erase(first, last); }
+    void clear() { t.clear(); }
+
+    // map operations:
+    const_iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    pair<const_iterator, const_iterator> equal_range(const key_type& x) const
+    {
+        return t.equal_range(x);
+    }
+};
+
+#endif /* __STL_PERSISTENT_MAP_H */
@@ -0,0 +1,96 @@
+#ifndef __STL_PERSISTENT_SET_H
+#define __STL_PERSISTENT_SET_H
+
+#include "../src/stl_function.h"
+#include "../src/stl_pair.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_persistent_tree.h"
+
+// 持久化的 set: 复制为 O(1), 复制之后两者各自修改, 互不影响, 见 stl_persistent_tree.h
+template <class Key, class Compare = less<Key>, class Alloc = malloc_alloc>
+class persistent_set {
+public:
+    // typedefs:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+
+private:
+    typedef persistent_tree<key_type, value_type,
+                            identity<value_type>, key_compare, Alloc> rep_type;
+    rep_type t;
+
+public:
+    typedef typename rep_type::const_pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::const_reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::const_iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::const_reverse_iterator reverse_iterator;
+    typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    // allocation/deallocation
+    persistent_set() : t(Compare()) { }
+    explicit persistent_set(const Compare& comp) : t(comp) { }
+
+    template <class InputIterator>
+    persistent_set(InputIterator first, InputIterator last)
+        : t(Compare()) { t.insert_unique(first, last); }
+
+    template <class InputIterator>
+    persistent_set(InputIterator first, InputIterator last, const Compare& comp)
+        : t(comp) { t.insert_unique(first, last); }
+
+    // O(1), 与 x 共享所有节点
+    persistent_set(const persistent_set<Key, Compare, Alloc>& x) : t(x.t) { }
+    persistent_set<Key, Compare, Alloc>& operator=(const persistent_set<Key, Compare, Alloc>& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+    // accessors:
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    reverse_iterator rbegin() const { return t.rbegin(); }
+    reverse_iterator rend() const { return t.rend(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+    void swap(persistent_set<Key, Compare, Alloc>& x) { t.swap(x.t); }
+    bool same_version(const persistent_set<Key, Compare, Alloc>& x) const
+    {
+        return t.same_version(x.t);
+    }
+
+    // insert/erase
+    pair<iterator, bool> insert(const value_type& x) { return t.insert_unique(x); }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_unique(first, last);
+    }
+
+    void erase(iterator position) { t.erase(position); }
+    size_type erase(const key_type& x) { return t.erase(x); }
+    void erase(iterator first, iterator last) { t.erase(first, last); }
+    void clear() { t.clear(); }
+
+    // set operations:
+    iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    pair<iterator, iterator> equal_range(const key_type& x) const
+    {
+        return t.equal_range(x);
+    }
+};
+
+#endif /* __STL_PERSISTENT_SET_H */
@@ -0,0 +1,614 @@
+#ifndef __STL_PERSISTENT_TREE_H
+#define __STL_PERSISTENT_TREE_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "../src/stl_config.h"
+#include "../src/stl_pair.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_construct.h"
+#include "../src/stl_iterator.h"
+
+// 持久化(persistent)平衡树, 供 persistent_set/persistent_map 使用
+// 节点带引用计数, 可以同时属于多个版本. 复制整个容器只是让新容器指向同一个根并把根的
+// 引用计数加 1, O(1); 修改时只复制自根至修改点的路径上被共享的节点, O(log n),
+// 其余节点仍与其他版本共享. 引用计数为 1 的节点只属于本版本, 就地修改, 不复制.
+//
+// 平衡方式为 AVL: 没有父节点指针, 节点才可能被多个父节点共享.
+// 迭代器记下自根至当前节点的整条路径, 因此是双向的.
+//
+// 注意:
+// - 元素不能经由迭代器修改(迭代器都是 const_iterator)
+// - 修改容器会使指向它的迭代器失效, 但不影响由它复制出去的其他版本及其迭代器
+// - 引用计数是原子的: 共享节点的不同版本可以交给不同线程使用, 但同一个容器对象本身
+//   不是线程安全的. 共享节点可能由任何一个线程释放, 所以缺省使用 malloc_alloc
+//   (第二级配置器的 free list 不是线程安全的)
+
+enum { __ptree_max_height = 64 };   // 高度 64 的 AVL 树至少有约 2.7e13 个节点
+
+template <class Value>
+struct __ptree_node {
+    typedef __ptree_node<Value>* link_type;
+    link_type left;
+    link_type right;
+    std::atomic<size_t> refcount;   // 指向本节点的父节点及容器的个数
+    int height;
+    Value value_field;
+};
+
+template <class Value>
+struct __ptree_iterator {
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const Value& reference;
+    typedef const Value* pointer;
+    typedef __ptree_iterator<Value> self;
+    typedef __ptree_node<Value>* link_type;
+
+    link_type root;
+    link_type path[__ptree_max_height];     // path[0] 为根, path[depth - 1] 为当前节点
+    int depth;                              // depth == 0 表示 end()
+
+    __ptree_iterator() : root(0), depth(0) { }
+    explicit __ptree_iterator(link_type r) : root(r), depth(0) { }
+
+    void push_left(link_type x)
+    {
+        for ( ; x != 0; x = x->left) path[depth++] = x;
+    }
+    void push_right(link_type x)
+    {
+        for ( ; x != 0; x = x->right) path[depth++] = x;
+    }
+
+    reference operator*() const { return path[depth - 1]->value_field; }
+    pointer operator->() const { return &(operator*()); }
+
+    // 有右子树时, 后继是右子树的最左节点; 否则往上找第一个 "自左边上来" 的祖先
+    self& operator++()
+    {
+        link_type x = path[depth - 1];
+        if (x->right != 0) {
+            push_left(x->right);
+        } else {
+            do {
+                x = path[--depth];
+            } while (depth > 0 && path[depth - 1]->right == x);
+        }
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    // end() 的前驱为最右节点
+    self& operator--()
+    {
+        if (depth == 0) {
+            push_right(root);
+            return *this;
+        }
+        link_type x = path[depth - 1];
+        if (x->left != 0) {
+            push_right(x->left);
+        } else {
+            do {
+                x = path[--depth];
+            } while (depth > 0 && path[depth - 1]->left == x);
+        }
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    bool operator==(const self& x) const
+    {
+        return depth == 0 ? x.depth == 0
+                          : (x.depth != 0 && path[depth - 1] == x.path[x.depth - 1]);
+    }
+    bool operator!=(const self& x) const { return !(*this == x); }
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = malloc_alloc>
+class persistent_tree {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef const value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef const value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    typedef __ptree_iterator<value_type> const_iterator;
+    typedef const_iterator iterator;
+
+#ifdef __STL_CLASS_PARTIAL_SPECIALIZATION
+    typedef reverse_iterator<const_iterator> const_reverse_iterator;
+#else /* __STL_CLASS_PARTIAL_SPECIALIZATION */
+    typedef reverse_bidirectional_iterator<const_iterator, value_type,
+                                         const_reference, difference_type>
+          const_reverse_iterator;
+#endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
+    typedef const_reverse_iterator reverse_iterator;
+
+protected:
+    typedef __ptree_node<Value> node;
+    typedef node* link_type;
+    typedef simple_alloc<node, Alloc> node_allocator;
+
+    link_type root;
+    size_type node_count;
+    Compare key_compare;
+
+    static const Key& key(link_type x) { return KeyOfValue()(x->value_field); }
+    static int height(link_type x) { return x == 0 ? 0 : x->height; }
+
+    link_type __create_node(const value_type& v, link_type l, link_type r)
+    {
+        link_type tmp = node_allocator::allocate();
+        __STL_TRY {
+            construct(&tmp->value_field, v);
+        }
+        __STL_UNWIND(node_allocator::deallocate(tmp));
+        tmp->left = l;
+        tmp->right = r;
+        new (&tmp->refcount) std::atomic<size_t>(1);    // 配置来的是未经构造的内存
+        __update(tmp);
+        return tmp;
+    }
+
+    static void __acquire(link_type x)
+    {
+        if (x != 0) x->refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 引用计数降为 0 时析构并释放节点, 再释放它对两个子节点的引用
+    static void __release(link_type x)
+    {
+        while (x != 0 && x->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            __release(x->right);
+            link_type y = x->left;
+            destroy(&x->value_field);
+            node_allocator::deallocate(x);
+            x = y;
+        }
+    }
+
+    // slot 是一个可写节点的子节点指针(或者是根). 若 *slot 只属于本版本, 直接返回;
+    // 否则复制一份, 先以副本取代 slot 中的 x, 再放弃对 x 的引用.
+    // 复制失败时什么也没有改变
+    link_type __mutable(link_type& slot)
+    {
+        link_type x = slot;
+        if (x->refcount.load(std::memory_order_acquire) == 1) return x;
+        link_type y = __create_node(x->value_field, x->left, x->right);
+        __acquire(x->left);
+        __acquire(x->right);
+        slot = y;
+        __release(x);       // 不会降为 0: x 仍属于其他版本(或恰好在此时由其他版本放弃)
+        return y;
+    }
+
+    // 修改之前, 自上而下先把这次修改会改动的节点全部换成可写版本: 插入时只有路径上的节点,
+    // 删除时还有旋转会用到的兄弟节点. 复制或比较抛出异常时, 树的内容与结构都不变,
+    // 只是有些共享节点换成了只属于本版本的副本. 之后的 __insert/__assign/__erase
+    // 不再复制节点, 不会在修改到一半时失败
+    void __prepare_insert(const key_type& k);
+    void __prepare_erase(const key_type& k);
+    // 从 c 那一侧删除之后, 父节点可能要往 c 那一侧旋转: s 较高时, s 与双旋转会用到的
+    // s 的内侧子节点都要可写. s_is_right 表示 s 是右子节点
+    void __prepare_rotation(link_type& s, link_type c, bool s_is_right)
+    {
+        if (height(s) <= height(c)) return;
+        link_type y = __mutable(s);
+        if (s_is_right ? height(y->right) < height(y->left)
+                       : height(y->left) < height(y->right)) {
+            __mutable(s_is_right ? y->left : y->right);
+        }
+    }
+
+    static void __update(link_type x)
+    {
+        int hl = height(x->left), hr = height(x->right);
+        x->height = (hl > hr ? hl : hr) + 1;
+    }
+    link_type __rotate_left(link_type x);
+    link_type __rotate_right(link_type x);
+    link_type __balance(link_type x);
+
+    // 以下的 x 都是可写节点. 修改时自上而下先取得可写版本, 引用计数才能正确判断
+    // 一个节点是否只属于本版本
+    link_type __insert(link_type x, const value_type& v);
+    link_type __assign(link_type x, const value_type& v, bool& inserted);
+    link_type __erase(link_type x, const key_type& k);
+    link_type __erase_min(link_type x, link_type& min);
+
+    link_type __find(const key_type& k) const
+    {
+        link_type x = root;
+        while (x != 0) {
+            if (key_compare(k, key(x))) {
+                x = x->left;
+            } else if (key_compare(key(x), k)) {
+                x = x->right;
+            } else {
+                return x;
+            }
+        }
+        return 0;
+    }
+
+public:     // allocation/deallocation
+    persistent_tree(const Compare& comp = Compare())
+        : root(0), node_count(0), key_compare(comp) { }
+
+    // O(1): 与 x 共享所有节点
+    persistent_tree(const persistent_tree& x)
+        : root(x.root), node_count(x.node_count), key_compare(x.key_compare)
+    {
+        __acquire(root);
+    }
+    persistent_tree& operator=(const persistent_tree& x)
+    {
+        __acquire(x.root);      // 先加后减, 以免 x 即为 *this
+        __release(root);
+        root = x.root;
+        node_count = x.node_count;
+        key_compare = x.key_compare;
+        return *this;
+    }
+    ~persistent_tree() { __release(root); }
+
+public:     // accessors
+    Compare key_comp() const { return key_compare; }
+    const_iterator begin() const
+    {
+        const_iterator it(root);
+        it.push_left(root);
+        return it;
+    }
+    const_iterator end() const { return const_iterator(root); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+    size_type max_size() const { return size_type(-1); }
+    void swap(persistent_tree& t)
+    {
+        std::swap(root, t.root);
+        std::swap(node_count, t.node_count);
+        std::swap(key_compare, t.key_compare);
+    }
+    // 两者是否为同一版本(共享同一个根). O(1)
+    bool same_version(const persistent_tree& t) const { return root == t.root; }
+
+public:     // set operations
+    const_iterator find(const key_type& k) const
+    {
+        const_iterator it = lower_bound(k);
+        return (it == end() || key_compare(k, key(it.path[it.depth - 1]))) ? end() : it;
+    }
+    size_type count(const key_type& k) const { return __find(k) == 0 ? 0 : 1; }
+    const_iterator lower_bound(const key_type& k) const;
+    const_iterator upper_bound(const key_type& k) const;
+    pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+    }
+
+public:     // insert/erase
+    pair<const_iterator, bool> insert_unique(const value_type& v);
+    template <class InputIterator>
+    void insert_unique(InputIterator first, InputIterator last)
+    {
+        for ( ; first != last; ++first) insert_unique(*first);
+    }
+    // 键值已存在时以 v 取代原有元素
+    const_iterator insert_or_assign(const value_type& v);
+    size_type erase(const key_type& k);
+    // 删除会改变树的结构, 使所有迭代器失效, 所以先复制键值, 删除之后再以键值重新定位
+    void erase(const_iterator position)
+    {
+        const key_type k = KeyOfValue()(*position);
+        erase(k);
+    }
+    void erase(const_iterator first, const_iterator last);
+    void clear()
+    {
+        __release(root);
+        root = 0;
+        node_count = 0;
+    }
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::const_iterator
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::lower_bound(const key_type& k) const
+{
+    // 走过的路径全部记下. 最后一个不小于 k 的节点之后的部分不属于结果, 截去
+    const_iterator it(root);
+    int result = 0;
+    link_type x = root;
+    while (x != 0) {
+        it.path[it.depth++] = x;
+        if (!key_compare(key(x), k)) {
+            result = it.depth;
+            x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+    it.depth = result;
+    return it;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::const_iterator
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::upper_bound(const key_type& k) const
+{
+    const_iterator it(root);
+    int result = 0;
+    link_type x = root;
+    while (x != 0) {
+        it.path[it.depth++] = x;
+        if (key_compare(k, key(x))) {
+            result = it.depth;
+            x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+    it.depth = result;
+    return it;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::__rotate_left(link_type x)
+{
+    link_type y = __mutable(x->right);
+    x->right = y->left;
+    y->left = x;
+    __update(x);
+    __update(y);
+    return y;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::__rotate_right(link_type x)
+{
+    link_type y = __mutable(x->left);
+    x->left = y->right;
+    y->right = x;
+    __update(x);
+    __update(y);
+    return y;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::__balance(link_type x)
+{
+    int diff = height(x->left) - height(x->right);
+    if (diff > 1) {
+        if (height(x->left->left) < height(x->left->right)) {
+            x->left = __rotate_left(__mutable(x->left));
+        }
+        return __rotate_right(x);
+    }
+    if (diff < -1) {
+        if (height(x->right->right) < height(x->right->left)) {
+            x->right = __rotate_right(__mutable(x->right));
+        }
+        return __rotate_left(x);
+    }
+    __update(x);
+    return x;
+}
+
+// 调用者已确定 v 的键值不在树中
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::__insert(link_type x, const value_type& v)
+{
+    if (key_compare(KeyOfValue()(v), key(x))) {
+        x->left = x->left != 0 ? __insert(__mutable(x->left), v) : __create_node(v, 0, 0);
+    } else {
+        x->right = x->right != 0 ? __insert(__mutable(x->right), v) : __create_node(v, 0, 0);
+    }
+    return __balance(x);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::__assign(link_type x, const value_type& v,
+                                                                  bool& inserted)
+{
+    if (key_compare(KeyOfValue()(v), key(x))) {
+        if (x->left != 0) {
+            x->left = __assign(__mutable(x->left), v, inserted);
+        } else {
+            x->left = __create_node(v, 0, 0);
+            inserted = true;
+        }
+    } else if (key_compare(key(x), KeyOfValue()(v))) {
+        if (x->right != 0) {
+            x->right = __assign(__mutable(x->right), v, inserted);
+        } else {
+            x->right = __create_node(v, 0, 0);
+            inserted = true;
+        }
+    } else {
+        // 键值可能为 const (如 map 的 pair<const Key, T>), 不能就地赋值: 以新节点取代 x
+        link_type y = __create_node(v, x->left, x->right);
+        x->left = x->right = 0;
+        __release(x);
+        return y;
+    }
+    return __balance(x);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::__erase_min(link_type x, link_type& min)
+{
+    if (x->left == 0) {
+        min = x;
+        link_type r = x->right;
+        x->right = 0;
+        return r;
+    }
+    x->left = __erase_min(__mutable(x->left), min);
+    return __balance(x);
+}
+
+// 调用者已确定 k 在树中
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::__erase(link_type x, const key_type& k)
+{
+    if (key_compare(k, key(x))) {
+        x->left = __erase(__mutable(x->left), k);
+        return __balance(x);
+    }
+    if (key_compare(key(x), k)) {
+        x->right = __erase(__mutable(x->right), k);
+        return __balance(x);
+    }
+    link_type l = x->left;
+    link_type r = x->right;
+    if (l != 0 && r != 0) {
+        // 以右子树的最小节点取代 x
+        link_type min;
+        r = __erase_min(__mutable(x->right), min);
+        min->left = l;
+        min->right = r;
+        l = __balance(min);
+        r = 0;
+    }
+    // x 只属于本版本, 此时即被释放; 两个子树的引用已交给 l 或 r
+    x->left = x->right = 0;
+    __release(x);
+    return l != 0 ? l : r;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::__prepare_insert(const key_type& k)
+{
+    link_type* slot = &root;
+    while (*slot != 0) {
+        link_type x = __mutable(*slot);
+        if (key_compare(k, key(x))) {
+            slot = &x->left;
+        } else if (key_compare(key(x), k)) {
+            slot = &x->right;
+        } else {
+            return;
+        }
+    }
+}
+
+// 调用者已确定 k 在树中. 各层的旋转只发生在删除的一侧变矮而另一侧原本较高时
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::__prepare_erase(const key_type& k)
+{
+    link_type x = __mutable(root);
+    for (;;) {
+        if (key_compare(k, key(x))) {
+            __prepare_rotation(x->right, x->left, true);
+            x = __mutable(x->left);
+        } else if (key_compare(key(x), k)) {
+            __prepare_rotation(x->left, x->right, false);
+            x = __mutable(x->right);
+        } else {
+            break;
+        }
+    }
+    if (x->left == 0 || x->right == 0) return;
+    // x 由右子树的最小节点取代, 那一侧变矮
+    __prepare_rotation(x->left, x->right, false);
+    x = __mutable(x->right);
+    while (x->left != 0) {
+        __prepare_rotation(x->right, x->left, true);
+        x = __mutable(x->left);
+    }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+pair<typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::const_iterator, bool>
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const value_type& v)
+{
+    // 先查找: 键值已存在时不复制任何节点
+    const_iterator it = find(KeyOfValue()(v));
+    if (it != end()) {
+        return pair<const_iterator, bool>(it, false);
+    }
+    __prepare_insert(KeyOfValue()(v));
+    root = root != 0 ? __insert(root, v) : __create_node(v, 0, 0);
+    ++node_count;
+    return pair<const_iterator, bool>(find(KeyOfValue()(v)), true);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::const_iterator
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_or_assign(const value_type& v)
+{
+    bool inserted = false;
+    __prepare_insert(KeyOfValue()(v));
+    if (root != 0) {
+        root = __assign(root, v, inserted);
+    } else {
+        root = __create_node(v, 0, 0);
+        inserted = true;
+    }
+    if (inserted) ++node_count;
+    return find(KeyOfValue()(v));
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::erase(const_iterator first,
+                                                                    const_iterator last)
+{
+    if (first == begin() && last == end()) {
+        clear();
+        return;
+    }
+    if (last == end()) {
+        while (first != end()) {
+            const key_type k = KeyOfValue()(*first);
+            erase(k);
+            first = lower_bound(k);
+        }
+    } else {
+        const key_type stop = KeyOfValue()(*last);
+        while (key_compare(KeyOfValue()(*first), stop)) {
+            const key_type k = KeyOfValue()(*first);
+            erase(k);
+            first = lower_bound(k);
+        }
+    }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::erase(const key_type& k)
+{
+    if (__find(k) == 0) return 0;
+    __prepare_erase(k);
+    root = __erase(root, k);
+    --node_count;
+    return 1;
+}
+
+#endif /* __STL_PERSISTENT_TREE_H */
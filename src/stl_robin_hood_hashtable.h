@@ -0,0 +1,437 @@
+#ifndef __STL_ROBIN_HOOD_HASHTABLE_H
+#define __STL_ROBIN_HOOD_HASHTABLE_H
+
+#include <cstddef>
+
+#include "../src/stl_config.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_construct.h"
+#include "../src/stl_iterator.h"
+#include "../src/stl_pair.h"
+#include "../src/stl_hash_fun.h"
+
+// 线性探测(linear probing)的开放定址杂凑表, 以 Robin Hood 规则平衡探测距离,
+// 供 robin_hood_set/robin_hood_map 使用.
+// 元素直接存放于 slot 数组中, 另有一个平行的 info 数组记录每个元素与其本位(home slot)
+// 的距离: 0 表示空, 1 表示就在本位, 2 表示在本位之后一格, 依此类推.
+// 插入时沿探测序列前进, 遇到距离比自己小的元素("富者")就占下它的位置, 把它往后挤("劫富济贫").
+// 于是所有元素的探测距离相差不多, 负载高达 9/10 时查找仍然很短; 查找时一旦遇到距离
+// 比当前探测距离小的 slot, 即可断定键值不存在, 不必走到空 slot 为止.
+// 删除时把其后不在本位的元素逐一往前挪一格(backward-shift deletion), 不留删除标记.
+//
+// 注意:
+// - 探测不绕回表头: slot 数组在 capacity 个本位之后另有至多 255 个溢出 slot,
+//   探测距离超过 255 或者走出数组尾端时就扩大表格. 所以迭代顺序就是 slot 的顺序
+//   (因此超过 255 个键值的杂凑值完全相同时无法容纳, 最终以 bad_alloc 告终)
+// - 插入会移动其他元素, 使所有迭代器失效, 元素的地址也会改变
+// - 删除会把其后的元素往前挪: erase(it) 返回原处的迭代器, 边走访边删除时以返回值继续即可
+// - max_probe_length() 为查找成功时最多需要看几个 slot, 是上次重新配置以来的上界
+
+typedef unsigned char __rht_info_type;
+
+template <class Value, class Ref, class Ptr>
+struct __robin_hood_iterator {
+    typedef __robin_hood_iterator<Value, Value&, Value*> iterator;
+    typedef __robin_hood_iterator<Value, const Value&, const Value*> const_iterator;
+    typedef __robin_hood_iterator<Value, Ref, Ptr> self;
+
+    typedef forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+
+    const __rht_info_type* info;        // 当前 slot 的距离
+    const __rht_info_type* info_end;    // info 数组的尾端, 即 end()
+    Value* slot;
+
+    __robin_hood_iterator() : info(0), info_end(0), slot(0) { }
+    __robin_hood_iterator(const __rht_info_type* i, const __rht_info_type* e, Value* s)
+        : info(i), info_end(e), slot(s) { }
+    __robin_hood_iterator(const iterator& it)
+        : info(it.info), info_end(it.info_end), slot(it.slot) { }
+
+    // 跳过空的 slot
+    void skip_empty()
+    {
+        while (info != info_end && *info == 0) {
+            ++info;
+            ++slot;
+        }
+    }
+
+    reference operator*() const { return *slot; }
+    pointer operator->() const { return &(operator*()); }
+    self& operator++()
+    {
+        ++info;
+        ++slot;
+        skip_empty();
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    bool operator==(const self& x) const { return info == x.info; }
+    bool operator!=(const self& x) const { return info != x.info; }
+};
+
+template <class Value, class Key, class HashFcn,
+          class ExtractKey, class EqualKey, class Alloc = alloc>
+class robin_hood_hashtable {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef HashFcn hasher;
+    typedef EqualKey key_equal;
+
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+
+    typedef __robin_hood_iterator<Value, Value&, Value*> iterator;
+    typedef __robin_hood_iterator<Value, const Value&, const Value*> const_iterator;
+
+    hasher hash_funct() const { return hash; }
+    key_equal key_eq() const { return equals; }
+
+private:
+    typedef __rht_info_type info_type;
+    typedef simple_alloc<value_type, Alloc> slot_allocator;
+    typedef simple_alloc<info_type, Alloc> info_allocator;
+
+    enum { max_distance = 255 };
+
+    hasher hash;
+    key_equal equals;
+    ExtractKey get_key;
+
+    // info 共有 num_slots + 1 个, 最后一个恒为 0, 作为查找与删除的哨兵
+    info_type* info;
+    value_type* slots;
+    size_type capacity;         // 本位的个数: 0 或者 2 的幂次
+    size_type num_slots;        // capacity 加上尾端的溢出 slot
+    size_type num_elements;
+    size_type max_dist;         // 目前元素中最大的 info 值 (的上界)
+
+    static size_type max_load(size_type n) { return n - n / 10; }
+    static size_type overflow(size_type n)
+    {
+        return n < size_type(max_distance) ? n : size_type(max_distance);
+    }
+
+    size_type home(const key_type& k) const
+    {
+        return __stl_hash_mix(hash(k)) & (capacity - 1);
+    }
+
+    size_type find_index(const key_type& k) const;
+    size_type insert_noresize(const value_type& obj);
+    void drop(size_type first, size_type last);
+    void rehash(size_type n);
+    void initialize(size_type n);
+
+public:
+    robin_hood_hashtable(size_type n, const HashFcn& hf, const EqualKey& eql)
+        : hash(hf), equals(eql), get_key(ExtractKey()),
+          info(0), slots(0), capacity(0), num_slots(0), num_elements(0), max_dist(0)
+    {
+        reserve(n);
+    }
+    robin_hood_hashtable(const robin_hood_hashtable& ht)
+        : hash(ht.hash), equals(ht.equals), get_key(ht.get_key),
+          info(0), slots(0), capacity(0), num_slots(0), num_elements(0), max_dist(0)
+    {
+        copy_from(ht);
+    }
+    robin_hood_hashtable& operator=(const robin_hood_hashtable& ht)
+    {
+        if (&ht != this) {
+            robin_hood_hashtable tmp(ht);
+            swap(tmp);
+        }
+        return *this;
+    }
+    ~robin_hood_hashtable()
+    {
+        clear();
+        deallocate();
+    }
+
+    size_type size() const { return num_elements; }
+    size_type max_size() const { return size_type(-1) / sizeof(value_type); }
+    bool empty() const { return size() == 0; }
+    size_type bucket_count() const { return capacity; }
+    size_type max_probe_length() const { return max_dist; }
+
+    void swap(robin_hood_hashtable& ht)
+    {
+        std::swap(hash, ht.hash);
+        std::swap(equals, ht.equals);
+        std::swap(get_key, ht.get_key);
+        std::swap(info, ht.info);
+        std::swap(slots, ht.slots);
+        std::swap(capacity, ht.capacity);
+        std::swap(num_slots, ht.num_slots);
+        std::swap(num_elements, ht.num_elements);
+        std::swap(max_dist, ht.max_dist);
+    }
+
+    iterator begin()
+    {
+        iterator it(info, info + num_slots, slots);
+        it.skip_empty();
+        return it;
+    }
+    iterator end() { return iterator(info + num_slots, info + num_slots, slots + num_slots); }
+    const_iterator begin() const
+    {
+        const_iterator it(info, info + num_slots, slots);
+        it.skip_empty();
+        return it;
+    }
+    const_iterator end() const
+    {
+        return const_iterator(info + num_slots, info + num_slots, slots + num_slots);
+    }
+
+    // 预留至少能容纳 n 个元素而不必重新配置的空间
+    void reserve(size_type n);
+
+    pair<iterator, bool> insert_unique(const value_type& obj);
+    template <class InputIterator>
+    void insert_unique(InputIterator f, InputIterator l)
+    {
+        for ( ; f != l; ++f) insert_unique(*f);
+    }
+
+    iterator find(const key_type& key)
+    {
+        size_type i = find_index(key);
+        return iterator(info + i, info + num_slots, slots + i);
+    }
+    const_iterator find(const key_type& key) const
+    {
+        size_type i = find_index(key);
+        return const_iterator(info + i, info + num_slots, slots + i);
+    }
+    size_type count(const key_type& key) const
+    {
+        return find_index(key) != num_slots ? 1 : 0;
+    }
+
+    size_type erase(const key_type& key)
+    {
+        size_type i = find_index(key);
+        if (i == num_slots) return 0;
+        erase_index(i);
+        return 1;
+    }
+    // 返回原处的迭代器: 后面的元素可能已经挪到这个位置
+    iterator erase(const const_iterator& it)
+    {
+        size_type i = it.slot - slots;
+        erase_index(i);
+        iterator result(info + i, info + num_slots, slots + i);
+        result.skip_empty();
+        return result;
+    }
+    void erase_index(size_type i);
+    void clear();
+
+private:
+    void copy_from(const robin_hood_hashtable& ht);
+    void deallocate()
+    {
+        if (capacity != 0) {
+            info_allocator::deallocate(info, num_slots + 1);
+            slot_allocator::deallocate(slots, num_slots);
+        }
+    }
+};
+
+// 探测距离每走一步加 1; 遇到距离比它小的 slot (包括空 slot 与尾端的哨兵), 键值若存在,
+// 插入时早就占下这个位置了
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename robin_hood_hashtable<V, K, HF, Ex, Eq, A>::size_type
+robin_hood_hashtable<V, K, HF, Ex, Eq, A>::find_index(const key_type& k) const
+{
+    if (capacity == 0) return 0;
+    size_type i = home(k);
+    for (size_type d = 1; info[i] >= d; ++i, ++d) {
+        if (info[i] == d && equals(get_key(slots[i]), k)) return i;
+    }
+    return num_slots;
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void robin_hood_hashtable<V, K, HF, Ex, Eq, A>::initialize(size_type n)
+{
+    const size_type total = n + overflow(n);
+    info = info_allocator::allocate(total + 1);
+    __STL_TRY {
+        slots = slot_allocator::allocate(total);
+    }
+    __STL_UNWIND(info_allocator::deallocate(info, total + 1));
+    for (size_type i = 0; i <= total; ++i) info[i] = 0;
+    capacity = n;
+    num_slots = total;
+    num_elements = 0;
+    max_dist = 0;
+}
+
+// 销毁 [first, last] 中的元素. 用于移动元素时发生异常: 移动到一半的区段中出现了空洞,
+// 空洞之后的元素再也找不到, 只能放弃
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void robin_hood_hashtable<V, K, HF, Ex, Eq, A>::drop(size_type first, size_type last)
+{
+    for ( ; first <= last; ++first) {
+        ::destroy(slots + first);
+        info[first] = 0;
+        --num_elements;
+    }
+}
+
+// 不检查负载. 插入位置之后直到第一个空 slot 的元素整体后移一格, 距离各加 1,
+// 相当于逐一与"富者"交换. 距离超过 max_distance 或者走出数组尾端时什么也不做,
+// 返回 num_slots, 由调用者扩大表格
+template <class V, class K, class HF, class Ex, class Eq, class A>
+typename robin_hood_hashtable<V, K, HF, Ex, Eq, A>::size_type
+robin_hood_hashtable<V, K, HF, Ex, Eq, A>::insert_noresize(const value_type& obj)
+{
+    size_type pos = home(get_key(obj));
+    size_type d = 1;
+    for ( ; info[pos] >= d; ++pos, ++d) { }
+    if (d > max_distance) return num_slots;
+
+    size_type last = pos;
+    size_type new_max = d > max_dist ? d : max_dist;
+    for ( ; last < num_slots && info[last] != 0; ++last) {
+        if (info[last] + 1u > max_distance) return num_slots;
+        if (info[last] + 1u > new_max) new_max = info[last] + 1u;
+    }
+    if (last == num_slots) return num_slots;
+
+    if (last == pos) {
+        construct(slots + pos, obj);    // 不必搬移, 失败时什么也没有改动
+    } else {
+        // 先复制 obj 再搬移: 复制失败时表格原封不动, 不致连累后面的元素
+        value_type tmp(obj);
+        size_type i = last;
+        __STL_TRY {
+            for ( ; i > pos; --i) {
+                construct(slots + i, slots[i - 1]);
+                info[i] = info_type(info[i - 1] + 1);
+                ::destroy(slots + i - 1);
+                info[i - 1] = 0;
+            }
+            construct(slots + pos, tmp);
+        }
+        __STL_UNWIND(drop(i + 1, last));
+    }
+    info[pos] = info_type(d);
+    max_dist = new_max;
+    ++num_elements;
+    return pos;
+}
+
+// 把所有元素搬到容量为 n 的新数组中. 新数组中若仍有探测距离溢出, 再加倍.
+// 复制元素时若发生异常, 新数组整个放弃, 原有内容不受影响
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void robin_hood_hashtable<V, K, HF, Ex, Eq, A>::rehash(size_type n)
+{
+    for (;;) {
+        robin_hood_hashtable tmp(0, hash, equals);
+        tmp.initialize(n);
+        size_type i = 0;
+        for ( ; i < num_slots; ++i) {
+            if (info[i] != 0 && tmp.insert_noresize(slots[i]) == tmp.num_slots) break;
+        }
+        if (i == num_slots) {
+            swap(tmp);
+            return;
+        }
+        n *= 2;
+    }
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void robin_hood_hashtable<V, K, HF, Ex, Eq, A>::reserve(size_type n)
+{
+    if (n == 0) return;
+    size_type cap = 16;
+    while (max_load(cap) < n) cap *= 2;
+    if (cap > capacity) rehash(cap);
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+pair<typename robin_hood_hashtable<V, K, HF, Ex, Eq, A>::iterator, bool>
+robin_hood_hashtable<V, K, HF, Ex, Eq, A>::insert_unique(const value_type& obj)
+{
+    size_type i = find_index(get_key(obj));
+    if (i != num_slots) {
+        return pair<iterator, bool>(iterator(info + i, info + num_slots, slots + i), false);
+    }
+    if (num_elements + 1 > max_load(capacity)) {
+        rehash(capacity != 0 ? capacity * 2 : 16);
+    }
+    while ((i = insert_noresize(obj)) == num_slots) {
+        rehash(capacity * 2);
+    }
+    return pair<iterator, bool>(iterator(info + i, info + num_slots, slots + i), true);
+}
+
+// 后面不在本位的元素逐一往前挪一格, 距离各减 1, 直到遇到空 slot 或者在本位的元素
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void robin_hood_hashtable<V, K, HF, Ex, Eq, A>::erase_index(size_type i)
+{
+    ::destroy(slots + i);
+    --num_elements;
+    size_type k = i + 1;
+    __STL_TRY {
+        for ( ; info[k] > 1; ++k) {
+            construct(slots + k - 1, slots[k]);
+            info[k - 1] = info_type(info[k] - 1);
+            ::destroy(slots + k);
+        }
+    }
+    __STL_UNWIND(info[k - 1] = 0;
+                 size_type last = k;
+                 while (info[last + 1] > 1) ++last;
+                 drop(k, last));
+    info[k - 1] = 0;
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void robin_hood_hashtable<V, K, HF, Ex, Eq, A>::clear()
+{
+    for (size_type i = 0; i < num_slots; ++i) {
+        if (info[i] != 0) {
+            ::destroy(slots + i);
+            info[i] = 0;
+        }
+    }
+    num_elements = 0;
+    max_dist = 0;
+}
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+void robin_hood_hashtable<V, K, HF, Ex, Eq, A>::copy_from(const robin_hood_hashtable& ht)
+{
+    if (ht.num_elements == 0) return;
+    reserve(ht.num_elements);
+    __STL_TRY {
+        for (const_iterator it = ht.begin(); it != ht.end(); ++it) {
+            insert_unique(*it);
+        }
+    }
+    __STL_UNWIND(clear(); deallocate());
+}
+
+#endif /* __STL_ROBIN_HOOD_HASHTABLE_H */
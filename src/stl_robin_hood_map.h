@@ -0,0 +1,102 @@
+#ifndef __STL_ROBIN_HOOD_MAP_H
+#define __STL_ROBIN_HOOD_MAP_H
+
+#include "../src/stl_robin_hood_hashtable.h"
+#include "../src/stl_hash_fun.h"
+#include "../src/stl_function.h"
+#include "../src/stl_config.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_pair.h"
+
+// 与 hash_map 的接口相近, 只是以 Robin Hood 线性探测的 robin_hood_hashtable 取代 hashtable,
+// 见 stl_robin_hood_hashtable.h. 适合整数之类小而便宜的键值, 负载可以高达 9/10
+// 注意: 插入使所有迭代器失效, 元素的地址也可能改变; erase(it) 返回原处的迭代器
+template <class Key,
+          class T,
+          class HashFcn = hash<Key>,
+          class EqualKey = equal_to<Key>,
+          class Alloc = alloc>
+class robin_hood_map {
+private:
+    typedef robin_hood_hashtable<pair<const Key, T>, Key, HashFcn,
+                           select1st<pair<const Key, T> >, EqualKey, Alloc> ht;
+    ht rep;
+
+public:
+    typedef typename ht::key_type key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef typename ht::value_type value_type;
+    typedef typename ht::hasher hasher;
+    typedef typename ht::key_equal key_equal;
+
+    typedef typename ht::size_type size_type;
+    typedef typename ht::difference_type difference_type;
+    typedef typename ht::pointer pointer;
+    typedef typename ht::const_pointer const_pointer;
+    typedef typename ht::reference reference;
+    typedef typename ht::const_reference const_reference;
+
+    typedef typename ht::iterator iterator;
+    typedef typename ht::const_iterator const_iterator;
+
+    hasher hash_funct() const { return rep.hash_funct(); }
+    key_equal key_eq() const { return rep.key_eq(); }
+
+public:
+    // n 为预计的元素个数, 而非 bucket 个数
+    robin_hood_map() : rep(0, hasher(), key_equal()) { }
+    explicit robin_hood_map(size_type n) : rep(n, hasher(), key_equal()) { }
+    robin_hood_map(size_type n, const hasher& hf) : rep(n, hf, key_equal()) { }
+    robin_hood_map(size_type n, const hasher& hf, const key_equal& eql) : rep(n, hf, eql) { }
+
+    template <class InputIterator>
+    robin_hood_map(InputIterator f, InputIterator l)
+        : rep(0, hasher(), key_equal()) { rep.insert_unique(f, l); }
+    template <class InputIterator>
+    robin_hood_map(InputIterator f, InputIterator l, size_type n)
+        : rep(n, hasher(), key_equal()) { rep.insert_unique(f, l); }
+
+public:
+    size_type size() const { return rep.size(); }
+    size_type max_size() const { return rep.max_size(); }
+    bool empty() const { return rep.empty(); }
+    void swap(robin_hood_map& hs) { rep.swap(hs.rep); }
+
+    iterator begin() { return rep.begin(); }
+    iterator end() { return rep.end(); }
+    const_iterator begin() const { return rep.begin(); }
+    const_iterator end() const { return rep.end(); }
+
+public:
+    pair<iterator, bool> insert(const value_type& obj) { return rep.insert_unique(obj); }
+    template <class InputIterator>
+    void insert(InputIterator f, InputIterator l) { rep.insert_unique(f, l); }
+
+    iterator find(const key_type& key) { return rep.find(key); }
+    const_iterator find(const key_type& key) const { return rep.find(key); }
+
+    T& operator[](const key_type& key)
+    {
+        iterator it = rep.find(key);
+        if (it == rep.end()) {
+            it = rep.insert_unique(value_type(key, T())).first;
+        }
+        return it->second;
+    }
+
+    size_type count(const key_type& key) const { return rep.count(key); }
+
+    size_type erase(const key_type& key) { return rep.erase(key); }
+    iterator erase(const_iterator it) { return rep.erase(it); }
+    void clear() { rep.clear(); }
+
+public:
+    // 容量为 2 的幂次, 最大负载为 9/10
+    void reserve(size_type n) { rep.reserve(n); }
+    size_type bucket_count() const { return rep.bucket_count(); }
+    // 查找成功时最多需要看几个 slot
+    size_type max_probe_length() const { return rep.max_probe_length(); }
+};
+
+#endif /* __STL_ROBIN_HOOD_MAP_H */
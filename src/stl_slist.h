@@ -134,48 +134,238 @@ private:
 
 private:
     list_node_base head;    // 头部, 注意不是指针
+    list_node_base* tail;   // 最后一个节点. slist 为空时指向 head
+    size_type num_elements; // 元素个数, 使 size() 成为 O(1)
 
 public:
-    slist() { head.next = 0; }
+    slist() : tail(&head), num_elements(0) { head.next = 0; }
     ~slist() { clear(); }
 
 public:
+    // before_begin() 不可提领, 只用于 splice_after() 等操作第一个元素
+    iterator before_begin() { return iterator((list_node*)&head); }
     iterator begin() { return iterator((list_node*)head.next); }
     iterator end() { return iterator(0); }
-    size_type size() const { return __slist_size(head.next);  }
+    size_type size() const { return num_elements; }
     bool empty() const { return head.next == 0; }
     void clear();
     void insert(const iterator&, const value_type&);
     value_type* erase(const iterator&);
 
-    // 两个 slist 互换: 只要将 head 交换互指即可
+    // 两个 slist 互换: 将 head 交换互指, 再修正指向 head 的 tail
     void swap(slist& L)
     {
         list_node_base* tmp = head.next;
         head.next = L.head.next;
         L.head.next = tmp;
+
+        tmp = tail;
+        tail = L.tail == &L.head ? &head : L.tail;
+        L.tail = tmp == &head ? &L.head : tmp;
+
+        size_type n = num_elements;
+        num_elements = L.num_elements;
+        L.num_elements = n;
     }
 
 public:
     // 取头部元素
     reference front() { return ((list_node*)head.next)->data; }
+    // 取尾部元素
+    reference back() { return ((list_node*)tail)->data; }
 
     // 从头部插入元素(新元素成为 slist 的第一个元素)
     void push_front(const value_type& x)
     {
         __slist_make_link(&head, create_node(x));
+        if (tail == &head) tail = head.next;
+        ++num_elements;
     }
 
-    // 注意, 没有 push_back()
+    // 将 [first, last) 依原次序插入到头部. 先把所有新节点串成一条链,
+    // 全部构造成功后才一次接到 head 之后; 中途发生异常则整条链被销毁, slist 不变
+    template <class InputIterator>
+    void push_front(InputIterator first, InputIterator last);
+
+    // 从尾部插入元素. 借助 tail, 为 O(1)
+    void push_back(const value_type& x)
+    {
+        tail = __slist_make_link(tail, create_node(x));
+        ++num_elements;
+    }
 
     // 从头部取走元素(删除之). 修改 head
     void pop_front()
     {
         list_node* node = (list_node*)head.next;
         head.next = node->next;
+        if (tail == node) tail = &head;
         destory_node(node);
+        --num_elements;
+    }
+
+public:
+    // 将 x 的全部元素接合于 position 之后. 借助 x.tail, 为 O(1)
+    void splice_after(iterator position, slist& x)
+    {
+        if (x.empty()) return;
+        list_node_base* pos = position.node;
+        x.tail->next = pos->next;
+        pos->next = x.head.next;
+        if (tail == pos) tail = x.tail;
+        num_elements += x.num_elements;
+        x.head.next = 0;
+        x.tail = &x.head;
+        x.num_elements = 0;
+    }
+
+    // 将 x 中 prev 之后的那一个元素移到 position 之后
+    void splice_after(iterator position, slist& x, iterator prev)
+    {
+        list_node_base* pos = position.node;
+        list_node_base* node = prev.node->next;
+        if (pos == prev.node || pos == node) return;
+        prev.node->next = node->next;
+        if (x.tail == node) x.tail = prev.node;
+        --x.num_elements;
+        __slist_make_link(pos, node);
+        if (tail == pos) tail = node;
+        ++num_elements;
     }
+
+    void merge(slist& x);   // 将 x 合并到 *this 身上. 两个 slist 必须是递增的
+    void sort();            // 与 list::sort() 相同的 bottom-up merge sort
+
+private:
+    // 禁止复制: 复制 head 和 tail 并不能得到一个合法的 slist
+    slist(const slist&);
+    slist& operator=(const slist&);
 };
 
+// 全局函数: 找出 node 的前一个节点. O(n)
+inline __slist_node_base* __slist_previous(__slist_node_base* head,
+                                           const __slist_node_base* node)
+{
+    while (head && head->next != node) {
+        head = head->next;
+    }
+    return head;
+}
+
+template <class T, class Alloc>
+void slist<T, Alloc>::clear()
+{
+    list_node* cur = (list_node*)head.next;
+    while (cur != 0) {
+        list_node* tmp = cur;
+        cur = (list_node*)cur->next;
+        destory_node(tmp);
+    }
+    head.next = 0;
+    tail = &head;
+    num_elements = 0;
+}
+
+// 在 position 之前插入 x. 单向链表必须先找出前一个节点, 所以为 O(n);
+// position 为 end() 时借助 tail, 为 O(1)
+template <class T, class Alloc>
+void slist<T, Alloc>::insert(const iterator& position, const value_type& x)
+{
+    list_node_base* prev = position.node == 0 ? tail
+                                              : __slist_previous(&head, position.node);
+    list_node_base* node = __slist_make_link(prev, create_node(x));
+    if (tail == prev) tail = node;
+    ++num_elements;
+}
+
+// 删除 position 所指元素, 返回指向下一个元素值的指针(没有下一个元素时返回 0)
+template <class T, class Alloc>
+typename slist<T, Alloc>::value_type* slist<T, Alloc>::erase(const iterator& position)
+{
+    list_node_base* prev = __slist_previous(&head, position.node);
+    list_node* node = (list_node*)position.node;
+    prev->next = node->next;
+    if (tail == node) tail = prev;
+    destory_node(node);
+    --num_elements;
+    return prev->next ? &((list_node*)prev->next)->data : 0;
+}
+
+template <class T, class Alloc>
+template <class InputIterator>
+void slist<T, Alloc>::push_front(InputIterator first, InputIterator last)
+{
+    if (first == last) return;
+
+    list_node* chain = create_node(*first);
+    list_node_base* chain_tail = chain;
+    size_type n = 1;
+    __STL_TRY {
+        for (++first; first != last; ++first, ++n) {
+            chain_tail = __slist_make_link(chain_tail, create_node(*first));
+        }
+    }
+    __STL_UNWIND(
+        while (chain != 0) {
+            list_node* tmp = chain;
+            chain = (list_node*)chain->next;
+            destory_node(tmp);
+        }
+    );
+
+    chain_tail->next = head.next;
+    head.next = chain;
+    if (tail == &head) tail = chain_tail;
+    num_elements += n;
+}
+
+template <class T, class Alloc>
+void slist<T, Alloc>::merge(slist& x)
+{
+    // 注意, 两个 slist 都已经经过递增排序
+    list_node_base* n1 = &head;
+    while (n1->next != 0 && x.head.next != 0) {
+        if (((list_node*)x.head.next)->data < ((list_node*)n1->next)->data) {
+            list_node_base* node = x.head.next;
+            x.head.next = node->next;
+            __slist_make_link(n1, node);
+        }
+        n1 = n1->next;
+    }
+    if (x.head.next != 0) {     // x 剩下的元素都不小于 *this 的最后一个元素, 整段接到尾部
+        n1->next = x.head.next;
+        tail = x.tail;
+    }
+    num_elements += x.num_elements;
+    x.head.next = 0;
+    x.tail = &x.head;
+    x.num_elements = 0;
+}
+
+template <class T, class Alloc>
+void slist<T, Alloc>::sort()
+{
+    if (head.next == 0 || head.next->next == 0) return;
+
+    // 一些新的 slist, 作为中介数据存放区
+    slist carry;
+    slist counter[64];
+    int fill = 0;
+    while (!empty()) {
+        carry.splice_after(carry.before_begin(), *this, before_begin());
+        int i = 0;
+        while (i < fill && !counter[i].empty()) {
+            counter[i].merge(carry);
+            carry.swap(counter[i++]);
+        }
+        carry.swap(counter[i]);
+        if (i == fill) ++fill;
+    }
+
+    for (int i = 1; i < fill; ++i) {
+        counter[i].merge(counter[i - 1]);
+    }
+    swap(counter[fill - 1]);
+}
 
-#endif
\ No newline at end of file
+#endif /* __STL_SLIST_H */
@@ -31,6 +31,12 @@
 #ifndef __SGI_STL_INTERNAL_TEMPBUF_H
 #define __SGI_STL_INTERNAL_TEMPBUF_H
 
+#include <climits>
+#include <cstdlib>
+
+#include "stl_pair.h"
+#include "stl_iterator.h"
+#include "stl_uninitialized.h"
 
 namespace cstl
 {
@@ -100,7 +106,7 @@ private:
 
   void _M_initialize_buffer(const _Tp&, __true_type) {}
   void _M_initialize_buffer(const _Tp& val, __false_type) {
-    uninitialized_fill_n(_M_buffer, _M_len, val);
+    ::uninitialized_fill_n(_M_buffer, _M_len, val);
   }
 
 public:
@@ -120,7 +126,7 @@ public:
 
     __STL_TRY {
       _M_len = 0;
-      distance(__first, __last, _M_len);
+      cstl::distance(__first, __last, _M_len);
       _M_allocate_buffer();
       if (_M_len > 0)
         _M_initialize_buffer(*__first, _Trivial());
@@ -129,7 +135,7 @@ public:
   }
  
   ~_Temporary_buffer() {  
-    destroy(_M_buffer, _M_buffer + _M_len);
+    ::destroy(_M_buffer, _M_buffer + _M_len);
     free(_M_buffer);
   }
 
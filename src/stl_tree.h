@@ -1,10 +1,13 @@
 #ifndef __STL_TREE_H
 #define __STL_TREE_H
 
+#include <cstddef>
+
 #include "../src/stl_pair.h"
 #include "../src/stl_config.h"
 #include "../src/stl_alloc.h"
 #include "../src/stl_iterator.h"
+#include "../src/stl_function.h"
 
 typedef bool __rb_tree_color_type;
 const __rb_tree_color_type __rb_tree_red = false;   // 红色为 0
@@ -14,10 +17,52 @@ struct __rb_tree_node_base {
     typedef __rb_tree_color_type color_type;
     typedef __rb_tree_node_base* base_ptr;
 
+#ifdef __STL_RB_TREE_COMPACT_NODE
+    // 颜色放在 parent 指针的最低位: 节点至少按指针对齐, 该位原本恒为 0.
+    // 省下的 color 连同其后的 padding, 使每个节点少一个 word
+private:
+    base_ptr tagged_parent;
+public:
+    base_ptr left;          // 指向坐节点
+    base_ptr right;         // 指向右节点
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    size_t size;            // 以本节点为根的子树的节点数, 用于 select()/rank()
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+
+    base_ptr get_parent() const
+    {
+        return (base_ptr) ((size_t) tagged_parent & ~size_t(1));
+    }
+    void set_parent(base_ptr p)
+    {
+        tagged_parent = (base_ptr) ((size_t) p | ((size_t) tagged_parent & 1));
+    }
+    color_type get_color() const { return ((size_t) tagged_parent & 1) != 0; }
+    void set_color(color_type c)
+    {
+        tagged_parent = (base_ptr) (((size_t) tagged_parent & ~size_t(1)) | size_t(c));
+    }
+    // 红色为 0, 所以红色节点的 tagged_parent 即为父节点指针本身. header 永远为红色,
+    // rb_tree::root() 因此可以直接引用 header 的这一栏. 不可用于其他节点
+    base_ptr& parent_slot() { return tagged_parent; }
+    base_ptr parent_slot() const { return tagged_parent; }
+#else /* __STL_RB_TREE_COMPACT_NODE */
     color_type color;       // 节点颜色, 非红即黑
     base_ptr parent;        // RB 树的许多操作, 必须知道父节点
     base_ptr left;          // 指向坐节点
     base_ptr right;         // 指向右节点
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    size_t size;            // 以本节点为根的子树的节点数, 用于 select()/rank()
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+
+    // 一律经由以下函数存取 parent 和 color, 两种布局才能共用同一份算法
+    base_ptr get_parent() const { return parent; }
+    void set_parent(base_ptr p) { parent = p; }
+    color_type get_color() const { return color; }
+    void set_color(color_type c) { color = c; }
+    base_ptr& parent_slot() { return parent; }
+    base_ptr parent_slot() const { return parent; }
+#endif /* __STL_RB_TREE_COMPACT_NODE */
 
     static base_ptr minimum(base_ptr x)
     {
@@ -32,6 +77,19 @@ struct __rb_tree_node_base {
     }
 };
 
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+inline size_t __rb_tree_subtree_size(const __rb_tree_node_base* x)
+{
+    return x != 0 ? x->size : 0;
+}
+
+// 由两个子节点重新算出 x 的子树大小
+inline void __rb_tree_update_size(__rb_tree_node_base* x)
+{
+    x->size = __rb_tree_subtree_size(x->left) + __rb_tree_subtree_size(x->right) + 1;
+}
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+
 template <class Value>
 struct __rb_tree_node : public __rb_tree_node_base {
     typedef __rb_tree_node<Value>* link_type;
@@ -55,10 +113,10 @@ struct __rb_tree_base_iterator {
                 node = node->left;      // 即是解答
             }
         } else {                        // 如果没有右子节点. 状况(2)
-            base_ptr y = node->parent;  // 找出父节点
+            base_ptr y = node->get_parent();    // 找出父节点
             while (node == y->right) {  // 如果现行节点本身是个右子节点
                 node = y;               // 就一直上溯, 直到不是右子节点为止
-                y = y->parent;
+                y = y->get_parent();
             }
             if (node->right != y) {     // 若此时的右子节点不等于此时的父节点
                 node = y;               // 此时的父节点即为解答. 状况(3)
@@ -73,7 +131,7 @@ struct __rb_tree_base_iterator {
     // 以下其实可实现于 operator-- 内, 因为再无他处会调用此函数了
     void decrement()
     {
-        if (node->color == __rb_tree_red && node->parent->parent == node) {
+        if (node->get_color() == __rb_tree_red && node->get_parent()->get_parent() == node) {
             // 如果是红节点, 且父节点的父节点等于自己
             node = node->right;     // 右子节点即为解答. 状况(1)
 
@@ -86,10 +144,10 @@ struct __rb_tree_base_iterator {
             }
             node = y;                       // 最后即为答案
         } else {                            // 即非根节点, 亦无左子节点. 状况(3)
-            base_ptr y = node->parent;      // 找出父节点
+            base_ptr y = node->get_parent();    // 找出父节点
             while (node == y->left) {       // 当现行节点身为左子节点
                 node = y;                   // 一直交替往上走, 直到现行节点不为左子节点
-                y = y->parent;
+                y = y->get_parent();
             }
             node = y;                       // 此时之父节点即为答案
         }
@@ -133,6 +191,81 @@ inline bool operator!=(const __rb_tree_base_iterator& x, const __rb_tree_base_it
     return x.node != y.node;
 }
 
+// 节点把手(node handle), 由 rb_tree::extract() 返回
+// 它拥有一个已从树中摘下的节点: 可以修改其键值, 再以 insert 放回同一棵或另一棵树,
+// 全程不配置也不释放节点, 元素也不被复制. 把手被销毁时若仍拥有节点, 才析构并释放之.
+// 由于没有右值引用, 复制把手与 auto_ptr 一样是转移所有权, 来源随之变空
+template <class Key, class Value, class KeyOfValue, class Alloc>
+class __rb_tree_node_handle {
+    template <class K, class V, class KoV, class C, class A> friend class rb_tree;
+
+    typedef __rb_tree_node<Value>* link_type;
+    typedef simple_alloc<__rb_tree_node<Value>, Alloc> rb_tree_node_allocator;
+
+    mutable link_type node;
+
+    explicit __rb_tree_node_handle(link_type p) : node(p) { }
+    link_type release() const
+    {
+        link_type p = node;
+        node = 0;
+        return p;
+    }
+
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+
+    __rb_tree_node_handle() : node(0) { }
+    __rb_tree_node_handle(const __rb_tree_node_handle& x) : node(x.release()) { }
+    __rb_tree_node_handle& operator=(const __rb_tree_node_handle& x)
+    {
+        if (&x != this) {
+            clear();
+            node = x.release();
+        }
+        return *this;
+    }
+    ~__rb_tree_node_handle() { clear(); }
+
+    bool empty() const { return node == 0; }
+    value_type& value() const { return node->value_field; }
+    // 键值可以修改(对 map 而言即 pair 中的 const Key), 放回树中时才依新键值定位
+    key_type& key() const { return const_cast<key_type&>(KeyOfValue()(node->value_field)); }
+    void swap(__rb_tree_node_handle& x) { std::swap(node, x.node); }
+
+    void clear()
+    {
+        if (node != 0) {
+            destory(&node->value_field);
+            rb_tree_node_allocator::deallocate(node);
+            node = 0;
+        }
+    }
+};
+
+// 以下全局函数定义于后. rb_tree 的成员函数以非相依(non-dependent)的 base_ptr 调用它们,
+// 名称查找发生在模板定义之处, 所以必须先声明
+inline bool __rb_tree_rebalance(__rb_tree_node_base* x, __rb_tree_node_base*& root);
+inline __rb_tree_node_base*
+__rb_tree_rebalance_for_erase(__rb_tree_node_base* z, __rb_tree_node_base*& root,
+                              __rb_tree_node_base*& leftmost, __rb_tree_node_base*& rightmost);
+inline int __rb_tree_black_height(const __rb_tree_node_base* x);
+inline int __rb_tree_root_black_height(const __rb_tree_node_base* x);
+inline int __rb_tree_child_height(int h, const __rb_tree_node_base* c);
+inline __rb_tree_node_base*
+__rb_tree_join(__rb_tree_node_base* l, __rb_tree_node_base* k, __rb_tree_node_base* r);
+inline __rb_tree_node_base*
+__rb_tree_join(__rb_tree_node_base* l, __rb_tree_node_base* r);
+inline __rb_tree_node_base*
+__rb_tree_join(__rb_tree_node_base* l, int hl, __rb_tree_node_base* k,
+               __rb_tree_node_base* r, int hr, int& h);
+inline __rb_tree_node_base*
+__rb_tree_join(__rb_tree_node_base* l, int hl, __rb_tree_node_base* r, int hr, int& h);
+inline void
+__rb_tree_split_before(__rb_tree_node_base* t, __rb_tree_node_base* n,
+                       __rb_tree_node_base*& lo, __rb_tree_node_base*& hi);
+
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = alloc>
 class rb_tree {
 protected:
@@ -151,13 +284,14 @@ public:
     typedef rb_tree_node* link_type;
     typedef size_t size_type;
     typedef ptrdiff_t difference_type;
+    typedef __rb_tree_node_handle<Key, Value, KeyOfValue, Alloc> node_type;
 protected:
     link_type get_node() { return rb_tree_node_allocator::allocate(); }
     void put_node(link_type p) { rb_tree_node_allocator::deallocate(p); }
 
     link_type create_node(const value_type& x)
     {
-        link_type tmp = get_node();             // 配置空间
+        link_type tmp = get_node(); // 配置空间
         __STL_TRY {
             construct(&tmp->value_field, x);    // 构造内容
         }
@@ -169,7 +303,7 @@ protected:
     link_type clone_node(link_type x)
     {
         link_type tmp = create_node(x->value_field);
-        tmp->color = x->color;
+        tmp->set_color(x->get_color());
         tmp->left = 0;
         tmp->right = 0;
         return tmp;
@@ -188,25 +322,25 @@ protected:
     Compare key_compare;    // 节点间的键值大小比较准则. 应该会是个 function object
 
     // 以下三个函数用来方便取得 header 成员
-    link_type& root() const { return (link_type&) header->parent; }
+    link_type& root() const { return (link_type&) header->parent_slot(); }
     link_type& leftmost() const { return (link_type&) header->left; }
     link_type& rightmost() const { return (link_type&) header->right; }
 
     // 以下六个函数用来方便取得节点 x 的成员
     static link_type& left(link_type x) { return (link_type&)(x->left); }
     static link_type& right(link_type x) { return (link_type&)(x->right); }
-    static link_type& parent(link_type x) { return (link_type&)(x->parent); }
-    static link_type& value(link_type x) { return x->value_field; }
+    static link_type parent(link_type x) { return (link_type) x->get_parent(); }
+    static reference value(link_type x) { return x->value_field; }
     static const Key& key(link_type x) { return KeyOfValue()(value(x)); } 
-    static color_type& color(link_type x) { return (color_type&)(x->color); }
+    static color_type color(link_type x) { return x->get_color(); }
 
     // 以下六个函数用来方便取得节点 x 的成员
     static link_type& left(base_ptr x) { return (link_type&)(x->left); }
     static link_type& right(base_ptr x) { return (link_type&)(x->right); }
-    static link_type& parent(base_ptr x) { return (link_type&)(x->parent); }
-    static link_type& value(base_ptr x) { return ((link_type)x)->value_field; }
+    static link_type parent(base_ptr x) { return (link_type) x->get_parent(); }
+    static reference value(base_ptr x) { return ((link_type)x)->value_field; }
     static const Key& key(base_ptr x) { return KeyOfValue()(value(link_type(x))); } 
-    static color_type& color(base_ptr x) { return (color_type&)(link_type(x)->color); }
+    static color_type color(base_ptr x) { return x->get_color(); }
 
     // 求取极大值和极小值. node class 有实现此功能, 交给它们完成即可
     static link_type minimum(link_type x)
@@ -235,14 +369,82 @@ public:
 #endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */ 
 
 private:
-    iterator __insert(base_ptr x, base_ptr y, const value_type& v);
+    iterator __insert(base_ptr x, base_ptr y, const value_type& v)
+    {
+        return __link_node(x, y, create_node(v));
+    }
+    iterator __link_node(base_ptr x, base_ptr y, link_type z);
+    // 为键值 k 找出插入点的父节点. __insert_unique_pos() 遇到重复键值时返回 (该节点, false)
+    pair<base_ptr, bool> __insert_unique_pos(const key_type& k);
+    base_ptr __insert_equal_pos(const key_type& k);
+    // 把节点从树中摘下, 但不析构也不释放
+    link_type __unlink_node(base_ptr z)
+    {
+        link_type y = (link_type) __rb_tree_rebalance_for_erase(z,
+                                                                header->parent_slot(),
+                                                                header->left,
+                                                                header->right);
+        --node_count;
+        return y;
+    }
     link_type __copy(link_type x, link_type p);
-    void __erase(link_type x);
+    size_type __erase(link_type x);
+
+    // 以下用于由有序输入直接建树, 见 insert_unique(first, last)
+    void __build_from_chain(link_type chain, size_type n);
+    static link_type __build(link_type& chain, size_type n, size_type depth,
+                             size_type red_depth, link_type p);
+    void __destory_chain(link_type chain)
+    {
+        while (chain != 0) {
+            link_type next = right(chain);
+            destory_node(chain);
+            chain = next;
+        }
+    }
+
+    // 以下用于 join/split 及集合运算. 它们操作的都是脱离 header 的子树(根的 parent 为 0).
+    // 比较函数抛出异常时, __split() 保证子树原封不动; __union() 等三者保证 t 仍是一棵
+    // 完整的子树(可能已部分完成), 由调用者重新接回 header
+    base_ptr __detach()
+    {
+        base_ptr r = root();
+        if (r != 0) r->set_parent(0);
+        root() = 0;
+        leftmost() = header;
+        rightmost() = header;
+        return r;
+    }
+    void __attach(base_ptr r)
+    {
+        root() = (link_type) r;
+        if (r != 0) {
+            r->set_parent(header);
+            r->set_color(__rb_tree_black);
+            leftmost() = minimum((link_type) r);
+            rightmost() = maximum((link_type) r);
+        } else {
+            leftmost() = header;
+            rightmost() = header;
+        }
+    }
+    // 每棵子树都带着它的黑高度(根染黑之后, 见 __rb_tree_root_black_height()) 一起传递,
+    // 接合时不必再沿脊下行去数. 只在最上层计算一次
+    void __split(base_ptr t, int ht, const key_type& k,
+                 base_ptr& lo, int& hlo, base_ptr& hi, int& hhi);
+    void __split(base_ptr t, int ht, const key_type& k,
+                 base_ptr& lo, int& hlo, base_ptr& mid, base_ptr& hi, int& hhi);
+    void __union(base_ptr& t, int& ht, base_ptr x);
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    link_type __select(size_type k) const;
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+    void __intersect(base_ptr& t, int& ht, base_ptr x);
+    void __difference(base_ptr& t, int& ht, base_ptr x);
 
     void init()
     {
-        header = get_node();            // 产生一个节点空间, 令 header 指向它
-        color(header) = __rb_tree_red;  // 令 header 为红色, 用来区分 header 和 root,
+        header = get_node();    // 产生一个节点空间, 令 header 指向它
+        header->set_color(__rb_tree_red);   // 令 header 为红色, 用来区分 header 和 root,
                                         // 在 iterator.operator-- 之中
         root() = 0;
         leftmost() = header;
@@ -264,6 +466,8 @@ public:     // accessors
     Compare key_comp() const { return key_compare; }
     iterator begin() { return leftmost(); }     // RB 树的起头为最左(最小)节点处
     iterator end() { return header; }           // RB 树的终点为 header 所指处
+    const_iterator begin() const { return leftmost(); }
+    const_iterator end() const { return header; }
     reverse_iterator rbegin() { return reverse_iterator(end()); }
     const_reverse_iterator rbegin() const
     { 
@@ -279,37 +483,160 @@ public:     // accessors
     size_type max_size() const { return size_type(-1); }
     void swap(rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& t)
     {
-        std::swap(header, t._M_header);
-        std::swap(node_count, t._M_node_count);
-        std::swap(key_compare, t._M_key_compare);
+        std::swap(header, t.header);
+        std::swap(node_count, t.node_count);
+        std::swap(key_compare, t.key_compare);
+    }
+
+private:
+    // 查找的本体. K 可以是 Key, 也可以是透明比较函数所能比较的其他型别
+    template <class K>
+    link_type __lower_bound(const K& k) const;
+    template <class K>
+    link_type __upper_bound(const K& k) const;
+    template <class K>
+    link_type __find(const K& k) const
+    {
+        link_type j = __lower_bound(k);
+        return (j == header || key_compare(k, key(j))) ? header : j;
+    }
+    template <class K>
+    size_type __count(const K& k) const
+    {
+        return cstl::distance(const_iterator(__lower_bound(k)), const_iterator(__upper_bound(k)));
     }
 
 public:     // set operations
-    iterator find(const Key& k);
-    const_iterator find(const Key& k) const;
-    size_type count(const Key& k) const;
-    iterator lower_bound(const Key& k);
-    const_iterator lower_bound(const Key& k) const;
-    iterator upper_bound(const Key& k);
-    const_iterator upper_bound(const Key& k) const;
-    pair<iterator,iterator> equal_range(const Key& k);
-    pair<const_iterator, const_iterator> equal_range(const Key& k) const;
+    iterator find(const Key& k) { return __find(k); }
+    const_iterator find(const Key& k) const { return __find(k); }
+    size_type count(const Key& k) const { return __count(k); }
+    iterator lower_bound(const Key& k) { return __lower_bound(k); }
+    const_iterator lower_bound(const Key& k) const { return __lower_bound(k); }
+    iterator upper_bound(const Key& k) { return __upper_bound(k); }
+    const_iterator upper_bound(const Key& k) const { return __upper_bound(k); }
+    pair<iterator,iterator> equal_range(const Key& k)
+    {
+        return pair<iterator, iterator>(__lower_bound(k), __upper_bound(k));
+    }
+    pair<const_iterator, const_iterator> equal_range(const Key& k) const
+    {
+        return pair<const_iterator, const_iterator>(__lower_bound(k), __upper_bound(k));
+    }
+
+    // 异质查找: Compare 定义了 is_transparent 时, 可以任何能与 Key 比较的型别查找,
+    // 不必先构造出一个 Key (例如以 const char* 查找 std::string 键值)
+    template <class K>
+    typename __if_transparent<Compare, K, iterator>::type find(const K& k) { return __find(k); }
+    template <class K>
+    typename __if_transparent<Compare, K, const_iterator>::type find(const K& k) const
+    {
+        return __find(k);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, size_type>::type count(const K& k) const
+    {
+        return __count(k);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, iterator>::type lower_bound(const K& k)
+    {
+        return __lower_bound(k);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, const_iterator>::type lower_bound(const K& k) const
+    {
+        return __lower_bound(k);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, iterator>::type upper_bound(const K& k)
+    {
+        return __upper_bound(k);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, const_iterator>::type upper_bound(const K& k) const
+    {
+        return __upper_bound(k);
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& k)
+    {
+        return pair<iterator, iterator>(__lower_bound(k), __upper_bound(k));
+    }
+    template <class K>
+    typename __if_transparent<Compare, K, pair<const_iterator, const_iterator> >::type
+    equal_range(const K& k) const
+    {
+        return pair<const_iterator, const_iterator>(__lower_bound(k), __upper_bound(k));
+    }
 
 public:     // insert/erase
     // 将 x 插入到 RB-tree 中 (保持节点值独一无二)
     pair<iterator, bool> insert_unique(const value_type& v);
     iterator insert_unique(iterator position, const value_type& v);
-    void insert_unique(const_iterator first, const_iterator last);
+    // 空树遇到有序输入时, 不逐一插入, 而是以 O(n) 直接建出一棵平衡且着好色的树
+    template <class InputIterator>
+    void insert_unique(InputIterator first, InputIterator last);
     // 将 x 插入到 RB-tree 中 (允许节点值重复)
     iterator insert_equal(const value_type& x);
     iterator insert_equal(iterator position, const value_type& v);
-    void insert_equal(const_iterator first, const_iterator last);
+    template <class InputIterator>
+    void insert_equal(InputIterator first, InputIterator last);
 
     void erase(iterator position);
     size_type erase(const key_type& V);
     void erase(iterator first, iterator last);
     void erase(const key_type* first, const key_type* last);
 
+    // 节点把手. extract() 摘下节点交给把手; 键值不存在时返回空把手.
+    // 以把手插入时不配置节点. insert_unique(nh) 若键值重复, 节点仍留在 nh 中
+    node_type extract(iterator position) { return node_type(__unlink_node(position.node)); }
+    node_type extract(const key_type& k)
+    {
+        iterator i = find(k);
+        return i == end() ? node_type() : extract(i);
+    }
+    pair<iterator, bool> insert_unique(const node_type& nh);
+    iterator insert_equal(const node_type& nh);
+    // 把 src 的节点直接移到 *this, 不配置也不复制. merge_unique() 会把与 *this 键值
+    // 重复的节点留在 src 中. 两者的迭代器都仍然有效
+    void merge_unique(rb_tree& src);
+    void merge_equal(rb_tree& src);
+
+    // 接合与分割. join() 令 *this 成为 t1, v, t2 依序接合的结果, t1 和 t2 被清空.
+    // 要求 t1 的所有键值都在 v 之前, t2 的所有键值都在 v 之后. O(log n)
+    void join(rb_tree& t1, const value_type& v, rb_tree& t2);
+    // split() 把键值不小于 k 的元素全部移到 hi, *this 只留下键值小于 k 的元素.
+    // 定义 __STL_RB_TREE_SUBTREE_SIZE 时为 O(log n); 否则还得数出较小一侧的元素个数,
+    // 为 O(log n + min(|*this|, |hi|))
+    void split(const key_type& k, rb_tree& hi);
+
+    // 就地集合运算, 只用于键值唯一的树(set/map). 设 m, n 为两者中较小与较大的元素个数,
+    // 复杂度为 O(m log(n/m + 1)), 而不是 set_union() 等算法的 O(m + n)
+    void merge_union(const rb_tree& x);     // *this = *this ∪ x
+    void intersect_with(const rb_tree& x);  // *this = *this ∩ x
+    void subtract(const rb_tree& x);        // *this = *this - x
+
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    // 顺序统计(order statistics). 以下皆为 O(log n)
+    iterator select(size_type k) { return __select(k); }    // 第 k 个(自 0 起算)元素
+    const_iterator select(size_type k) const { return __select(k); }
+    size_type rank(const key_type& k) const;                // 键值小于 k 的元素个数
+    size_type index_of(const_iterator it) const;            // it 之前的元素个数
+    difference_type distance(const_iterator first, const_iterator last) const
+    {
+        return difference_type(index_of(last)) - difference_type(index_of(first));
+    }
+    iterator advance(const_iterator it, difference_type n)
+    {
+        return __select(index_of(it) + n);
+    }
+    const_iterator advance(const_iterator it, difference_type n) const
+    {
+        return __select(index_of(it) + n);
+    }
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+
     void clear()
     {
         if (node_count != 0) {
@@ -353,22 +680,58 @@ operator!=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& __x,
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
 typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
 rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(const Value& v)
+{
+    return __insert(0, __insert_equal_pos(KeyOfValue()(v)), v);
+    // 以上, 0 为新增插入点, 第二参数为插入点的父节点, v为新值
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::base_ptr
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__insert_equal_pos(const key_type& k)
 {
     link_type y = header;
     link_type x = root();       // 从根节点开始
     while (x != 0) {            // 从根节点开始, 往下寻找适当的插入点
         y = x;
-        x = key_compare(KeyOfValue()(v), key(x)) ? left(x) : right(x);
+        x = key_compare(k, key(x)) ? left(x) : right(x);
         // 以上, 遇 "大" 则往左, 遇 "小于或等于" 则往右
     }
-    return __insert(x, y, v);
-    // 以上, x 为新增插入点, y 为插入点的父节点, v为新值
+    return y;
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+template <class InputIterator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
-    insert_equal(const_iterator first, const_iterator last)
+    insert_equal(InputIterator first, InputIterator last)
 {
+    if (node_count != 0) {
+        // 树非空: 逐一插入. 以 end() 为提示, 有序输入每次只需一次比较即可找到插入点
+        for ( ; first != last; ++first) {
+            insert_equal(end(), *first);
+        }
+        return;
+    }
+
+    // 先把非递减的前缀全部做成节点, 以 right 串成一条链
+    link_type chain = 0;
+    link_type tail = 0;
+    size_type n = 0;
+    __STL_TRY {
+        for ( ; first != last; ++first) {
+            if (tail != 0 && key_compare(KeyOfValue()(*first), key(tail))) {
+                break;                  // 输入不再有序
+            }
+            link_type tmp = create_node(*first);
+            right(tmp) = 0;
+            if (tail != 0) right(tail) = tmp; else chain = tmp;
+            tail = tmp;
+            ++n;
+        }
+    }
+    __STL_UNWIND(__destory_chain(chain));
+    __build_from_chain(chain, n);
+
+    // 剩下的(无序的)部分逐一插入
     for ( ; first != last; ++first) {
         insert_equal(*first);
     }
@@ -380,23 +743,23 @@ rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
     insert_equal(iterator position, const value_type& v)
 {
     if (position.node == header->left) {    // begin()
-        if (size() > 0 && !key_compare(Key(position.node), KeyOfValue()(v))) {
+        if (size() > 0 && !key_compare(key(position.node), KeyOfValue()(v))) {
             return __insert(position.node, position.node, v);
             // first argument just needs to be non-null
         } else {
             return insert_equal(v);
         }
     } else if (position.node == header) {   // end()
-        if (!key_compare(KeyOfValue()(v), Key(rightmost()))) {
-            return __insert(0, rightmost(0), v);
+        if (!key_compare(KeyOfValue()(v), key(rightmost()))) {
+            return __insert(0, rightmost(), v);
         } else {
             return insert_equal(v);
         }
     } else {
         iterator before = position;
         --before;
-        if (!key_compare(KeyOfValue()(v), Key(before.node))
-            && !key_compare(Key(position.node), KeyOfValue()(v))) {
+        if (!key_compare(KeyOfValue()(v), key(before.node))
+            && !key_compare(key(position.node), KeyOfValue()(v))) {
             if (right(before.node) == 0) {
                 return __insert(0, before.node, v);
             } else {
@@ -414,41 +777,135 @@ rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
 pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator, bool>
 rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const Value& v)
+{
+    pair<base_ptr, bool> p = __insert_unique_pos(KeyOfValue()(v));
+    if (p.second) {
+        return pair<iterator, bool>(__insert(0, p.first, v), true);
+        // 以上, 0 为插入点， p.first 为插入点的父节点, v 为新值
+    }
+    // 新值与树中键值重复, 那么就不该插入新值
+    return pair<iterator, bool>(iterator((link_type) p.first), false);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::base_ptr, bool>
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__insert_unique_pos(const key_type& k)
 {
     link_type y = header;
     link_type x = root();       // 从根节点开始
     bool comp = true;
     while (x != 0) {            // 从根节点开始, 往下寻找适当的插入点
         y = x;
-        comp = key_compare(KeyOfValue()(v), key(x));    // v 键值是否小于目前节点的键值
-        x = comp ? left(x) : right(x);                  // 遇 "大" 则往左, 遇 "小于或等于" 则往右
+        comp = key_compare(k, key(x));      // k 是否小于目前节点的键值
+        x = comp ? left(x) : right(x);      // 遇 "大" 则往左, 遇 "小于或等于" 则往右
     }
     // 离开 while 循环之后, y 所指即插入点之父节点(此时的它必为叶节点)
 
     iterator j = iterator(y);   // 令迭代器 j 指向插入点的父节点 y
     if (comp) {     // 如果离开 while 循环时 comp 为真(表示遇 "大" , 将插入于左侧)
         if ( j == begin()) {    // 如果插入点的父节点为最左节点
-            return pair<iterator, bool>(__insert(x, y, v), true);
-            // 以上, x 为插入点， y 为插入点的父节点, v 为新值
+            return pair<base_ptr, bool>(y, true);
         } else {    // 否则(插入点的父节点不为最左节点)
             --j;    // 调整 j
         }
     }
-    if (key_compare(key(j.node), KeyOfValue()(v))) {
-        // 新键值不与既有节点的键值重复, 于是以下执行安插操作
-        return pair<iterator, bool>(__insert(x, y, v), true);
-        // 以上, x 为新值插入点, y 为插入点的父节点, v 为新值
+    if (key_compare(key(j.node), k)) {
+        // 新键值不与既有节点的键值重复
+        return pair<base_ptr, bool>(y, true);
+    }
+    // 进行至此, 表示新键值一定与 j 的键值重复
+    return pair<base_ptr, bool>(j.node, false);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator, bool>
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const node_type& nh)
+{
+    if (nh.empty()) {
+        return pair<iterator, bool>(end(), false);
+    }
+    pair<base_ptr, bool> p = __insert_unique_pos(key(nh.node));
+    if (p.second) {
+        return pair<iterator, bool>(__link_node(0, p.first, nh.release()), true);
+    }
+    return pair<iterator, bool>(iterator((link_type) p.first), false);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(const node_type& nh)
+{
+    if (nh.empty()) {
+        return end();
+    }
+    base_ptr y = __insert_equal_pos(key(nh.node));
+    return __link_node(0, y, nh.release());
+}
+
+// 逐一检视 src 的节点, 找得到插入点的就从 src 摘下, 直接串接进 *this
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::merge_unique(rb_tree& src)
+{
+    if (&src == this) return;
+    for (iterator i = src.begin(); i != src.end(); ) {
+        base_ptr z = (i++).node;    // 先前进: 摘下 z 不影响其余节点的迭代器
+        pair<base_ptr, bool> p = __insert_unique_pos(key(z));
+        if (p.second) {
+            __link_node(0, p.first, src.__unlink_node(z));
+        }
+    }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::merge_equal(rb_tree& src)
+{
+    if (&src == this) return;
+    for (iterator i = src.begin(); i != src.end(); ) {
+        base_ptr z = (i++).node;
+        base_ptr y = __insert_equal_pos(key(z));
+        __link_node(0, y, src.__unlink_node(z));
     }
-    // 进行至此, 表示新值一定与树中键值重复, 那么就不该插入新值
-    return pair<iterator, bool>(j, false);
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+template <class InputIterator>
 void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
-    insert_unique(const_iterator first, const_iterator last)
+    insert_unique(InputIterator first, InputIterator last)
 {
-    for (; first != last; ++first)
+    if (node_count != 0) {
+        // 树非空: 逐一插入. 以 end() 为提示, 有序输入每次只需一次比较即可找到插入点
+        for ( ; first != last; ++first) {
+            insert_unique(end(), *first);
+        }
+        return;
+    }
+
+    // 先把严格递增的前缀全部做成节点, 以 right 串成一条链
+    link_type chain = 0;
+    link_type tail = 0;
+    size_type n = 0;
+    __STL_TRY {
+        for ( ; first != last; ++first) {
+            if (tail != 0 && !key_compare(key(tail), KeyOfValue()(*first))) {
+                if (!key_compare(KeyOfValue()(*first), key(tail))) {
+                    continue;           // 与前一个键值相同, 本来就不会插入
+                }
+                break;                  // 输入不再有序
+            }
+            link_type tmp = create_node(*first);
+            right(tmp) = 0;
+            if (tail != 0) right(tail) = tmp; else chain = tmp;
+            tail = tmp;
+            ++n;
+        }
+    }
+    __STL_UNWIND(__destory_chain(chain));
+    __build_from_chain(chain, n);
+
+    // 剩下的(无序的)部分逐一插入
+    for ( ; first != last; ++first) {
         insert_unique(*first);
+    }
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
@@ -471,8 +928,8 @@ rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
     } else {
         iterator before = position;
         --before;
-        if (key_compare(Key(before.node), KeyOfValue()(v))
-            && key_compare(KeyOfValue()(v), Key(position.node))) {
+        if (key_compare(key(before.node), KeyOfValue()(v))
+            && key_compare(KeyOfValue()(v), key(position.node))) {
             if (right(before.node) == 0) {
                 return __insert(0, before.node, v);
             } else {
@@ -488,12 +945,7 @@ template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
 void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
     erase(iterator position)
 {
-    link_type y = (link_type) __rb_tree_rebalance_for_erase(position.node,
-                                                            header->parent,
-                                                            header->left,
-                                                            header->right);
-    destory_node(y);
-    --node_count;
+    destory_node(__unlink_node(position.node));
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
@@ -501,21 +953,41 @@ typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
 rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::erase(const key_type& k)
 {
     pair<iterator, iterator> p = equal_range(k);
-    size_type n = 0;
-    std::distance(p.first, p.second, n);
+    size_type n = cstl::distance(p.first, p.second);
     erase(p.first, p.second);
     return n;
 }
 
+// 区间较短时逐一删除. 否则在 first 和 last 两处把树分割成三段, 直接销毁中间一段,
+// 再把头尾两段接合起来: 只需 O(log n) 次接合, 不必为每个节点做一次再平衡
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
 void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
     erase(iterator first, iterator last)
 {
     if (first == begin() && last == end()) {
         clear();
+        return;
+    }
+
+    iterator i = first;
+    for (int n = 0; n < 32; ++n) {
+        if (i == last) {
+            while (first != last) erase(first++);
+            return;
+        }
+        ++i;
+    }
+
+    base_ptr lo, mid, hi;
+    base_ptr t = __detach();
+    __rb_tree_split_before(t, first.node, lo, mid);
+    if (last.node != header) {
+        __rb_tree_split_before(mid, last.node, mid, hi);
     } else {
-        while ( first != last) erase(first++);
+        hi = 0;
     }
+    node_count -= __erase((link_type) mid);
+    __attach(__rb_tree_join(lo, hi));
 }
 
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
@@ -528,17 +1000,16 @@ void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
 typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
 rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
-    __insert(base_ptr x_, base_ptr y_, const Value& v)
+    __link_node(base_ptr x_, base_ptr y_, link_type z)
 {
-    // 参数 x_ 为新值插入点, 参数 y_ 为插入点的父节点, 参数 v 为新值
+    // 参数 x_ 为新值插入点, 参数 y_ 为插入点的父节点, 参数 z 为已含新值的节点
+    // (由 __insert() 新产生, 或者来自节点把手)
     link_type x = (link_type) x_;
     link_type y = (link_type) y_;
-    link_type z;
 
     // key_compare 是键值大小比较准则. 应该会是个 function object
-    if (y == header || x != 0 || key_compare(KeyOfValue()(v), key(y))) {
-        z = create_node(v);     // 产生一个新节点
-        left(y) == z;           // 这使得当 y 即为 header 时, leftmost() = z
+    if (y == header || x != 0 || key_compare(key(z), key(y))) {
+        left(y) = z;           // 这使得当 y 即为 header 时, leftmost() = z
         if (y == header) {
             root() = z;
             rightmost() = z;
@@ -546,30 +1017,364 @@ rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
             leftmost() = z;             // 维护 leftmost(), 使它永远指向最左节点
         }
     } else {
-        z = create_node(v);             // 产生一个新节点
         right(y) = z;                   // 令新节点成为插入点的父节点 y 的右子节点
         if (y == rightmost()) {
             rightmost() = z;            // 维护 rightmost(), 使它永远指向最右节点
         }
     }
-    parent(z) = y;      // 设定新节点的父节点
+    z->set_parent(y);   // 设定新节点的父节点
     left(z) = 0;        // 设定新节点的左子节点
     right(z) = 0;       // 设定新节点的右子节点
                         // 新节点的颜色将在 __rb_tree_rebalance() 设定(并调整)
-    __rb_tree_rebalance(z, header->parent);     // 参数一为新增节点, 参数二为 root
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    z->size = 1;
+    for (base_ptr p = y; p != header; p = p->get_parent()) {
+        ++p->size;      // 新节点的每个祖先, 子树都多了一个节点
+    }
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+    __rb_tree_rebalance(z, header->parent_slot());  // 参数一为新增节点, 参数二为 root
     ++node_count;
     return iterator(z);
 }
 
+// 以有序的节点链(以 right 串接)建出一棵空树. 每个节点只访问一次, O(n), 不做任何旋转
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__erase(link_type x)
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    __build_from_chain(link_type chain, size_type n)
+{
+    if (n == 0) return;
+    size_type h = 0;                    // 树高 floor(log2(n)), 根的深度为 0
+    for (size_type m = n; m > 1; m >>= 1) ++h;
+    root() = __build(chain, n, 0, h, header);
+    leftmost() = minimum(root());
+    rightmost() = maximum(root());
+    node_count = n;
+}
+
+// 取中间节点为根, 左右两半递归建树. 如此建出的树, 所有空子节点的深度至多相差 1,
+// 所以只要把最深一层(深度为 red_depth)的节点着为红色, 其余着为黑色,
+// 每条路径上的黑节点数就都相同, 且红节点的父节点必为黑
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    __build(link_type& chain, size_type n, size_type depth, size_type red_depth, link_type p)
 {
+    if (n == 0) return 0;
+    size_type n_left = (n - 1) / 2;
+    link_type l = __build(chain, n_left, depth + 1, red_depth, 0);
+    link_type x = chain;                // 左子树用完之后, 链头即为本子树的根
+    chain = right(chain);
+    left(x) = l;
+    if (l != 0) l->set_parent(x);
+    x->set_parent(p);
+    x->set_color((depth == red_depth && depth != 0) ? __rb_tree_red : __rb_tree_black);
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    x->size = n;
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+    right(x) = __build(chain, n - 1 - n_left, depth + 1, red_depth, x);
+    return x;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    join(rb_tree& t1, const value_type& v, rb_tree& t2)
+{
+    link_type k = create_node(v);   // 先配置节点, 此后的操作都不会抛出异常
+    size_type n1 = t1.node_count;
+    size_type n2 = t2.node_count;
+    base_ptr l = t1.__detach();
+    base_ptr r = t2.__detach();
+    t1.node_count = 0;
+    t2.node_count = 0;
+    clear();
+    __attach(__rb_tree_join(l, k, r));
+    node_count = n1 + n2 + 1;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    split(const key_type& k, rb_tree& hi)
+{
+    hi.clear();
+    base_ptr t = __detach();
+    base_ptr l, r;
+    int hl, hr;
+    __STL_TRY {
+        __split(t, __rb_tree_root_black_height(t), k, l, hl, r, hr);
+    }
+    __STL_UNWIND(__attach(t));
+    __attach(l);
+    hi.__attach(r);
+
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    hi.node_count = __rb_tree_subtree_size(r);
+    node_count -= hi.node_count;
+#else /* __STL_RB_TREE_SUBTREE_SIZE */
+    // 节点不记录子树大小, 只能数出较小的一侧: O(min(|lo|, |hi|))
+    iterator i = begin();
+    iterator j = hi.begin();
+    size_type n = 0;
+    while (i != end() && j != hi.end()) {
+        ++i;
+        ++j;
+        ++n;
+    }
+    if (i == end()) {
+        hi.node_count = node_count - n;
+        node_count = n;
+    } else {
+        hi.node_count = n;
+        node_count -= n;
+    }
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+}
+
+// 把子树 t 分割成键值小于 k 的 lo 和键值不小于 k 的 hi.
+// 每一层都先比较, 递归返回之后才改动指针, 所以比较函数抛出异常时 t 原封不动
+// 各层的接合为 O(黑高度差 + 1), 沿途相加是 O(log n)
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    __split(base_ptr t, int ht, const key_type& k, base_ptr& lo, int& hlo,
+            base_ptr& hi, int& hhi)
+{
+    if (t == 0) {
+        lo = hi = 0;
+        hlo = hhi = 0;
+        return;
+    }
+    base_ptr l = t->left;
+    base_ptr r = t->right;
+    int hl = __rb_tree_child_height(ht, l);     // 递归会改变子树的颜色, 先算出
+    int hr = __rb_tree_child_height(ht, r);
+    base_ptr tmp;
+    int htmp;
+    if (key_compare(key(t), k)) {       // t 及其左子树都小于 k
+        __split(r, hr, k, tmp, htmp, hi, hhi);
+        if (l != 0) l->set_parent(0);
+        lo = __rb_tree_join(l, hl, t, tmp, htmp, hlo);
+    } else {                            // t 及其右子树都不小于 k
+        __split(l, hl, k, lo, hlo, tmp, htmp);
+        if (r != 0) r->set_parent(0);
+        hi = __rb_tree_join(tmp, htmp, t, r, hr, hhi);
+    }
+}
+
+// 三路分割: 键值等于 k 的节点(若有)单独放在 mid, 不接入 lo 或 hi. 只用于键值唯一的树
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    __split(base_ptr t, int ht, const key_type& k, base_ptr& lo, int& hlo,
+            base_ptr& mid, base_ptr& hi, int& hhi)
+{
+    if (t == 0) {
+        lo = mid = hi = 0;
+        hlo = hhi = 0;
+        return;
+    }
+    base_ptr l = t->left;
+    base_ptr r = t->right;
+    int hl = __rb_tree_child_height(ht, l);
+    int hr = __rb_tree_child_height(ht, r);
+    base_ptr tmp;
+    int htmp;
+    if (key_compare(k, key(t))) {
+        __split(l, hl, k, lo, hlo, mid, tmp, htmp);
+        if (r != 0) r->set_parent(0);
+        hi = __rb_tree_join(tmp, htmp, t, r, hr, hhi);
+    } else if (key_compare(key(t), k)) {
+        __split(r, hr, k, tmp, htmp, mid, hi, hhi);
+        if (l != 0) l->set_parent(0);
+        lo = __rb_tree_join(l, hl, t, tmp, htmp, hlo);
+    } else {
+        if (l != 0) l->set_parent(0);
+        if (r != 0) r->set_parent(0);
+        lo = l;
+        hlo = hl;
+        mid = t;
+        hi = r;
+        hhi = hr;
+    }
+}
+
+// 以下三个递归函数, 都是以 x 的根把 t 三路分割, 再分别处理左右两半, 最后接合.
+// t 属于 *this(会被拆散重组), x 只读. 递归深度不超过 x 的高度.
+// 结果经由 t 传回. 比较函数或配置节点抛出异常时, 已拆开的各段先接合回 t 再往外传
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__union(base_ptr& t, int& ht, base_ptr x)
+{
+    if (x == 0) return;
+    base_ptr lo, mid, hi;
+    int hlo, hhi;
+    __split(t, ht, key(x), lo, hlo, mid, hi, hhi);
+    __STL_TRY {
+        if (mid == 0) {
+            mid = create_node(value(x));
+            ++node_count;
+        }
+        __union(lo, hlo, x->left);
+        __union(hi, hhi, x->right);
+    }
+    __STL_UNWIND(t = mid != 0 ? __rb_tree_join(lo, hlo, mid, hi, hhi, ht)
+                              : __rb_tree_join(lo, hlo, hi, hhi, ht));
+    t = __rb_tree_join(lo, hlo, mid, hi, hhi, ht);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__intersect(base_ptr& t, int& ht,
+                                                                  base_ptr x)
+{
+    if (t == 0) return;
+    if (x == 0) {
+        node_count -= __erase((link_type) t);
+        t = 0;
+        ht = 0;
+        return;
+    }
+    base_ptr lo, mid, hi;
+    int hlo, hhi;
+    __split(t, ht, key(x), lo, hlo, mid, hi, hhi);
+    __STL_TRY {
+        __intersect(lo, hlo, x->left);
+        __intersect(hi, hhi, x->right);
+    }
+    __STL_UNWIND(t = mid != 0 ? __rb_tree_join(lo, hlo, mid, hi, hhi, ht)
+                              : __rb_tree_join(lo, hlo, hi, hhi, ht));
+    t = mid != 0 ? __rb_tree_join(lo, hlo, mid, hi, hhi, ht)
+                 : __rb_tree_join(lo, hlo, hi, hhi, ht);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__difference(base_ptr& t, int& ht,
+                                                                   base_ptr x)
+{
+    if (t == 0 || x == 0) return;
+    base_ptr lo, mid, hi;
+    int hlo, hhi;
+    __split(t, ht, key(x), lo, hlo, mid, hi, hhi);
+    if (mid != 0) {
+        destory_node((link_type) mid);
+        --node_count;
+    }
+    __STL_TRY {
+        __difference(lo, hlo, x->left);
+        __difference(hi, hhi, x->right);
+    }
+    __STL_UNWIND(t = __rb_tree_join(lo, hlo, hi, hhi, ht));
+    t = __rb_tree_join(lo, hlo, hi, hhi, ht);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::merge_union(const rb_tree& x)
+{
+    if (&x == this) return;
+    base_ptr t = __detach();
+    int h = __rb_tree_root_black_height(t);
+    __STL_TRY {
+        __union(t, h, x.root());
+    }
+    __STL_UNWIND(__attach(t));
+    __attach(t);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::intersect_with(const rb_tree& x)
+{
+    if (&x == this) return;
+    base_ptr t = __detach();
+    int h = __rb_tree_root_black_height(t);
+    __STL_TRY {
+        __intersect(t, h, x.root());
+    }
+    __STL_UNWIND(__attach(t));
+    __attach(t);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::subtract(const rb_tree& x)
+{
+    if (&x == this) {
+        clear();
+        return;
+    }
+    base_ptr t = __detach();
+    int h = __rb_tree_root_black_height(t);
+    __STL_TRY {
+        __difference(t, h, x.root());
+    }
+    __STL_UNWIND(__attach(t));
+    __attach(t);
+}
+
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+// 自根往下: 左子树的大小决定往哪边走. k 越界时返回 header, 亦即 end()
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__select(size_type k) const
+{
+    if (k >= node_count) return header;
+    link_type x = root();
+    for (;;) {
+        size_type n = __rb_tree_subtree_size(x->left);
+        if (k < n) {
+            x = left(x);
+        } else if (k == n) {
+            return x;
+        } else {
+            k -= n + 1;
+            x = right(x);
+        }
+    }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::rank(const key_type& k) const
+{
+    size_type n = 0;
+    link_type x = root();
+    while (x != 0) {
+        if (key_compare(key(x), k)) {   // x 及其左子树都小于 k
+            n += __rb_tree_subtree_size(x->left) + 1;
+            x = right(x);
+        } else {
+            x = left(x);
+        }
+    }
+    return n;
+}
+
+// 自 it 往上走到根: 每当自己是右子节点, 父节点及其左子树都在 it 之前
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::index_of(const_iterator it) const
+{
+    base_ptr x = it.node;
+    if (x == header) return node_count;
+    size_type n = __rb_tree_subtree_size(x->left);
+    while (x != root()) {
+        base_ptr p = x->get_parent();
+        if (x == p->right) {
+            n += __rb_tree_subtree_size(p->left) + 1;
+        }
+        x = p;
+    }
+    return n;
+}
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+
+// 销毁以 x 为根的子树(不做任何再平衡), 返回销毁的节点数
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__erase(link_type x)
+{
+    size_type n = 0;
     while (x != 0) {
-        __erase(right(x));
+        n += __erase(right(x));
         link_type y = left(x);
         destory_node(x);
         x = y;
+        ++n;
     }
+    return n;
 }
 
 // 全局函数
@@ -582,20 +1387,24 @@ __rb_tree_rotate_left(__rb_tree_node_base* x, __rb_tree_node_base*& root)
     __rb_tree_node_base* y = x->right;  // 令 y 为旋转点的右子节点
     x->right = y->left;
     if (y->left != 0) {
-        y->left->parent = x;    // 回马枪设定父节点
+        y->left->set_parent(x); // 回马枪设定父节点
     }
-    y->parent = x->parent;
+    y->set_parent(x->get_parent());
 
     // 令 y 完全顶替 x 的地位(必须将 x 对其父节点的关系完全接收过来)
     if ( x == root) {                       // x 为根节点
         root = y;
-    } else if (x == x->parent->left) {      // x 为其父节点的左子节点
-        x->parent->left = y;
+    } else if (x == x->get_parent()->left) {    // x 为其父节点的左子节点
+        x->get_parent()->left = y;
     } else {                                // x 为其父节点的右子节点
-        x->parent->right = y;
+        x->get_parent()->right = y;
     }
     y->left = x;
-    x->parent = y;
+    x->set_parent(y);
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    y->size = x->size;          // y 顶替了 x, 子树大小不变
+    __rb_tree_update_size(x);
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
 }
 
 // 全局函数
@@ -608,67 +1417,71 @@ __rb_tree_rotate_right(__rb_tree_node_base* x, __rb_tree_node_base*& root)
     __rb_tree_node_base* y = x->left;       // y 为旋转点的左子节点
     x->left = y->right;
     if (y->right != 0) {
-        y->right->parent = x;   // 回马枪设定父节点
+        y->right->set_parent(x);    // 回马枪设定父节点
     }
-    y->parent = x->parent;
+    y->set_parent(x->get_parent());
 
     // 令 y 完全顶替 x 的地位(必须将 x 对其父节点的关系完全接收过来)
     if ( x == root) {                       // x 为根节点
         root = y;
-    } else if (x == x->parent->right) {      // x 为其父节点的右子节点
-        x->parent->right = y;
+    } else if (x == x->get_parent()->right) {   // x 为其父节点的右子节点
+        x->get_parent()->right = y;
     } else {                                // x 为其父节点的左子节点
-        x->parent->left = y;
+        x->get_parent()->left = y;
     }
     y->right = x;
-    x->parent = y;
+    x->set_parent(y);
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    y->size = x->size;          // y 顶替了 x, 子树大小不变
+    __rb_tree_update_size(x);
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
 }
 
-#endif
-
 // 全局函数
 // 重新令树形平衡(改变颜色及旋转树形)
-// 参数一为新增节点, 参数二为 root
-inline void
+// 参数一为新增节点, 参数二为 root. 返回 true 表示根由红染黑, 亦即整棵树的黑高度加 1
+inline bool
 __rb_tree_rebalance(__rb_tree_node_base* x, __rb_tree_node_base*& root)
 {
-    x->color = __rb_tree_red;       // 新节点必为红
-    while (x != root && x->parent->color == __rb_tree_red) {    // 父节点为红
-        if (x->parent == x->parent->parent->left) {             // 父节点为祖父节点的左子节点
-            __rb_tree_node_base* y = x->parent->parent->right;  // 令 y 为伯父节点
-            if (y && y->color == __rb_tree_red) {               // 伯父节点存在, 且为红
-                x->parent->color = __rb_tree_black;             // 更改父节点为黑
-                y->color = __rb_tree_black;                     // 更改伯父节点为黑
-                x->parent->parent->color = __rb_tree_red;       // 更改祖父节点为红
-                x = x->parent->parent;
+    x->set_color(__rb_tree_red);    // 新节点必为红
+    while (x != root && x->get_parent()->get_color() == __rb_tree_red) {    // 父节点为红
+        if (x->get_parent() == x->get_parent()->get_parent()->left) {   // 父节点为祖父节点的左子节点
+            __rb_tree_node_base* y = x->get_parent()->get_parent()->right;  // 令 y 为伯父节点
+            if (y && y->get_color() == __rb_tree_red) { // 伯父节点存在, 且为红
+                x->get_parent()->set_color(__rb_tree_black);    // 更改父节点为黑
+                y->set_color(__rb_tree_black);  // 更改伯父节点为黑
+                x->get_parent()->get_parent()->set_color(__rb_tree_red);    // 更改祖父节点为红
+                x = x->get_parent()->get_parent();
             } else {    // 无伯父节点, 或伯父节点为黑
-                if (x == x->parent->right) {            // 如果新节点为父节点的右子节点
-                    x = x->parent;
+                if (x == x->get_parent()->right) {  // 如果新节点为父节点的右子节点
+                    x = x->get_parent();
                     __rb_tree_rotate_left(x, root);     // 第一参数为左旋点
                 }
-                x->parent->color = __rb_tree_black;     // 改变颜色
-                x->parent->parent->color = __rb_tree_red;
-                __rb_tree_rotate_right(x->parent->parent, root); // 第一参数为右旋点
+                x->get_parent()->set_color(__rb_tree_black);    // 改变颜色
+                x->get_parent()->get_parent()->set_color(__rb_tree_red);
+                __rb_tree_rotate_right(x->get_parent()->get_parent(), root);    // 第一参数为右旋点
             }
         } else {    // // 父节点为祖父节点的右子节点
-            __rb_tree_node_base* y = x->parent->parent->left;   // 令 y 为伯父节点
-            if (y && y->color == __rb_tree_red) {           // 有伯父节点, 且为红
-                x->parent->color = __rb_tree_black;         // 更改父节点为黑
-                y->color = __rb_tree_black;                 // 更改伯父节点为黑
-                x->parent->parent->color = __rb_tree_red;   // 更改祖父节点为红
-                x = x->parent->parent;      // 准备继续往上层检查
+            __rb_tree_node_base* y = x->get_parent()->get_parent()->left;   // 令 y 为伯父节点
+            if (y && y->get_color() == __rb_tree_red) { // 有伯父节点, 且为红
+                x->get_parent()->set_color(__rb_tree_black);    // 更改父节点为黑
+                y->set_color(__rb_tree_black);  // 更改伯父节点为黑
+                x->get_parent()->get_parent()->set_color(__rb_tree_red);    // 更改祖父节点为红
+                x = x->get_parent()->get_parent();  // 准备继续往上层检查
             } else {        // 无伯父节点, 或伯父节点为黑
-                if (x == x->parent->left) {         // 如果新节点为父节点的左子节点
-                    x = x->parent;
+                if (x == x->get_parent()->left) {   // 如果新节点为父节点的左子节点
+                    x = x->get_parent();
                     __rb_tree_rotate_right(x, root);    // 第一参数为右旋点
                 }
-                x->parent->color = __rb_tree_black;     // 改变颜色
-                x->parent->parent->color = __rb_tree_red;
-                __rb_tree_rotate_left(x->parent->parent, root);     // 第一参数为左旋点
+                x->get_parent()->set_color(__rb_tree_black);    // 改变颜色
+                x->get_parent()->get_parent()->set_color(__rb_tree_red);
+                __rb_tree_rotate_left(x->get_parent()->get_parent(), root); // 第一参数为左旋点
             }
         }
     } // while end
-    root->color = __rb_tree_black;      // 根节点永远为黑
+    const bool grew = root->get_color() == __rb_tree_red;
+    root->set_color(__rb_tree_black);   // 根节点永远为黑
+    return grew;
 }
 
 inline __rb_tree_node_base*
@@ -692,44 +1505,58 @@ __rb_tree_rebalance_for_erase(__rb_tree_node_base* __z,
             __x = __y->right;
         }
     }
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    // __y 即实际被摘下的位置, 它的每个祖先(含 __z), 子树都少了一个节点
+    if (__y != __root) {
+        for (__rb_tree_node_base* __p = __y->get_parent(); ; __p = __p->get_parent()) {
+            --__p->size;
+            if (__p == __root) break;
+        }
+    }
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
     if (__y != __z) {          // relink y in place of z.  y is z's successor
-        __z->left->parent = __y; 
+        __z->left->set_parent(__y); 
         __y->left = __z->left;
         if (__y != __z->right) {
-            __x_parent = __y->parent;
-            if (__x) __x->parent = __y->parent;
-            __y->parent->left = __x;      // __y must be a child of _M_left
+            __x_parent = __y->get_parent();
+            if (__x) __x->set_parent(__y->get_parent());
+            __y->get_parent()->left = __x;  // __y must be a child of _M_left
             __y->right = __z->right;
-            __z->right->parent = __y;
+            __z->right->set_parent(__y);
         } else {
             __x_parent = __y;
         }
         if (__root == __z) {
             __root = __y;
-        } else if (__z->parent->left == __z) {
-            __z->parent->left = __y;
+        } else if (__z->get_parent()->left == __z) {
+            __z->get_parent()->left = __y;
         } else { 
-            __z->parent->right = __y;
+            __z->get_parent()->right = __y;
         }
-        __y->parent = __z->parent;
-        std::swap(__y->color, __z->color);
+        __y->set_parent(__z->get_parent());
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+        __y->size = __z->size;
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+        __rb_tree_color_type __c = __y->get_color();
+        __y->set_color(__z->get_color());
+        __z->set_color(__c);
         __y = __z;
         // __y now points to node to be actually deleted
     } else {                        // __y == __z
-        __x_parent = __y->parent;
-        if (__x) __x->parent = __y->parent;   
+        __x_parent = __y->get_parent();
+        if (__x) __x->set_parent(__y->get_parent());   
         if (__root == __z) {
             __root = __x;
         } else {
-            if (__z->parent->left == __z) {
-                __z->parent->left = __x;
+            if (__z->get_parent()->left == __z) {
+                __z->get_parent()->left = __x;
             } else {
-                __z->parent->right = __x;
+                __z->get_parent()->right = __x;
             }
         }
         if (__leftmost == __z) {
             if (__z->right == 0) {        // __z->_M_left must be null also
-                __leftmost = __z->parent;
+                __leftmost = __z->get_parent();
                 // makes __leftmost == _M_header if __z == __root
             } else {
                 __leftmost = __rb_tree_node_base::minimum(__x);
@@ -737,150 +1564,316 @@ __rb_tree_rebalance_for_erase(__rb_tree_node_base* __z,
         }
         if (__rightmost == __z) {
             if (__z->left == 0) {         // __z->_M_right must be null also
-                __rightmost = __z->parent;  
+                __rightmost = __z->get_parent();  
                 // makes __rightmost == _M_header if __z == __root
             } else {                     // __x == __z->_M_left
                 __rightmost = __rb_tree_node_base::maximum(__x);
             }
         }
     }
-    if (__y->color != __rb_tree_red) { 
-        while (__x != __root && (__x == 0 || __x->color == __rb_tree_black)) {
+    if (__y->get_color() != __rb_tree_red) { 
+        while (__x != __root && (__x == 0 || __x->get_color() == __rb_tree_black)) {
             if (__x == __x_parent->left) {
                 __rb_tree_node_base* __w = __x_parent->right;
-                if (__w->color == __rb_tree_red) {
-                    __w->color = __rb_tree_black;
-                    __x_parent->color = __rb_tree_red;
+                if (__w->get_color() == __rb_tree_red) {
+                    __w->set_color(__rb_tree_black);
+                    __x_parent->set_color(__rb_tree_red);
                     __rb_tree_rotate_left(__x_parent, __root);
                     __w = __x_parent->right;
                 }
                 if ((__w->left == 0 || 
-                    __w->left->color == __rb_tree_black) &&
+                    __w->left->get_color() == __rb_tree_black) &&
                     (__w->right == 0 || 
-                    __w->right->color == __rb_tree_black))
+                    __w->right->get_color() == __rb_tree_black))
                 {
-                    __w->color = __rb_tree_red;
+                    __w->set_color(__rb_tree_red);
                     __x = __x_parent;
-                    __x_parent = __x_parent->parent;
+                    __x_parent = __x_parent->get_parent();
                 } else {
                     if (__w->right == 0 || 
-                        __w->right->color == __rb_tree_black)
+                        __w->right->get_color() == __rb_tree_black)
                     {
-                        if (__w->left) __w->left->color = __rb_tree_black;
-                        __w->color = __rb_tree_red;
+                        if (__w->left) __w->left->set_color(__rb_tree_black);
+                        __w->set_color(__rb_tree_red);
                         __rb_tree_rotate_right(__w, __root);
                         __w = __x_parent->right;
                     }
-                    __w->color = __x_parent->color;
-                    __x_parent->color = __rb_tree_black;
-                    if (__w->right) __w->right->color = __rb_tree_black;
+                    __w->set_color(__x_parent->get_color());
+                    __x_parent->set_color(__rb_tree_black);
+                    if (__w->right) __w->right->set_color(__rb_tree_black);
                     __rb_tree_rotate_left(__x_parent, __root);
                     break;
                 }
             } else {                  // same as above, with _M_right <-> _M_left.
                 __rb_tree_node_base* __w = __x_parent->left;
-                if (__w->color == __rb_tree_red) {
-                    __w->color = __rb_tree_black;
-                    __x_parent->color = __rb_tree_red;
+                if (__w->get_color() == __rb_tree_red) {
+                    __w->set_color(__rb_tree_black);
+                    __x_parent->set_color(__rb_tree_red);
                     __rb_tree_rotate_right(__x_parent, __root);
                     __w = __x_parent->left;
                 }
-                if ((__w->right == 0 || __w->right->color == __rb_tree_black) &&
-                    (__w->left == 0 || __w->left->color == __rb_tree_black))
+                if ((__w->right == 0 || __w->right->get_color() == __rb_tree_black) &&
+                    (__w->left == 0 || __w->left->get_color() == __rb_tree_black))
                 {
-                    __w->color = __rb_tree_red;
+                    __w->set_color(__rb_tree_red);
                     __x = __x_parent;
-                    __x_parent = __x_parent->parent;
+                    __x_parent = __x_parent->get_parent();
                 } else {
-                    if (__w->left == 0 || __w->left->color == __rb_tree_black) {
-                        if (__w->right) __w->right->color = __rb_tree_black;
-                        __w->color = __rb_tree_red;
+                    if (__w->left == 0 || __w->left->get_color() == __rb_tree_black) {
+                        if (__w->right) __w->right->set_color(__rb_tree_black);
+                        __w->set_color(__rb_tree_red);
                         __rb_tree_rotate_left(__w, __root);
                         __w = __x_parent->left;
                     }
-                    __w->color = __x_parent->color;
-                    __x_parent->color = __rb_tree_black;
-                    if (__w->left) __w->left->color = __rb_tree_black;
+                    __w->set_color(__x_parent->get_color());
+                    __x_parent->set_color(__rb_tree_black);
+                    if (__w->left) __w->left->set_color(__rb_tree_black);
                     __rb_tree_rotate_right(__x_parent, __root);
                     break;
                 }
             }
-            if (__x) __x->color = __rb_tree_black;
         }
+        if (__x) __x->set_color(__rb_tree_black);
     }
     return __y;
 }
 
-// 寻找 RB 树中是否有键值为 k 的节点
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::find(const Key& k)
+// 全局函数
+// 子树的黑高度: 自 x 至空节点的任一路径上的黑节点个数
+inline int __rb_tree_black_height(const __rb_tree_node_base* x)
 {
-    link_type y = header;       // Last node which is not less than k.
-    link_type x = root();       // Current node.
+    int h = 0;
+    for ( ; x != 0; x = x->left) {
+        if (x->get_color() == __rb_tree_black) ++h;
+    }
+    return h;
+}
 
-    while (x != 0) {
-        // 以下, key_compare 是节点键值大小比较准则. 应该会是个 function object
-        if (!key_compare(key(x), k)) {
-            // x 键值大于 k, 遇到大值向左走
-            y = x, x = left(x);
-        } else {
-            // x 键值小于 k, 遇到小值向右走
-            x = right(x);
+// 全局函数
+// 接合之前子树的根总被染黑, 以下所说的黑高度都是根染黑之后的黑高度. O(log n)
+inline int __rb_tree_root_black_height(const __rb_tree_node_base* x)
+{
+    return x == 0 ? 0 : __rb_tree_black_height(x) + (x->get_color() == __rb_tree_red);
+}
+
+// 全局函数
+// 已知父节点(计为黑)的黑高度 h, 得出其子节点 c 的子树的黑高度. O(1)
+inline int __rb_tree_child_height(int h, const __rb_tree_node_base* c)
+{
+    return h - 1 + (c != 0 && c->get_color() == __rb_tree_red);
+}
+
+// 全局函数
+// 接合(join): l 的所有节点都在 k 之前, r 的所有节点都在 k 之后, 返回接合后的根.
+// hl, hr 为 l, r 的黑高度, 接合结果的黑高度经由 h 传回.
+// 沿较高那棵树的右(左)脊下行, 找到与另一棵树黑高度相同的黑节点 c, 以红色的 k 取代 c 的位置,
+// 令 c 和另一棵树成为 k 的两个子树, 再以 __rb_tree_rebalance() 消除可能的红-红冲突.
+// O(|hl - hr| + 1). 各子树的根的 parent 必须为 0
+inline __rb_tree_node_base*
+__rb_tree_join(__rb_tree_node_base* l, int hl, __rb_tree_node_base* k,
+               __rb_tree_node_base* r, int hr, int& h)
+{
+    if (l != 0) l->set_color(__rb_tree_black);  // 根染黑不影响红黑性质
+    if (r != 0) r->set_color(__rb_tree_black);
+
+    __rb_tree_node_base* root;
+    __rb_tree_node_base* p = 0;
+    __rb_tree_node_base* c;
+    if (hl == hr) {
+        k->left = l;
+        k->right = r;
+        k->set_parent(0);
+        k->set_color(__rb_tree_black);
+        if (l != 0) l->set_parent(k);
+        if (r != 0) r->set_parent(k);
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+        __rb_tree_update_size(k);
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+        h = hl + 1;
+        return k;
+    } else if (hl > hr) {
+        c = l;
+        int hc = hl;
+        while (c != 0 && (c->get_color() == __rb_tree_red || hc > hr)) {
+            if (c->get_color() == __rb_tree_black) --hc;
+            p = c;
+            c = c->right;
         }
+        p->right = k;
+        k->left = c;
+        k->right = r;
+        root = l;
+        h = hl;
+    } else {
+        c = r;
+        int hc = hr;
+        while (c != 0 && (c->get_color() == __rb_tree_red || hc > hl)) {
+            if (c->get_color() == __rb_tree_black) --hc;
+            p = c;
+            c = c->left;
+        }
+        p->left = k;
+        k->left = l;
+        k->right = c;
+        root = r;
+        h = hr;
+    }
+    k->set_parent(p);
+    if (k->left != 0) k->left->set_parent(k);
+    if (k->right != 0) k->right->set_parent(k);
+#ifdef __STL_RB_TREE_SUBTREE_SIZE
+    __rb_tree_update_size(k);
+    // k 取代了 c, 沿途的祖先多出 k 及另一棵树
+    size_t added = k->size - __rb_tree_subtree_size(c);
+    for ( ; p != 0; p = p->get_parent()) {
+        p->size += added;
     }
-    iterator j = iterator(y);
-    return (j == end() || key_compare(k, key(j.node))) ? end() : j;
+#endif /* __STL_RB_TREE_SUBTREE_SIZE */
+    if (__rb_tree_rebalance(k, root)) ++h;  // 红色一路上推到根时, 黑高度加 1
+    return root;
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::count(const Key& k) const
+// 全局函数
+// 摘下 t 的最大节点, 经由 k 传回; 返回其余节点构成的树, 其黑高度经由 h 传回.
+// ht 为 t 的黑高度. 沿右脊逐层接合, 各层的黑高度差相加仍是 O(log n)
+inline __rb_tree_node_base*
+__rb_tree_split_last(__rb_tree_node_base* t, int ht, __rb_tree_node_base*& k, int& h)
 {
-    pair<const_iterator, const_iterator> p = equal_range(k);
-    size_type n = 0;
-    distance(p.first, p.second, n);
-    return n;
+    __rb_tree_node_base* l = t->left;
+    __rb_tree_node_base* r = t->right;
+    int hl = __rb_tree_child_height(ht, l);
+    if (l != 0) l->set_parent(0);
+    if (r == 0) {
+        k = t;
+        h = hl;
+        return l;
+    }
+    r->set_parent(0);
+    int hrest;
+    __rb_tree_node_base* rest = __rb_tree_split_last(r, __rb_tree_child_height(ht, r), k, hrest);
+    return __rb_tree_join(l, hl, t, rest, hrest, h);
+}
+
+// 全局函数
+// 没有中间节点的接合: 从 l 中摘下最大节点, 以它作为中间节点. O(log n)
+inline __rb_tree_node_base*
+__rb_tree_join(__rb_tree_node_base* l, int hl, __rb_tree_node_base* r, int hr, int& h)
+{
+    if (l == 0) {
+        h = hr;
+        return r;
+    }
+    if (r == 0) {
+        h = hl;
+        return l;
+    }
+    __rb_tree_node_base* k;
+    int hrest;
+    __rb_tree_node_base* rest = __rb_tree_split_last(l, hl, k, hrest);
+    return __rb_tree_join(rest, hrest, k, r, hr, h);
 }
 
+// 全局函数
+// 不知道黑高度时的接合: 先沿左脊数出黑高度, O(log n)
+inline __rb_tree_node_base*
+__rb_tree_join(__rb_tree_node_base* l, __rb_tree_node_base* k, __rb_tree_node_base* r)
+{
+    int h;
+    return __rb_tree_join(l, __rb_tree_root_black_height(l), k,
+                          r, __rb_tree_root_black_height(r), h);
+}
+
+inline __rb_tree_node_base*
+__rb_tree_join(__rb_tree_node_base* l, __rb_tree_node_base* r)
+{
+    int h;
+    return __rb_tree_join(l, __rb_tree_root_black_height(l),
+                          r, __rb_tree_root_black_height(r), h);
+}
+
+// 全局函数
+// 依位置分割(不比较键值): 把以 t 为根的树分成 n 之前的 lo 和 n 及其后的 hi.
+// 从 n 往上走到根, 沿途每个祖先连同它另一侧的子树, 接合到 lo 或 hi.
+// 只在开始时数一次 n 的黑高度, 往上每一层由颜色推算, 整个分割为 O(log n)
+inline void
+__rb_tree_split_before(__rb_tree_node_base* t, __rb_tree_node_base* n,
+                       __rb_tree_node_base*& lo, __rb_tree_node_base*& hi)
+{
+    __rb_tree_node_base* x = n;
+    __rb_tree_node_base* p = (n == t) ? 0 : n->get_parent();
+    __rb_tree_node_base* l = n->left;
+    __rb_tree_node_base* r = n->right;
+    // hx 为 x 原本(未染色之前)的黑高度; 兄弟子树的黑高度与之相同
+    int hx = __rb_tree_black_height(n);
+    const int hc = hx - (n->get_color() == __rb_tree_black);    // n 的子树原本的黑高度
+    if (l != 0) l->set_parent(0);
+    if (r != 0) r->set_parent(0);
+    __rb_tree_node_base* lo_tmp = l;
+    int hlo = hc + (l != 0 && l->get_color() == __rb_tree_red);
+    int hhi;
+    __rb_tree_node_base* hi_tmp =
+        __rb_tree_join(0, 0, n, r, hc + (r != 0 && r->get_color() == __rb_tree_red), hhi);
+    while (p != 0) {
+        __rb_tree_node_base* pp = (p == t) ? 0 : p->get_parent();
+        const int hp = hx + (p->get_color() == __rb_tree_black);   // 接合会改变 p 的颜色, 先算出
+        if (x == p->right) {
+            __rb_tree_node_base* pl = p->left;
+            if (pl != 0) pl->set_parent(0);
+            lo_tmp = __rb_tree_join(pl, hx + (pl != 0 && pl->get_color() == __rb_tree_red),
+                                    p, lo_tmp, hlo, hlo);
+        } else {
+            __rb_tree_node_base* pr = p->right;
+            if (pr != 0) pr->set_parent(0);
+            hi_tmp = __rb_tree_join(hi_tmp, hhi, p,
+                                    pr, hx + (pr != 0 && pr->get_color() == __rb_tree_red), hhi);
+        }
+        x = p;
+        hx = hp;
+        p = pp;
+    }
+    lo = lo_tmp;
+    hi = hi_tmp;
+}
+
+// 寻找 RB 树中第一个键值不小于 k 的节点, 没有则返回 header
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::lower_bound(const Key& k)
+template <class K>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__lower_bound(const K& k) const
 {
-    link_type y = header;   // last node which is not less than k
-    link_type x = root();   // current node
+    link_type y = header;       // Last node which is not less than k.
+    link_type x = root();       // Current node.
 
     while (x != 0) {
-        if (!key_compare(Key(x), k)) {
+        // 以下, key_compare 是节点键值大小比较准则. 应该会是个 function object
+        if (!key_compare(key(x), k)) {
+            // x 键值大于 k, 遇到大值向左走
             y = x, x = left(x);
         } else {
+            // x 键值小于 k, 遇到小值向右走
             x = right(x);
         }
     }
-    return iterator(y);
+    return y;
 }
 
+// 寻找 RB 树中第一个键值大于 k 的节点, 没有则返回 header
 template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::upper_bound(const Key& k)
+template <class K>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__upper_bound(const K& k) const
 {
-    link_type y = header;   // last node which is not less than k
+    link_type y = header;   // last node which is greater than k
     link_type x = root();   // current node
 
     while (x != 0) {
-        if (key_compare(k, Key(x))) {
+        if (key_compare(k, key(x))) {
             y = x, x = left(x);
         } else {
             x = right(x);
         }
     }
-    return iterator(y);
+    return y;
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator,
-          typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator>
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::equal_range(const Key& k)
-{
-    return pair<iterator, iterator>(lower_bound(k), upper_bound(k));
-}
+#endif /* __STL_TREE_H */
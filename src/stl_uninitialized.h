@@ -2,6 +2,7 @@
 #define __STL_UNINITIALIZED_H
 
 #include <algorithm>
+#include <cstring>
 
 #include "stl_construct.h"
 #include "type_traits.h"
@@ -37,7 +38,7 @@ inline ForwardInterator
 __uninitialized_fill_n_aux(ForwardInterator first, Size n,
                                                    const T& x, __true_type)
 {
-    return fill_n(first, n, x);     // 交由高阶函数执行. 见 6.4.2 节
+    return std::fill_n(first, n, x);     // 交由高阶函数执行. 见 6.4.2 节
 }
 
 // 如果不是 POD 型别, 执行流程就会转进到以下函数. 这是藉由 function template
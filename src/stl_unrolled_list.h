@@ -0,0 +1,360 @@
+#ifndef __STL_UNROLLED_LIST_H
+#define __STL_UNROLLED_LIST_H
+
+#include <cstddef>
+
+#include "stl_config.h"
+#include "stl_iterator.h"
+#include "stl_alloc.h"
+#include "stl_construct.h"
+#include "stl_list.h"
+
+namespace cstl
+{
+
+// 展开链表(unrolled linked list)
+// list 的每个节点只放一个元素, 遍历时每前进一步就是一次 cache miss.
+// unrolled_list 的每个节点放最多 K 个元素(连续存放), 节点之间仍是环状双向链表,
+// 所以遍历时大部分的 ++ 只是数组下标加 1.
+// K 为 0 时, 与 deque 的 __deque_buf_size() 同理, 由元素大小决定: 每节点约 256 bytes
+//
+// 注意: 在某节点中插入或删除元素, 会使指向该节点(以及因分裂/合并而受影响的相邻节点)
+// 的所有迭代器失效. 这一点与 list 不同, 与 deque 相近
+
+template <class T, size_t N>
+struct __unrolled_list_node {
+    __unrolled_list_node* prev;
+    __unrolled_list_node* next;
+    size_t count;   // 本节点目前存放的元素个数
+    T data[N];      // 只有 [0, count) 是已构造的对象
+};
+
+template <class T, class Ref, class Ptr, size_t N>
+struct __unrolled_list_iterator {
+    typedef __unrolled_list_iterator<T, T&, T*, N> iterator;
+    typedef __unrolled_list_iterator<T, Ref, Ptr, N> self;
+
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef Ptr pointer;
+    typedef Ref reference;
+    typedef __unrolled_list_node<T, N>* link_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    link_type node;     // 所在节点
+    size_type idx;      // 在节点内的位置
+
+    __unrolled_list_iterator(link_type x, size_type i) : node(x), idx(i) { }
+    __unrolled_list_iterator() { }
+    __unrolled_list_iterator(const iterator& x) : node(x.node), idx(x.idx) { }
+
+    bool operator==(const self& x) const { return node == x.node && idx == x.idx; }
+    bool operator!=(const self& x) const { return !(*this == x); }
+    reference operator*() const { return node->data[idx]; }
+    pointer operator->() const { return &(operator*()); }
+
+    self& operator++()
+    {
+        if (++idx == node->count) {     // 走出本节点, 切换至下一节点的第一个元素
+            node = node->next;          // 头节点的 count 为 0, 所以 end() 即 (头节点, 0)
+            idx = 0;
+        }
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    self& operator--()
+    {
+        if (idx == 0) {                 // 切换至上一节点的最后一个元素
+            node = node->prev;
+            idx = node->count - 1;
+        } else {
+            --idx;
+        }
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+};
+
+template <class T, size_t K = 0, class Alloc = alloc>
+class unrolled_list {
+public:
+    enum { node_capacity = K != 0 ? K : (sizeof(T) < 256 ? 256 / sizeof(T) : 1) };
+
+protected:
+    typedef __unrolled_list_node<T, node_capacity> list_node;
+    typedef simple_alloc<list_node, Alloc> list_node_allocator;
+public:
+    typedef __unrolled_list_iterator<T, T&, T*, node_capacity>             iterator;
+    typedef __unrolled_list_iterator<T, const T&, const T*, node_capacity> const_iterator;
+
+    typedef T                 value_type;
+    typedef value_type*       pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type&       reference;
+    typedef const value_type& const_reference;
+    typedef size_t            size_type;
+    typedef ptrdiff_t         difference_type;
+    typedef list_node*        link_type;
+
+protected:
+    link_type node;         // 头节点, 不存放元素 (count 恒为 0)
+    size_type num_elements;
+
+public:
+    unrolled_list() : num_elements(0) { empty_initialize(); }
+    unrolled_list(const unrolled_list& x) : num_elements(0)
+    {
+        empty_initialize();
+        __STL_TRY {
+            for (const_iterator it = x.begin(); it != x.end(); ++it) push_back(*it);
+        }
+        __STL_UNWIND(clear(); put_node(node));
+    }
+    ~unrolled_list()
+    {
+        clear();
+        put_node(node);
+    }
+    unrolled_list& operator=(const unrolled_list& x)
+    {
+        if (this != &x) {
+            unrolled_list tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    iterator begin() { return iterator(node->next, 0); }
+    iterator end() { return iterator(node, 0); }
+    const_iterator begin() const { return const_iterator(node->next, 0); }
+    const_iterator end() const { return const_iterator(node, 0); }
+    bool empty() const { return num_elements == 0; }
+    size_type size() const { return num_elements; }
+    size_type node_count() const
+    {
+        size_type result = 0;
+        for (link_type p = node->next; p != node; p = p->next) ++result;
+        return result;
+    }
+
+    reference front() { return node->next->data[0]; }
+    reference back() { return node->prev->data[node->prev->count - 1]; }
+
+    void push_front(const T& x) { insert(begin(), x); }
+    void push_back(const T& x)
+    {
+        link_type last = node->prev;
+        if (last != node && last->count < node_capacity) {     // 尾节点尚有空间
+            construct(&last->data[last->count], x);
+            ++last->count;
+            ++num_elements;
+        } else {
+            insert(end(), x);
+        }
+    }
+    void pop_front() { erase(begin()); }
+    void pop_back()
+    {
+        iterator tmp = end();
+        erase(--tmp);
+    }
+
+    // 在 position 之前插入 x. 节点已满时将它对半分裂. O(K)
+    iterator insert(iterator position, const T& x);
+
+    // 移除 position 所指元素. 节点过空时与后继节点合并. O(K)
+    iterator erase(iterator position);
+    iterator erase(iterator first, iterator last)
+    {
+        // erase() 可能合并节点, 使 last 失效, 所以先数出要删除几个元素
+        size_type n = 0;
+        for (iterator it = first; it != last; ++it) ++n;
+        while (n-- != 0) first = erase(first);
+        return first;
+    }
+
+    void clear();
+
+    // 将 x 的全部元素接合于 position 之前. 若 position 位于节点中间, 先分裂该节点,
+    // 然后以 __list_transfer() 整串搬移节点, 不复制任何元素
+    void splice(iterator position, unrolled_list& x)
+    {
+        if (!x.empty()) {
+            link_type pos = split(position);
+            __list_transfer(pos, x.node->next, x.node);
+            num_elements += x.num_elements;
+            x.num_elements = 0;
+        }
+    }
+
+    // 将 [first, last) 接合于 position 之前. 以节点为单位搬移, 只有头尾两个节点可能需要分裂.
+    // position 不能位于 (first, last) 之内; position 为 first 或 last 时什么也不做
+    void splice(iterator position, unrolled_list& x, iterator first, iterator last)
+    {
+        if (first == last || position == first || position == last) return;
+        link_type l = x.split(last);    // 先分裂 last, first 仍然有效
+        if (last.idx != 0 && position.node == last.node && position.idx > last.idx) {
+            // 同一个 list 中 position 在 last 之后且同处一个节点: 它已随 last 搬到 l
+            position = iterator(l, position.idx - last.idx);
+        }
+        link_type f = x.split(first);
+        size_type n = 0;
+        for (link_type p = f; p != l; p = p->next) n += p->count;
+        link_type pos = split(position);
+        __list_transfer(pos, f, l);
+        num_elements += n;
+        x.num_elements -= n;
+    }
+
+    void swap(unrolled_list& x)
+    {
+        std::swap(node, x.node);
+        std::swap(num_elements, x.num_elements);
+    }
+
+protected:
+    link_type get_node() { return list_node_allocator::allocate(); }
+    void put_node(link_type p) { list_node_allocator::deallocate(p); }
+
+    void empty_initialize()
+    {
+        node = get_node();
+        node->next = node;
+        node->prev = node;
+        node->count = 0;
+    }
+
+    // 配置一个空节点, 串接于 pos 之前
+    link_type link_new_node(link_type pos)
+    {
+        link_type tmp = get_node();
+        tmp->count = 0;
+        tmp->next = pos;
+        tmp->prev = pos->prev;
+        pos->prev->next = tmp;
+        pos->prev = tmp;
+        return tmp;
+    }
+
+    void unlink_node(link_type p)
+    {
+        p->prev->next = p->next;
+        p->next->prev = p->prev;
+        put_node(p);
+    }
+
+    // 将 src 的 [first, src->count) 搬到 dst 的尾端
+    static void move_tail(link_type src, size_type first, link_type dst)
+    {
+        for (size_type i = first; i < src->count; ++i) {
+            construct(&dst->data[dst->count++], src->data[i]);
+            destroy(&src->data[i]);
+        }
+        src->count = first;
+    }
+
+    // 使 position 成为某节点的第一个元素, 返回该节点
+    link_type split(iterator position)
+    {
+        if (position.idx == 0) return position.node;
+        link_type tmp = link_new_node(position.node->next);
+        move_tail(position.node, position.idx, tmp);
+        return tmp;
+    }
+};
+
+template <class T, size_t K, class Alloc>
+typename unrolled_list<T, K, Alloc>::iterator
+unrolled_list<T, K, Alloc>::insert(iterator position, const T& x)
+{
+    link_type p = position.node;
+    size_type i = position.idx;
+    if (p == node) {            // end(): 插入到尾节点的最后
+        p = node->prev;
+        if (p == node || p->count == node_capacity) {
+            p = link_new_node(node);
+        }
+        i = p->count;
+    } else if (p->count == node_capacity) {
+        // 节点已满: 后半段搬到新节点, 再决定插入哪一半
+        link_type tmp = link_new_node(p->next);
+        move_tail(p, node_capacity / 2, tmp);
+        if (i > p->count) {
+            i -= p->count;
+            p = tmp;
+        }
+    }
+
+    // 节点内, [i, count) 向后挪一格
+    if (i == p->count) {
+        construct(&p->data[i], x);
+    } else {
+        T x_copy = x;
+        construct(&p->data[p->count], p->data[p->count - 1]);
+        for (size_type j = p->count - 1; j > i; --j) {
+            p->data[j] = p->data[j - 1];
+        }
+        p->data[i] = x_copy;
+    }
+    ++p->count;
+    ++num_elements;
+    return iterator(p, i);
+}
+
+template <class T, size_t K, class Alloc>
+typename unrolled_list<T, K, Alloc>::iterator
+unrolled_list<T, K, Alloc>::erase(iterator position)
+{
+    link_type p = position.node;
+    size_type i = position.idx;
+    for (size_type j = i + 1; j < p->count; ++j) {
+        p->data[j - 1] = p->data[j];
+    }
+    destroy(&p->data[--p->count]);
+    --num_elements;
+
+    if (p->count == 0) {                // 节点已空, 释放之
+        link_type next = p->next;
+        unlink_node(p);
+        return iterator(next, 0);
+    }
+    // 与后继节点合起来不超过半满时, 把后继节点并入本节点, 保持节点的密度
+    link_type next = p->next;
+    if (next != node && p->count + next->count <= node_capacity / 2) {
+        move_tail(next, 0, p);
+        unlink_node(next);
+    }
+    if (i == p->count) return iterator(p->next, 0);
+    return iterator(p, i);
+}
+
+template <class T, size_t K, class Alloc>
+void unrolled_list<T, K, Alloc>::clear()
+{
+    link_type cur = node->next;
+    while (cur != node) {
+        link_type tmp = cur;
+        cur = cur->next;
+        for (size_type i = 0; i < tmp->count; ++i) destroy(&tmp->data[i]);
+        put_node(tmp);
+    }
+    node->next = node;
+    node->prev = node;
+    num_elements = 0;
+}
+
+} // namespace cstl
+
+#endif /* __STL_UNROLLED_LIST_H */
@@ -3,6 +3,7 @@
 
 #include <utility>
 
+#include "stl_algobase.h"
 #include "stl_uninitialized.h"
 #include "stl_iterator.h"
 #include "stl_alloc.h"
@@ -19,6 +20,7 @@ public:
     typedef value_type*                 iterator;       // vector 的迭代器是普通指针
     typedef const value_type*           const_iterator;
     typedef value_type&                 reference;
+    typedef const value_type&           const_reference;
     typedef size_t                      size_type;
     typedef ptrdiff_t                   difference_type;
     typedef reverse_iterator<iterator> reverse_iterator;
@@ -32,7 +34,6 @@ protected:
     iterator end_of_storage;    // 表示目前可用空间的尾
 
     void insert_aux(iterator position, const T& x);
-    void insert(iterator position, size_type n, const T& x);
 
     void deallocate()
     {
@@ -51,6 +52,8 @@ protected:
 public:
     iterator begin() { return start;  }
     iterator end()   { return finish; }
+    const_iterator begin() const { return start; }
+    const_iterator end() const   { return finish; }
     reverse_iterator rbegin() { return reverse_iterator(end()); }
     reverse_iterator rend() { return reverse_iterator(begin()); }
     size_type size() const { return size_type(end() - begin()); }
@@ -60,12 +63,27 @@ public:
     }
     bool empty() const { return begin() == end(); }
     reference operator[] (size_type n) { return *(begin() + n); }
+    const_reference operator[] (size_type n) const { return *(begin() + n); }
 
     vector() : start(0), finish(0), end_of_storage(0) { }
     vector(size_type n, const T& value) { fill_initialize(n, value); }
     vector(int n, const T& value) { fill_initialize(n, value); }
     vector(long n, const T& value) { fill_initialize(n, value); }
     explicit vector(size_type n) { fill_initialize(n, T()); }
+    vector(const vector<T, Alloc>& x)
+    {
+        start = allocate_and_copy(x.size(), x.begin(), x.end());
+        finish = start + x.size();
+        end_of_storage = finish;
+    }
+    vector<T, Alloc>& operator=(const vector<T, Alloc>& x)
+    {
+        if (this != &x) {
+            vector<T, Alloc> tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
 
     ~vector()
     {
@@ -84,6 +102,20 @@ public:
         }
     }
 
+    // 在 position 之前插入 x, 返回指向新元素的迭代器
+    iterator insert(iterator position, const T& x)
+    {
+        size_type n = position - begin();
+        if (finish != end_of_storage && position == end()) {
+            construct(finish, x);
+            ++finish;
+        } else {
+            insert_aux(position, x);
+        }
+        return begin() + n;
+    }
+    // 在 position 之前插入 n 个 x
+    void insert(iterator position, size_type n, const T& x);
     void pop_back()
     {
         --finish;
@@ -93,7 +125,7 @@ public:
     // 清除 [first, last) 中的所有元素
     iterator erase(iterator first, iterator last)
     {
-        iterator i = copy(last, finish, first);     // 见第6章
+        iterator i = cstl::copy(last, finish, first);     // 见第6章
         destroy(i, finish);
         finish = finish - (last - first);
         return first;
@@ -103,7 +135,7 @@ public:
     iterator erase(iterator position)
     {
         if (position + 1 != end()) {
-            copy(position + 1, finish, position);   // 后续元素往前移动
+            cstl::copy(position + 1, finish, position);   // 后续元素往前移动
         }
         --finish;
         destory(finish);
@@ -146,7 +178,7 @@ protected:
     iterator allocate_and_fill(size_type n , const T& x)
     {
         iterator result = data_allocator::allocate(n);
-        uninitialized_fill_n(result, n, x);
+        ::uninitialized_fill_n(result, n, x);
         return result;
     }
 
@@ -155,7 +187,7 @@ protected:
     {
         iterator result = data_allocator::allocate(n);
         __STL_TRY {
-            uninitialized_copy(first, last, result);
+            ::uninitialized_copy(first, last, result);
             return result;
         }
         __STL_UNWIND(data_allocator::deallocate(result, n));
@@ -171,7 +203,7 @@ void vector<T, Alloc>::insert_aux(iterator position, const T& x)
         // 调整水位
         ++finish;
         T x_copy = x;
-        copy_backward(position, finish - 2, finish - 1);
+        cstl::copy_backward(position, finish - 2, finish - 1);
         *position = x_copy;
     } else {    // 以无备用空间
         const size_type old_size = size();
@@ -184,13 +216,13 @@ void vector<T, Alloc>::insert_aux(iterator position, const T& x)
         iterator new_finish = new_start;
         try {
             // 将原 vector 的内容拷贝到新 vector
-            new_finish = uninitialized_copy(start, position, new_start);
+            new_finish = ::uninitialized_copy(start, position, new_start);
             // 为新元素设定初值 x
             construct(new_finish, x);
             // 调整水位
             ++new_finish;
             // 将安插点的原内容也拷贝过来(提示: 本函数也可能被 insert(p, x) 调用)
-            new_finish = uninitialized_copy(position, finish, new_finish);
+            new_finish = ::uninitialized_copy(position, finish, new_finish);
         } catch (...) {
             // "commit or rollback" semantics.
             destory(new_start, new_finish);
@@ -222,17 +254,17 @@ void vector<T, Alloc>::insert(iterator position, size_type n, const T& x)
             iterator old_finish = finish;
             if (elems_after > n) {
                 // "插入点之后的现有元素个数" 大于 "新增元素个数"
-                uninitialized_copy(finish - n, finish, finish);
+                ::uninitialized_copy(finish - n, finish, finish);
                 finish += n;    // 将 vector 尾端标记后移
-                copy_backward(position, old_finish - n, old_finish);
-                fill(position, position + n, x_copy);   // 从插入点开始填入新值
+                cstl::copy_backward(position, old_finish - n, old_finish);
+                cstl::fill(position, position + n, x_copy);   // 从插入点开始填入新值
             } else {
                 // "插入点之后的现有元素个数" 小于等于 "新增元素个数"
-                uninitialized_fill_n(finish, n - elems_after, x_copy);
+                ::uninitialized_fill_n(finish, n - elems_after, x_copy);
                 finish += n - elems_after;
-                uninitialized_copy(position, old_finish, finish);
+                ::uninitialized_copy(position, old_finish, finish);
                 finish += elems_after;
-                fill(position, old_finish, x_copy);
+                cstl::fill(position, old_finish, x_copy);
             }
         } else {
             // 备用空间小于 "新增元素个数" (必须配置额外的空间)
@@ -244,11 +276,11 @@ void vector<T, Alloc>::insert(iterator position, size_type n, const T& x)
             iterator new_finish = new_start;
             __STL_TRY {
                 // 以下首先将旧 vector 的插入点之前的元素复制到新空间
-                new_finish = uninitialized_copy(start, position, new_start);
+                new_finish = ::uninitialized_copy(start, position, new_start);
                 // 以下再将新增元素(初值皆为 x )填入新空间
-                new_finish = uninitialized_fill_n(new_finish, n, x);
+                new_finish = ::uninitialized_fill_n(new_finish, n, x);
                 // 以下再将旧 vector 的插入点之后的元素复制到新空间
-                new_finish = uninitialized_copy(position, finish, new_finish);
+                new_finish = ::uninitialized_copy(position, finish, new_finish);
             }
 #ifdef __STL_USE_EXCEPTIONS
             catch(...) {
@@ -0,0 +1,188 @@
+#ifndef __STL_WS_DEQUE_H
+#define __STL_WS_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "../src/stl_config.h"
+#include "../src/stl_alloc.h"
+#include "../src/stl_construct.h"
+
+// Chase-Lev 工作窃取双端队列 (work-stealing deque)
+// 拥有者(owner)线程在 bottom 端 push/pop, 其他线程(thief)在 top 端 steal.
+// 内存次序采用 Lê, Pop, Cohen, Zappa Nardelli (PPoPP 2013) 给出的 C++11 版本.
+// 元素被 thief 以原子方式读取, 所以 T 必须是可平凡复制的型别(通常是任务指针)
+
+// 环形缓冲区. 容量永远是 2 的幂, 以 & mask 取代 % size
+// 与 deque 的 map 类似, 满了就配置一块两倍大的缓冲区, 把有效元素搬过去
+template <class T>
+struct __ws_deque_array {
+    std::atomic<T>* buffer;
+    ptrdiff_t mask;
+    __ws_deque_array* prev;     // 被替换掉的旧缓冲区, 串起来待析构时一并释放
+
+    ptrdiff_t size() const { return mask + 1; }
+
+    T get(ptrdiff_t i) const
+    {
+        return buffer[i & mask].load(std::memory_order_relaxed);
+    }
+    void put(ptrdiff_t i, const T& x)
+    {
+        buffer[i & mask].store(x, std::memory_order_relaxed);
+    }
+};
+
+// 每个工作线程各有一个 ws_deque, 各自在自己的线程里扩充缓冲区,
+// 而第二级配置器的 free list 不是线程安全的, 所以缺省使用 malloc_alloc
+template <class T, class Alloc = malloc_alloc>
+class ws_deque {
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+private:
+    typedef __ws_deque_array<T> array_type;
+    typedef simple_alloc<array_type, Alloc> array_allocator;
+    typedef simple_alloc<std::atomic<T>, Alloc> data_allocator;
+
+    enum { __ws_cache_line = 64 };
+    enum { initial_size = 64 };     // 初始缓冲区容量
+
+    // top 由 thief 竞争, bottom 只由 owner 写入, 两者分处不同的 cache line
+    std::atomic<ptrdiff_t> top;
+    char pad0[__ws_cache_line - sizeof(std::atomic<ptrdiff_t>)];
+    std::atomic<ptrdiff_t> bottom;
+    std::atomic<array_type*> array;
+    char pad1[__ws_cache_line - sizeof(std::atomic<ptrdiff_t>) - sizeof(std::atomic<array_type*>)];
+
+    static array_type* allocate_array(ptrdiff_t n, array_type* prev)
+    {
+        array_type* a = array_allocator::allocate();
+        a->buffer = data_allocator::allocate(n);
+        for (ptrdiff_t i = 0; i < n; ++i) {
+            construct(&a->buffer[i], T());
+        }
+        a->mask = n - 1;
+        a->prev = prev;
+        return a;
+    }
+
+    static void deallocate_array(array_type* a)
+    {
+        data_allocator::deallocate(a->buffer, a->size());
+        array_allocator::deallocate(a);
+    }
+
+    // 只由 owner 调用. 旧缓冲区可能仍有 thief 在读, 所以不能立即释放,
+    // 只挂在新缓冲区的 prev 上, 等 ws_deque 析构时再归还
+    array_type* grow(array_type* a, ptrdiff_t b, ptrdiff_t t)
+    {
+        array_type* tmp = allocate_array(a->size() * 2, a);
+        for (ptrdiff_t i = t; i < b; ++i) {
+            tmp->put(i, a->get(i));
+        }
+        array.store(tmp, std::memory_order_release);
+        return tmp;
+    }
+
+public:
+    ws_deque() : top(0), bottom(0)
+    {
+        array.store(allocate_array(initial_size, 0), std::memory_order_relaxed);
+    }
+
+    ~ws_deque()
+    {
+        array_type* a = array.load(std::memory_order_relaxed);
+        while (a) {
+            array_type* prev = a->prev;
+            deallocate_array(a);
+            a = prev;
+        }
+    }
+
+    // 近似值: 并发情况下只能作为参考
+    size_type size() const
+    {
+        ptrdiff_t b = bottom.load(std::memory_order_relaxed);
+        ptrdiff_t t = top.load(std::memory_order_relaxed);
+        return b > t ? size_type(b - t) : 0;
+    }
+    bool empty() const { return size() == 0; }
+
+public:
+    // 只能由 owner 调用: 放到 bottom 端
+    void push(const value_type& x)
+    {
+        ptrdiff_t b = bottom.load(std::memory_order_relaxed);
+        ptrdiff_t t = top.load(std::memory_order_acquire);
+        array_type* a = array.load(std::memory_order_relaxed);
+        if (b - t > a->size() - 1) {    // 缓冲区已满, 扩充之
+            a = grow(a, b, t);
+        }
+        a->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // 只能由 owner 调用: 从 bottom 端取出. 队列为空(或最后一个元素被偷走)时返回 false,
+    // 此时 x 保持不变
+    bool pop(value_type& x)
+    {
+        ptrdiff_t b = bottom.load(std::memory_order_relaxed) - 1;
+        array_type* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        ptrdiff_t t = top.load(std::memory_order_relaxed);
+
+        bool result = true;
+        if (t <= b) {                   // 非空
+            value_type tmp = a->get(b);
+            if (t == b) {
+                // 只剩最后一个元素, 与 thief 竞争 top
+                if (!top.compare_exchange_strong(t, t + 1,
+                                                 std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed)) {
+                    result = false;     // 被偷走了
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            if (result) {
+                x = tmp;
+            }
+        } else {                        // 空
+            result = false;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    // 可由任何线程调用: 从 top 端偷取. 队列为空或与他人竞争失败时返回 false, x 保持不变
+    bool steal(value_type& x)
+    {
+        ptrdiff_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        ptrdiff_t b = bottom.load(std::memory_order_acquire);
+        if (t < b) {
+            array_type* a = array.load(std::memory_order_acquire);
+            value_type tmp = a->get(t);
+            if (!top.compare_exchange_strong(t, t + 1,
+                                             std::memory_order_seq_cst,
+                                             std::memory_order_relaxed)) {
+                return false;
+            }
+            x = tmp;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    // 禁止复制
+    ws_deque(const ws_deque&);
+    ws_deque& operator=(const ws_deque&);
+};
+
+#endif /* __STL_WS_DEQUE_H */
@@ -0,0 +1,95 @@
+#include <iostream>
+
+#include "../src/stl_intrusive_list.h"
+#include "../src/stl_intrusive_slist.h"
+#include "../src/stl_intrusive_tree.h"
+#include "../src/stl_function.h"
+
+using cstl::intrusive_list;
+using cstl::list_hook;
+
+// 同一个对象同时串在两个 list, 一个 slist 和一棵 rb_tree 中
+struct conn {
+    int fd;
+    list_hook all_hook;
+    list_hook idle_hook;
+    slist_hook wheel_hook;
+    rb_tree_hook by_fd;
+
+    explicit conn(int n) : fd(n) { }
+};
+
+struct conn_fd {
+    const int& operator()(const conn& c) const { return c.fd; }
+};
+
+int main(void)
+{
+    conn c[5] = {conn(3), conn(1), conn(4), conn(0), conn(2)};
+
+    intrusive_list<conn, &conn::all_hook> all;
+    intrusive_list<conn, &conn::idle_hook> idle;
+    for (int i = 0; i < 5; ++i) {
+        all.push_back(c[i]);
+        if (c[i].fd % 2 == 0) idle.push_front(c[i]);
+    }
+    std::cout << all.size() << ' ' << idle.size() << std::endl;     // 5 3
+
+    intrusive_list<conn, &conn::all_hook>::iterator it;
+    for (it = all.begin(); it != all.end(); ++it) {
+        std::cout << it->fd << ' ';                                 // 3 1 4 0 2
+    }
+    std::cout << std::endl;
+
+    // iterator_to: 由元素直接得到迭代器, 元素确实就是容器中的那一个
+    std::cout << (&*all.iterator_to(c[2]) == &c[2]) << ' '
+              << (&*idle.iterator_to(c[2]) == &c[2]) << std::endl;  // 1 1
+
+    // 从 idle 摘下不影响 all; 元素本身仍然存在, hook 被重置
+    idle.erase(idle.iterator_to(c[2]));
+    std::cout << c[2].idle_hook.is_linked() << ' '
+              << c[2].all_hook.is_linked() << ' ' << c[2].fd << ' '
+              << idle.size() << ' ' << all.size() << std::endl;      // 0 1 4 2 5
+    // 摘下的元素可以再串接
+    idle.push_back(c[2]);
+    std::cout << idle.back().fd << ' ' << idle.size() << std::endl; // 4 3
+
+    intrusive_slist<conn, &conn::wheel_hook> wheel;
+    for (int i = 0; i < 5; ++i) {
+        wheel.push_front(c[i]);
+    }
+    wheel.erase_after(wheel.iterator_to(c[3]));     // 摘下 c[3] 之后的 c[2]
+    intrusive_slist<conn, &conn::wheel_hook>::iterator sit;
+    for (sit = wheel.begin(); sit != wheel.end(); ++sit) {
+        std::cout << sit->fd << ' ';                                // 2 0 1 3
+    }
+    std::cout << std::endl;
+    std::cout << (c[2].wheel_hook.next == 0) << std::endl;          // 1
+
+    intrusive_rb_tree<int, conn, &conn::by_fd, conn_fd, less<int> > table;
+    for (int i = 0; i < 5; ++i) {
+        table.insert_unique(c[i]);
+    }
+    std::cout << table.insert_unique(c[0]).second << ' '
+              << table.size() << std::endl;                         // 0 5
+    intrusive_rb_tree<int, conn, &conn::by_fd, conn_fd, less<int> >::iterator tit;
+    for (tit = table.begin(); tit != table.end(); ++tit) {
+        std::cout << tit->fd << ' ';                                // 0 1 2 3 4
+    }
+    std::cout << std::endl;
+    std::cout << (&*table.find(4) == &c[2]) << std::endl;           // 1
+
+    table.erase(c[1]);
+    std::cout << table.count(1) << ' ' << table.size() << ' '
+              << c[1].fd << ' ' << (table.iterator_to(c[3]) == table.begin())
+              << std::endl;                                         // 0 4 1 1
+
+    // 离开前先清空容器, 元素再随后析构
+    table.clear();
+    wheel.clear();
+    idle.clear();
+    all.clear();
+    std::cout << c[0].all_hook.is_linked() << ' ' << all.empty() << std::endl;  // 0 1
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <iostream>
+#include <thread>
+
+#include "../src/stl_mpmc_queue.h"
+
+int main(void)
+{
+    mpmc_queue<int> iq(5);
+    std::cout << "capacity=" << iq.capacity() << std::endl;    // capacity=8
+
+    for (int i = 0; i < 10; ++i) {
+        if (!iq.try_push(i)) {
+            std::cout << "full at " << i << std::endl;      // full at 8
+            break;
+        }
+    }
+    std::cout << "size=" << iq.size() << std::endl;            // size=8
+
+    int ia[8];
+    int n = iq.try_pop_batch(ia, 3);
+    for (int i = 0; i < n; ++i) {
+        std::cout << ia[i] << ' ';                          // 0 1 2
+    }
+    std::cout << std::endl;
+
+    int ib[5] = {20, 21, 22, 23, 24};
+    std::cout << iq.try_push_batch(ib, ib + 5) << std::endl;   // 3
+
+    int x;
+    while (iq.try_pop(x)) {
+        std::cout << x << ' ';                              // 3 4 5 6 7 20 21 22
+    }
+    std::cout << std::endl;
+
+    // 阻塞版本: 一个生产者, 一个消费者
+    std::thread producer([&iq]() {
+        for (int i = 1; i <= 1000; ++i) iq.push(i);
+    });
+    long sum = 0;
+    for (int i = 1; i <= 1000; ++i) {
+        iq.pop(x);
+        sum += x;
+    }
+    producer.join();
+    std::cout << "sum=" << sum << std::endl;                   // sum=500500
+
+    return 0;
+}
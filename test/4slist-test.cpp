@@ -45,5 +45,28 @@ int main(void)
         std::cout << *ite << ' ';                           // 4 2 99 1 9
     std::cout << std::endl;
 
+    islist.push_back(5);
+    std::cout << "size=" << islist.size() << ' '
+              << "back=" << islist.back() << std::endl;     // size=6 back=5
+
+    islist.sort();
+    ite = islist.begin();
+    ite2 = islist.end();
+    for ( ; ite != ite2; ++ite)
+        std::cout << *ite << ' ';                           // 1 2 4 5 9 99
+    std::cout << std::endl;
+
+    slist<int> islist2;
+    int ia[3] = {0, 3, 7};
+    islist2.push_front(ia, ia + 3);
+    islist.merge(islist2);
+    ite = islist.begin();
+    ite2 = islist.end();
+    for ( ; ite != ite2; ++ite)
+        std::cout << *ite << ' ';                           // 0 1 2 3 4 5 7 9 99
+    std::cout << std::endl;
+    std::cout << "size=" << islist.size() << ' '
+              << "size2=" << islist2.size() << std::endl;   // size=9 size2=0
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <iostream>
+
+#include "../src/stl_unrolled_list.h"
+
+using namespace cstl;
+
+int main(void)
+{
+    unrolled_list<int, 4> iul;
+    for (int i = 0; i < 8; ++i) {
+        iul.push_back(i);
+    }
+    std::cout << "size=" << iul.size() << std::endl;            // size=8
+    std::cout << "nodes=" << iul.node_count() << std::endl;     // nodes=2
+
+    unrolled_list<int, 4>::iterator ite = iul.begin();
+    ++ite;
+    ++ite;                                                      // 指向 2
+    iul.insert(ite, 99);                                        // 第一个节点已满, 分裂
+    std::cout << "nodes=" << iul.node_count() << std::endl;     // nodes=3
+
+    for (ite = iul.begin(); ite != iul.end(); ++ite)
+        std::cout << *ite << ' ';                               // 0 1 99 2 3 4 5 6 7
+    std::cout << std::endl;
+
+    ite = iul.end();
+    --ite;
+    std::cout << *ite << std::endl;                             // 7
+
+    unrolled_list<int, 4> iul2;
+    iul2.push_back(100);
+    iul2.push_back(200);
+    ite = iul.begin();
+    for (int i = 0; i < 6; ++i) ++ite;                          // 指向 5
+    iul.splice(ite, iul2);
+    std::cout << "size=" << iul.size() << ' '
+              << "size2=" << iul2.size() << std::endl;          // size=11 size2=0
+
+    ite = iul.begin();
+    for (int i = 0; i < 4; ++i) ++ite;                          // 指向 3
+    iul.erase(ite);
+    iul.pop_front();
+    for (ite = iul.begin(); ite != iul.end(); ++ite)
+        std::cout << *ite << ' ';                               // 1 99 2 4 100 200 5 6 7
+    std::cout << std::endl;
+
+    // 同一个 list 之内的区间接合: 把 [2, 200) 移到 6 之前,
+    // 其中 6 与 last(200) 位于同一个节点
+    unrolled_list<int, 4>::iterator first = iul.begin(), last, pos;
+    ++first;
+    ++first;                                                    // 指向 2
+    last = first;
+    for (int i = 0; i < 3; ++i) ++last;                         // 指向 200
+    pos = last;
+    ++pos;
+    ++pos;                                                      // 指向 6
+    iul.splice(pos, iul, first, last);
+    // position 与 last 相同时什么也不做
+    iul.splice(iul.end(), iul, iul.begin(), iul.end());
+    for (ite = iul.begin(); ite != iul.end(); ++ite)
+        std::cout << *ite << ' ';                               // 1 99 200 5 2 4 100 6 7
+    std::cout << std::endl;
+    std::cout << "size=" << iul.size() << std::endl;            // size=9
+
+    return 0;
+}
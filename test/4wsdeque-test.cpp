@@ -0,0 +1,77 @@
+#include <iostream>
+#include <atomic>
+#include <thread>
+
+#include "../src/stl_ws_deque.h"
+
+int main(void)
+{
+    ws_deque<int> dq;
+    for (int i = 0; i < 5; ++i) {
+        dq.push(i);
+    }
+    std::cout << "size=" << dq.size() << std::endl;            // size=5
+
+    // owner 从 bottom 端取(后进先出), thief 从 top 端偷(先进先出)
+    int x;
+    dq.pop(x);
+    std::cout << x << ' ';                                      // 4
+    dq.steal(x);
+    std::cout << x << ' ';                                      // 0
+    dq.pop(x);
+    std::cout << x << ' ';                                      // 3
+    dq.steal(x);
+    std::cout << x << ' ';                                      // 1
+    dq.pop(x);
+    std::cout << x << std::endl;                                // 2
+    std::cout << dq.pop(x) << dq.steal(x) << std::endl;         // 00
+    std::cout << x << std::endl;                                // 2 (失败时不改动 x)
+
+    // 超过初始容量(64)时扩充缓冲区, 元素次序不变
+    for (int i = 0; i < 200; ++i) {
+        dq.push(i);
+    }
+    std::cout << "size=" << dq.size() << std::endl;            // size=200
+    bool ordered = true;
+    for (int i = 0; i < 100; ++i) {
+        ordered = ordered && dq.steal(x) && x == i;
+    }
+    for (int i = 199; i >= 100; --i) {
+        ordered = ordered && dq.pop(x) && x == i;
+    }
+    std::cout << ordered << ' ' << dq.empty() << std::endl;     // 1 1
+
+    // 一个 owner 边放边取, 三个 thief 同时偷: 每个元素恰好被取走一次
+    const int n = 100000;
+    static std::atomic<int> taken[n];
+    for (int i = 0; i < n; ++i) {
+        taken[i].store(0);
+    }
+    ws_deque<int> work;
+    std::atomic<bool> done(false);
+    std::thread thieves[3];
+    for (int t = 0; t < 3; ++t) {
+        thieves[t] = std::thread([&work, &done]() {
+            int v;
+            while (!done.load()) {
+                if (work.steal(v)) ++taken[v];
+            }
+            while (work.steal(v)) ++taken[v];
+        });
+    }
+    for (int i = 0; i < n; ++i) {
+        work.push(i);
+        if (i % 3 == 0 && work.pop(x)) ++taken[x];
+    }
+    while (work.pop(x)) ++taken[x];
+    done.store(true);
+    for (int t = 0; t < 3; ++t) thieves[t].join();
+
+    int once = 0;
+    for (int i = 0; i < n; ++i) {
+        if (taken[i].load() == 1) ++once;
+    }
+    std::cout << "once=" << once << std::endl;                  // once=100000
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <string>
+
+#include "../src/stl_btree_set.h"
+#include "../src/stl_btree_map.h"
+
+// 复制 copy_budget 次之后, 再复制就抛出异常
+struct fragile {
+    static int copy_budget;
+    int v;
+
+    fragile(int x) : v(x) { }
+    fragile(const fragile& x) : v(x.v)
+    {
+        if (copy_budget-- == 0) throw 0;
+    }
+    bool operator<(const fragile& x) const { return v < x.v; }
+};
+int fragile::copy_budget = -1;
+
+int main(void)
+{
+    btree_set<int> iset;
+    for (int i = 0; i < 1000; ++i) {
+        iset.insert(i * 2);
+    }
+    std::cout << "size=" << iset.size() << std::endl;           // size=1000
+
+    btree_set<int>::iterator ite1 = iset.lower_bound(501);
+    std::cout << *ite1 << std::endl;                            // 502
+
+    pair<btree_set<int>::iterator, btree_set<int>::iterator> p = iset.equal_range(600);
+    std::cout << *p.first << ' ' << *p.second << std::endl;     // 600 602
+
+    // 以 end() 为提示附加于尾端, 不必从根查找
+    iset.insert(iset.end(), 5000);
+    iset.erase(iset.lower_bound(10), iset.lower_bound(1990));
+    for (ite1 = iset.begin(); ite1 != iset.end(); ++ite1) {
+        std::cout << *ite1 << ' ';                              // 0 2 4 6 8 1990 1992 1994 1996 1998 5000
+    }
+    std::cout << std::endl;
+
+    btree_map<std::string, int> simap;
+    simap[std::string("jjhou")] = 1;
+    simap[std::string("jerry")] = 2;
+    simap[std::string("jason")] = 3;
+    simap.insert(pair<const std::string, int>(std::string("david"), 5));
+
+    btree_map<std::string, int>::iterator simap_iter = simap.begin();
+    for (; simap_iter != simap.end(); ++simap_iter) {
+        std::cout << simap_iter->first << ' '
+                  << simap_iter->second << std::endl;           // david 5
+                                                                // jason 3
+                                                                // jerry 2
+                                                                // jjhou 1
+    }
+    std::cout << simap.count(std::string("jerry")) << std::endl;    // 1
+
+    // 复制或删除时元素的复制抛出异常: 不泄漏, 不破坏原树
+    btree_set<fragile> fset;
+    for (int i = 0; i < 1000; ++i) {
+        fset.insert(fragile(i));
+    }
+    int thrown = 0;
+    fragile::copy_budget = 500;
+    try {
+        btree_set<fragile> copy(fset);
+    } catch (int) {
+        ++thrown;
+    }
+    // 位于内部节点的元素, 删除时要先复制其前驱
+    btree_set<fragile>::iterator inner = fset.begin();
+    while (inner.node->leaf) ++inner;
+    fragile::copy_budget = 0;
+    try {
+        fset.erase(inner);
+    } catch (int) {
+        ++thrown;
+    }
+    fragile::copy_budget = -1;
+    int intact = fset.size() == 1000;
+    int k = 0;
+    for (btree_set<fragile>::iterator it = fset.begin(); it != fset.end(); ++it, ++k) {
+        intact = intact && it->v == k;
+    }
+    std::cout << thrown << ' ' << intact << std::endl;          // 2 1
+    return 0;
+}
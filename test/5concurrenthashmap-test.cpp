@@ -0,0 +1,52 @@
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "../src/stl_concurrent_hash_map.h"
+
+struct increment {
+    void operator()(int& x) const { ++x; }
+};
+
+struct append_star {
+    void operator()(std::string& s) const { s += '*'; }
+};
+
+int main(void)
+{
+    concurrent_hash_map<int, std::string> chm;
+    chm.insert(pair<const int, std::string>(1, std::string("jjhou")));
+    chm.insert(pair<const int, std::string>(2, std::string("jason")));
+    std::cout << chm.insert(pair<const int, std::string>(2, std::string("jerry")))
+              << ' ' << chm.size() << std::endl;            // 0 2
+
+    std::string name;
+    chm.find_and_modify(2, append_star());
+    if (chm.find(2, name)) {
+        std::cout << name << std::endl;                     // jason*
+    }
+    chm.erase(1);
+    std::cout << chm.count(1) << ' ' << chm.count(2) << std::endl;  // 0 1
+
+    // 多个写者同时计数, 另有一个读者. 表格在过程中不断扩大
+    concurrent_hash_map<int, int> counter;
+    std::thread writers[4];
+    for (int t = 0; t < 4; ++t) {
+        writers[t] = std::thread([&counter]() {
+            for (int i = 0; i < 20000; ++i) counter.insert_or_update(i % 5000, 1, increment());
+        });
+    }
+    std::thread reader([&counter]() {
+        int v;
+        for (int i = 0; i < 20000; ++i) counter.find(i % 5000, v);
+    });
+    for (int t = 0; t < 4; ++t) writers[t].join();
+    reader.join();
+
+    int v = 0;
+    counter.find(42, v);
+    std::cout << counter.size() << ' ' << v << std::endl;   // 5000 16
+    std::cout << (counter.resize_count() > 0) << std::endl; // 1
+
+    return 0;
+}
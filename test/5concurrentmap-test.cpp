@@ -0,0 +1,86 @@
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "../src/stl_concurrent_map.h"
+
+// 复制到第 copy_budget 次时抛出异常
+int copy_budget = -1;
+struct fragile {
+    int v;
+    explicit fragile(int n) : v(n) { }
+    fragile(const fragile& x) : v(x.v)
+    {
+        if (copy_budget >= 0 && copy_budget-- == 0) throw 0;
+    }
+};
+
+int main(void)
+{
+    concurrent_map<int, std::string> cm;
+    cm.insert(pair<const int, std::string>(3, std::string("jerry")));
+    cm.insert(pair<const int, std::string>(1, std::string("jjhou")));
+    cm.insert(pair<const int, std::string>(2, std::string("jason")));
+    std::cout << cm.size() << std::endl;                    // 3
+
+    // snapshot 是一个固定的版本, 之后的修改都看不到
+    concurrent_map<int, std::string>::snapshot_type s = cm.snapshot();
+    cm.insert_or_assign(2, std::string("david"));
+    cm.erase(3);
+
+    concurrent_map<int, std::string>::const_iterator ite = s.begin();
+    for (; ite != s.end(); ++ite) {
+        std::cout << ite->first << ' ' << ite->second << std::endl;     // 1 jjhou
+                                                                        // 2 jason
+                                                                        // 3 jerry
+    }
+
+    std::string name;
+    if (cm.find(2, name)) {
+        std::cout << name << std::endl;                     // david
+    }
+    std::cout << cm.count(3) << ' ' << s.count(3) << std::endl;  // 0 1
+
+    // 一个写者, 多个读者. 读者不加锁
+    concurrent_map<int, int> icm;
+    std::thread writer([&icm]() {
+        for (int i = 0; i < 10000; ++i) icm.insert_or_assign(i % 100, i);
+    });
+    std::thread reader([&icm]() {
+        int v;
+        for (int i = 0; i < 10000; ++i) icm.find(i % 100, v);
+    });
+    writer.join();
+    reader.join();
+    std::cout << icm.size() << std::endl;                   // 100
+
+    // 复制节点时抛出异常: 写操作整个放弃, 旧版本原封不动, 节点也不会被提早回收
+    concurrent_map<int, fragile> fcm;
+    for (int i = 0; i < 300; ++i) {
+        fcm.insert(pair<const int, fragile>(i, fragile(i)));
+    }
+    int failed = 0;
+    for (int i = 0; i < 300; ++i) {
+        copy_budget = i % 7;
+        __STL_TRY {
+            if (i % 2 == 0) {
+                fcm.erase(i);
+            } else {
+                fcm.insert_or_assign(i, fragile(-i));
+            }
+        }
+        __STL_CATCH_ALL { ++failed; }
+        copy_budget = -1;
+        fcm.reclaim();
+    }
+    int intact = 0;
+    concurrent_map<int, fragile>::snapshot_type fs = fcm.snapshot();
+    concurrent_map<int, fragile>::const_iterator fit = fs.begin();
+    for (int k = 0; fit != fs.end(); ++fit, ++k) {
+        while (k % 2 == 0 && k < 300 && fit->first != k) ++k;  // 已删除的偶数
+        intact += fit->first == k && (fit->second.v == k || fit->second.v == -k);
+    }
+    std::cout << (failed > 0) << ' ' << (intact == (int) fs.size()) << std::endl;   // 1 1
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <iostream>
+#include <cstring>
+
+#include "../src/stl_flat_hash_map.h"
+#include "../src/stl_flat_hash_set.h"
+
+struct eqstr {
+    bool operator() (const char* s1, const char* s2) const
+    {
+        return std::strcmp(s1, s2) == 0;
+    }
+};
+
+int main(void)
+{
+    flat_hash_map<const char*, int, hash<const char*>, eqstr> days;
+
+    days["january"] = 31;
+    days["february"] = 28;
+    days["march"] = 31;
+    days["april"] = 30;
+
+    std::cout << "february  -> " << days["february"] << std::endl;  // 28
+    std::cout << days.size() << ' ' << days.bucket_count() << std::endl;   // 4 16
+
+    days.erase("march");
+    std::cout << days.count("march") << ' ' << days.count("april") << std::endl;    // 0 1
+
+    // reserve() 以元素个数计: 容量为 2 的幂次, 最大负载 7/8
+    flat_hash_set<int> iset;
+    iset.reserve(100);
+    std::cout << iset.bucket_count() << std::endl;              // 128
+    for (int i = 0; i < 100; ++i) iset.insert(i * 128);
+    std::cout << iset.size() << ' ' << iset.bucket_count() << std::endl;    // 100 128
+    std::cout << (iset.find(256) != iset.end()) << ' '
+              << (iset.find(257) != iset.end()) << std::endl;  // 1 0
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <string>
+
+#include "../src/stl_flat_map.h"
+#include "../src/stl_flat_set.h"
+
+using namespace cstl;
+
+int main(void)
+{
+    flat_map<std::string, int> simap;
+    simap[std::string("jjhou")] = 1;
+    simap[std::string("jerry")] = 2;
+    simap[std::string("jason")] = 3;
+
+    // 大批插入: 一次排序, 一次合并. 键值重复时保留原有元素
+    pair<std::string, int> batch[3] = {
+        pair<std::string, int>(std::string("jimmy"), 4),
+        pair<std::string, int>(std::string("david"), 5),
+        pair<std::string, int>(std::string("jjhou"), 9),
+    };
+    simap.insert(batch, batch + 3);
+
+    flat_map<std::string, int>::iterator simap_iter = simap.begin();
+    for (; simap_iter != simap.end(); ++simap_iter) {
+        std::cout << simap_iter->first << ' '
+                  << simap_iter->second << std::endl;   // david 5
+                                                        // jason 3
+                                                        // jerry 2
+                                                        // jimmy 4
+                                                        // jjhou 1
+    }
+
+    // 直接接收已排序的 vector, 不复制元素
+    vector<int> v;
+    for (int i = 0; i < 5; ++i) {
+        v.push_back(i * 10);
+    }
+    flat_set<int> iset;
+    iset.adopt_sorted(v);
+    std::cout << "size=" << iset.size() << " v.size=" << v.size() << std::endl;    // size=5 v.size=0
+    std::cout << *iset.lower_bound(15) << std::endl;                                // 20
+    std::cout << iset.count(30) << std::endl;                                       // 1
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cstring>
+#include <string>
 
 #include "../src/stl_hash_map.h"
 
@@ -39,6 +40,28 @@ int main(void)
     }
     // september june july may january february december march
     // april november october august
+    std::cout << std::endl;
+
+    // 透明的杂凑函数与相等比较: 以 const char* 查找 std::string 键值, 不构造临时的 std::string
+    hash_map<std::string, int, string_hash, equal_to<void> > months;
+    months.insert(pair<const std::string, int>(std::string("march"), 3));
+    months.insert(pair<const std::string, int>(std::string("july"), 7));
+    std::cout << months.find("july")->second << ' '
+              << months.count("june") << std::endl;             // 7 0
+
+    // 批次插入与查找: 结果依键值的顺序写出, 找不到的为 end()
+    hash_map<int, int> squares;
+    pair<const int, int> sq[] = { pair<const int, int>(1, 1), pair<const int, int>(2, 4),
+                                  pair<const int, int>(3, 9), pair<const int, int>(4, 16) };
+    squares.insert_batch(sq, sq + 4);
+    int keys[] = { 3, 5, 1 };
+    hash_map<int, int>::iterator found[3];
+    squares.find_batch(keys, keys + 3, found);
+    for (int i = 0; i < 3; ++i) {
+        if (found[i] != squares.end()) std::cout << found[i]->second << ' ';
+        else std::cout << "- ";
+    }
+    std::cout << std::endl;                                     // 9 - 1
 
     return 0;
 }
\ No newline at end of file
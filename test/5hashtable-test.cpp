@@ -1,12 +1,38 @@
 // file: 5hashtable-test.cpp
 
 #include <iostream>
+#include <string>
 
 #include "../src/stl_hashtable.h"
 #include "../src/stl_hash_fun.h"
 #include "../src/stl_function.h"
 #include "../src/stl_alloc.h"
 
+// 记录 hash function 与相等比较被调用的次数
+struct counting_hash {
+    static int calls;
+    size_t operator()(const std::string& s) const
+    {
+        ++calls;
+        size_t h = 2166136261u;     // FNV-1a: 本例的键值彼此之间杂凑值不会相同
+        for (size_t i = 0; i < s.size(); ++i) {
+            h = (h ^ (unsigned char)s[i]) * 16777619u;
+        }
+        return h;
+    }
+};
+int counting_hash::calls = 0;
+
+struct counting_equal {
+    static int calls;
+    bool operator()(const std::string& x, const std::string& y) const
+    {
+        ++calls;
+        return x == y;
+    }
+};
+int counting_equal::calls = 0;
+
 int main(void)
 {
     // note: hash-table has no default ctor
@@ -15,7 +41,7 @@ int main(void)
     
     std::cout << iht.size() << std::endl;               // 0
     std::cout << iht.bucket_count() << std::endl;       // 53
-    std::cout << iht.max_bucket_count() << std::endl;   // 429496729
+    std::cout << iht.max_bucket_count() << std::endl;   // 13835058055282163729 (32 bits: 4294967291)
 
     iht.insert_unique(59);
     iht.insert_unique(63);
@@ -77,5 +103,122 @@ int main(void)
     std::cout << *(iht.find(2)) << std::endl;   // 2
     std::cout << iht.count(2) << std::endl;     // 2
 
+    // 渐进式 rehash: 扩大表格时只换上新的 buckets, 节点由之后的每次操作搬移一个 bucket
+    hashtable<int, int, hash<int>, identity<int>, equal_to<int>, alloc>
+        inc(50, hash<int>(), equal_to<int>());
+    inc.set_incremental_rehash(1);
+    for (int i = 0; i < 54; ++i) {
+        inc.insert_unique(i);
+    }
+    std::cout << inc.rehashing() << ' ' << inc.bucket_count() << std::endl;    // 1 97
+    // 搬移期间两个表格都能查到, 迭代器也走访两个表格
+    int sum = 0;
+    for (ite = inc.begin(); ite != inc.end(); ++ite) {
+        sum += *ite;
+    }
+    std::cout << inc.count(0) << inc.count(52) << ' ' << sum << std::endl;     // 11 1431
+    // 查找从不搬移: 边走访边查找, 每个元素恰好走访一次
+    int visited = 0;
+    for (ite = inc.begin(); ite != inc.end(); ++ite) {
+        visited += inc.find(*ite) != inc.end();
+        inc.find((*ite + 27) % 54);
+    }
+    std::cout << visited << ' ' << inc.rehashing() << std::endl;              // 54 1
+    // 修改容器的操作才搬移: 旧表格的 53 个 bucket 由 53 次 erase 搬完
+    for (int i = 0; i < 53; ++i) {
+        inc.erase(i);
+    }
+    std::cout << inc.rehashing() << ' ' << inc.size() << ' '
+              << *inc.begin() << std::endl;                                   // 0 1 53
+
+    // 迭代器记下的 bucket 只是提示: 它所在的旧 bucket 被搬走, 甚至搬移结束之后,
+    // 仍能以之删除元素
+    for (int i = 0; i < 100; ++i) {
+        inc.insert_unique(i);                       // 超过 97 个元素, 又开始搬移
+    }
+    hashtable<int, int, hash<int>, identity<int>, equal_to<int>, alloc>::iterator held1, held2;
+    for (held1 = inc.begin(); held1.bucket < inc.bucket_count(); ++held1)
+        ;                                           // 找出两个位于旧表格中的元素
+    held2 = held1;
+    ++held2;
+    const int k1 = *held1, k2 = *held2;
+    for (int i = 0; i < 30; ++i) {
+        inc.find(k1);
+        inc.erase(-1);                              // 不存在的键值, 但也搬移一个 bucket
+    }
+    inc.erase(held1);
+    std::cout << inc.rehashing() << ' ' << inc.count(k1) << ' ' << inc.size() << std::endl;  // 1 0 99
+    for (int i = 0; i < 200; ++i) {
+        inc.erase(-1);
+    }
+    inc.erase(held2);
+    std::cout << inc.rehashing() << ' ' << inc.count(k2) << ' ' << inc.size() << std::endl;  // 0 0 98
+
+    // 最大负载为 2 时, bucket 个数只需元素个数的一半
+    hashtable<int, int, hash<int>, identity<int>, equal_to<int>, alloc>
+        lf(0, hash<int>(), equal_to<int>());
+    lf.max_load_factor(2.0f);
+    lf.reserve(1000);
+    for (int i = 0; i < 1000; ++i) {
+        lf.insert_unique(i);
+    }
+    std::cout << lf.size() << ' ' << lf.bucket_count() << std::endl;          // 1000 769
+    // 低水位: 删除使负载低于 0.25 时, 自动缩小到负载约为最大负载的一半
+    lf.min_load_factor(0.25f);
+    for (int i = 0; i < 900; ++i) {
+        lf.erase(i);
+    }
+    std::cout << lf.size() << ' ' << lf.bucket_count() << std::endl;          // 100 193
+    // rehash() 可以缩小到恰好足以容纳现有元素
+    lf.rehash(0);
+    std::cout << lf.bucket_count() << ' ' << lf.count(950) << std::endl;      // 53 1
+    std::cout << lf.stats().grow_count << ' ' << lf.stats().shrink_count << std::endl;  // 1 2
+
+    // stats(): 恒等的 hash<int> 遇上 53 的倍数, 全部落在同一个 bucket
+    hashtable<int, int, hash<int>, identity<int>, equal_to<int>, alloc>
+        bad(50, hash<int>(), equal_to<int>());
+    for (int i = 0; i < 40; ++i) {
+        bad.insert_unique(i * 53);
+    }
+    hashtable<int, int, hash<int>, identity<int>, equal_to<int>, alloc>::stats_type
+        st = bad.stats();
+    std::cout << st.bucket_count << ' ' << st.empty_buckets << ' '
+              << st.longest_chain << ' ' << st.histogram[7] << std::endl; // 53 52 40 1
+    for (int i = 0; i < 40; ++i) {
+        bad.erase(i * 53);
+        bad.insert_unique(i);
+    }
+    st = bad.stats();
+    std::cout << st.empty_buckets << ' ' << st.longest_chain << ' '
+              << st.histogram[1] << std::endl;                            // 13 1 40
+
+    // std::string 键值的节点保存杂凑值: 表格重建, 走访, 以迭代器删除都不再调用 hash function,
+    // 查找时杂凑值不同的节点直接略过, 不必比较键值
+    typedef hashtable<std::string, std::string, counting_hash, identity<std::string>,
+                      counting_equal, alloc> string_table;
+    string_table sht(10, counting_hash(), counting_equal());
+    const char* digits = "0123456789";
+    for (int i = 0; i < 100; ++i) {
+        sht.insert_unique(std::string("key") + digits[i / 10] + digits[i % 10]);
+    }
+    std::cout << sht.size() << ' ' << counting_hash::calls << std::endl;      // 100 100
+    counting_hash::calls = 0;
+    sht.rehash(1000);
+    size_t n = 0;
+    for (string_table::iterator it = sht.begin(); it != sht.end(); ++it) {
+        ++n;
+    }
+    sht.erase(sht.begin());
+    std::cout << n << ' ' << sht.bucket_count() << ' ' << counting_hash::calls
+              << std::endl;                                               // 100 1543 0
+    sht.rehash(0);      // 缩小到每个 bucket 平均一个元素, 串行变长
+    counting_equal::calls = 0;
+    int found = 0;
+    for (int i = 0; i < 100; ++i) {
+        found += sht.count(std::string("key") + digits[i / 10] + digits[i % 10]);
+        found += sht.count(std::string("nokey") + digits[i / 10] + digits[i % 10]);
+    }
+    std::cout << found << ' ' << counting_equal::calls << std::endl;          // 99 99
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <string>
+
+#include "../src/stl_persistent_map.h"
+#include "../src/stl_persistent_set.h"
+
+// 复制到第 copy_budget 次时抛出异常
+int copy_budget = -1;
+struct fragile {
+    int v;
+    explicit fragile(int n) : v(n) { }
+    fragile(const fragile& x) : v(x.v)
+    {
+        if (copy_budget >= 0 && copy_budget-- == 0) throw 0;
+    }
+};
+
+// 逐一比对: m 的内容是否恰为 [0, n) 中除去 skip 的整数, 自 first 起每隔 step 个取一个
+template <class Map>
+bool same_keys(const Map& m, int n, int skip, int first = 0, int step = 1)
+{
+    typename Map::const_iterator it = m.begin();
+    for (int i = first; i < n; i += step) {
+        if (i == skip) continue;
+        if (it == m.end() || it->first != i || it->second.v != i) return false;
+        ++it;
+    }
+    return it == m.end();
+}
+
+int main(void)
+{
+    persistent_map<std::string, int> v1;
+    v1.insert(pair<const std::string, int>(std::string("jjhou"), 1));
+    v1.insert(pair<const std::string, int>(std::string("jerry"), 2));
+    v1.insert(pair<const std::string, int>(std::string("jason"), 3));
+
+    // 复制为 O(1), 之后 v1 与 v2 各自修改, 互不影响
+    persistent_map<std::string, int> v2 = v1;
+    std::cout << v2.same_version(v1) << std::endl;              // 1
+    v2.insert_or_assign(std::string("jerry"), 20);
+    v2.erase(std::string("jason"));
+    std::cout << v2.same_version(v1) << std::endl;              // 0
+
+    persistent_map<std::string, int>::const_iterator ite = v1.begin();
+    for (; ite != v1.end(); ++ite) {
+        std::cout << ite->first << ' ' << ite->second << std::endl;     // jason 3
+                                                                        // jerry 2
+                                                                        // jjhou 1
+    }
+    for (ite = v2.begin(); ite != v2.end(); ++ite) {
+        std::cout << ite->first << ' ' << ite->second << std::endl;     // jerry 20
+                                                                        // jjhou 1
+    }
+
+    persistent_set<int> s1;
+    for (int i = 0; i < 10; ++i) s1.insert(i);
+    persistent_set<int> s2 = s1;
+    s2.erase(s2.lower_bound(3), s2.lower_bound(8));
+    std::cout << s1.size() << ' ' << s2.size() << std::endl;   // 10 5
+
+    persistent_set<int>::iterator ite2 = s2.end();
+    while (ite2 != s2.begin()) {
+        std::cout << *--ite2 << ' ';                            // 9 8 2 1 0
+    }
+    std::cout << std::endl;
+
+    // 复制共享节点时抛出异常: 两个版本都不受影响, 引用计数也仍然正确
+    persistent_map<int, fragile> f1;
+    for (int i = 0; i < 200; ++i) {
+        f1.insert(pair<const int, fragile>(i, fragile(i)));
+    }
+    int failed = 0;
+    for (int i = 0; i < 200; ++i) {
+        persistent_map<int, fragile> f2 = f1;
+        copy_budget = i % 9;
+        bool erased = false;
+        __STL_TRY {
+            if (i % 2 == 0) {
+                erased = f2.erase(i) == 1;
+            } else {
+                f2.insert_or_assign(i, fragile(i));
+            }
+        }
+        __STL_CATCH_ALL { ++failed; }
+        copy_budget = -1;
+        if (!same_keys(f2, 200, erased ? i : -1)) std::cout << "bad copy " << i << std::endl;
+    }
+    persistent_map<int, fragile> f3 = f1;
+    for (int i = 0; i < 200; i += 2) {
+        copy_budget = 3;
+        __STL_TRY { f3.erase(i); }
+        __STL_CATCH_ALL { }
+        copy_budget = -1;
+        f3.erase(i);                                            // 重试必定成功
+    }
+    std::cout << (failed > 0) << ' ' << same_keys(f1, 200, -1) << ' '
+              << same_keys(f3, 200, -1, 1, 2) << ' ' << f3.size() << std::endl;   // 1 1 1 100
+
+    return 0;
+}
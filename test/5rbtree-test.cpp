@@ -4,6 +4,48 @@
 #include "../src/stl_function.h"
 #include "../src/stl_tree.h"
 
+// 检查以 x 为根的子树是否满足红黑性质(且 parent 指针正确), 返回其黑高度; 违反时返回 -1
+int black_height(const __rb_tree_node_base* x, const __rb_tree_node_base* p)
+{
+    if (x == 0) return 1;
+    if (x->get_parent() != p) return -1;
+    if (x->get_color() == __rb_tree_red
+        && ((x->left && x->left->get_color() == __rb_tree_red)
+            || (x->right && x->right->get_color() == __rb_tree_red))) {
+        return -1;      // 红节点的子节点必为黑
+    }
+    int hl = black_height(x->left, x);
+    int hr = black_height(x->right, x);
+    if (hl < 0 || hl != hr) return -1;
+    return hl + (x->get_color() == __rb_tree_black ? 1 : 0);
+}
+
+template <class Tree>
+bool is_valid(const Tree& t)
+{
+    const __rb_tree_node_base* header = t.end().node;
+    const __rb_tree_node_base* root = header->get_parent();
+    if (root != 0 && root->get_color() != __rb_tree_black) return false;
+    if (black_height(root, header) < 0) return false;
+    size_t n = 0;
+    for (typename Tree::const_iterator i = t.begin(); i != t.end(); ++i, ++n) {
+        typename Tree::const_iterator j = i;
+        if (++j != t.end() && t.key_comp()(*j, *i)) return false;  // 中序必须有序
+    }
+    return n == t.size();
+}
+
+// 比较若干次之后抛出异常, 用于检查集合运算的异常处理
+int compare_budget = -1;
+struct throwing_less {
+    bool operator()(int a, int b) const
+    {
+        if (compare_budget == 0) throw compare_budget;
+        if (compare_budget > 0) --compare_budget;
+        return a < b;
+    }
+};
+
 int main(void)
 {
     rb_tree<int, int, identity<int>, std::less<int> > itree;
@@ -37,10 +79,74 @@ int main(void)
 
     for (; ite1 != ite2; ++ite1) {
         rbtite = __rb_tree_base_iterator(ite1);
-        std::cout << *ite1 << '(' << rbtite.node->color << ") ";
+        std::cout << *ite1 << '(' << rbtite.node->get_color() << ") ";
     }
     std::cout << std::endl;
     // 5(0) 6(1) 7(0) 8(1) 10(1) 11(0) 12(0) 13(1) 15(0)
 
+    // 空树由有序区间建树: O(n) 直接建出平衡且着好色的树, 不做任何旋转
+    int ia[100];
+    for (int i = 0; i < 100; ++i) {
+        ia[i] = i * 2;
+    }
+    rb_tree<int, int, identity<int>, std::less<int> > stree;
+    stree.insert_unique(ia, ia + 100);
+    std::cout << stree.size() << ' ' << is_valid(stree) << ' ' << *stree.begin()
+              << ' ' << *stree.rbegin() << std::endl;   // 100 1 0 198
+    // 之后的插入与删除照常进行
+    for (int i = 1; i < 100; i += 2) {
+        stree.insert_unique(i);
+    }
+    for (int i = 0; i < 100; i += 3) {
+        stree.erase(i);
+    }
+    std::cout << stree.size() << ' ' << is_valid(stree) << ' '
+              << stree.count(3) << stree.count(4) << stree.count(150) << std::endl;  // 116 1 011
+    // 允许重复的有序输入同样走 O(n) 建树; 前缀之后的无序部分逐一插入
+    int ib[10] = {1, 1, 2, 3, 3, 3, 5, 8, 4, 0};
+    rb_tree<int, int, identity<int>, std::less<int> > mtree;
+    mtree.insert_equal(ib, ib + 10);
+    std::cout << mtree.size() << ' ' << is_valid(mtree) << ' ' << mtree.count(3)
+              << ' ' << *mtree.begin() << std::endl;    // 10 1 3 0
+
+    // join: t1 < v < t2, 接合后 t1 和 t2 被清空
+    rb_tree<int, int, identity<int>, std::less<int> > t1, t2, jtree;
+    for (int i = 0; i < 40; ++i) {
+        t1.insert_unique(i);
+    }
+    for (int i = 41; i < 45; ++i) {
+        t2.insert_unique(i);
+    }
+    jtree.join(t1, 40, t2);
+    std::cout << jtree.size() << ' ' << t1.size() << t2.size() << ' '
+              << is_valid(jtree) << ' ' << *jtree.rbegin() << std::endl;  // 45 00 1 44
+    // split: 键值不小于 30 的移到 t2
+    jtree.split(30, t2);
+    std::cout << jtree.size() << ' ' << t2.size() << ' ' << is_valid(jtree)
+              << is_valid(t2) << ' ' << *jtree.rbegin() << ' ' << *t2.begin()
+              << std::endl;                             // 30 15 11 29 30
+    // 区间超过 32 个元素时, 以两次分割和一次接合删除, 不逐一再平衡
+    jtree.insert_unique(ia, ia + 100);
+    std::cout << jtree.size() << ' ';                   // 115
+    jtree.erase(jtree.lower_bound(10), jtree.lower_bound(150));
+    std::cout << jtree.size() << ' ' << is_valid(jtree) << ' '
+              << *jtree.lower_bound(10) << std::endl;   // 35 1 150
+
+    // 比较函数在集合运算中途抛出异常: 树仍然完整可用, 不会遗失节点
+    rb_tree<int, int, identity<int>, throwing_less> u1, u2;
+    for (int i = 0; i < 50; ++i) {
+        u1.insert_unique(i * 2);
+        u2.insert_unique(i * 3);
+    }
+    compare_budget = 100;
+    try {
+        u1.merge_union(u2);
+    } catch (int) {
+        std::cout << "throw ";                          // throw
+    }
+    compare_budget = -1;
+    std::cout << is_valid(u1) << ' ' << (u1.size() >= 50) << ' '
+              << u1.count(98) << std::endl;             // 1 1 1
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+// 顺序统计需要每个节点记录子树大小, 必须在包含任何头文件之前定义
+#define __STL_RB_TREE_SUBTREE_SIZE
+
+#include <iostream>
+
+#include "../src/stl_set.h"
+
+// 逐一比对: 第 k 个元素就是 select(k), 它的 rank 与 distance 都是 k
+bool check(const set<int>& s)
+{
+    set<int>::size_type k = 0;
+    for (set<int>::iterator it = s.begin(); it != s.end(); ++it, ++k) {
+        if (s.select(k) != it || s.rank(*it) != k
+            || s.distance(s.begin(), it) != (set<int>::difference_type) k) {
+            return false;
+        }
+    }
+    return k == s.size() && s.select(k) == s.end();
+}
+
+int main(void)
+{
+    set<int> iset;
+    for (int i = 0; i < 101; ++i) {
+        iset.insert(i * 37 % 101);      // 0~100, 乱序插入
+    }
+    std::cout << *iset.select(10) << ' ' << iset.rank(50) << ' '
+              << check(iset) << std::endl;                  // 10 50 1
+
+    // 删除所有 3 的倍数, 再平衡之后子树大小仍然正确
+    for (int i = 0; i <= 100; i += 3) {
+        iset.erase(i);
+    }
+    std::cout << iset.size() << ' ' << *iset.select(10) << ' '
+              << iset.rank(50) << ' ' << check(iset) << std::endl;   // 67 16 33 1
+    // rank() 的参数不必在集合中
+    std::cout << iset.rank(51) << ' ' << iset.rank(1000) << std::endl;  // 34 67
+
+    // 递增插入, 每次都要旋转
+    for (int i = 200; i < 300; ++i) {
+        iset.insert(i);
+    }
+    set<int>::iterator it = iset.find(250);
+    std::cout << iset.distance(iset.begin(), it) << ' ' << *iset.advance(it, -50)
+              << ' ' << check(iset) << std::endl;           // 117 200 1
+
+    // 区间删除: 超过 32 个元素时走分割/接合的路径
+    iset.erase(iset.find(10), iset.find(280));
+    std::cout << iset.size() << ' ' << *iset.select(7) << ' '
+              << check(iset) << std::endl;                  // 26 281 1
+
+    return 0;
+}
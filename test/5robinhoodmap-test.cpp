@@ -0,0 +1,49 @@
+#include <iostream>
+#include <cstring>
+
+#include "../src/stl_robin_hood_map.h"
+#include "../src/stl_robin_hood_set.h"
+
+struct eqstr {
+    bool operator() (const char* s1, const char* s2) const
+    {
+        return std::strcmp(s1, s2) == 0;
+    }
+};
+
+int main(void)
+{
+    robin_hood_map<const char*, int, hash<const char*>, eqstr> days;
+
+    days["january"] = 31;
+    days["february"] = 28;
+    days["march"] = 31;
+    days["april"] = 30;
+
+    std::cout << "february  -> " << days["february"] << std::endl;  // 28
+    std::cout << days.size() << ' ' << days.bucket_count() << std::endl;   // 4 16
+
+    days.erase("march");
+    std::cout << days.count("march") << ' ' << days.count("april") << std::endl;    // 0 1
+
+    // reserve() 以元素个数计: 容量为 2 的幂次, 最大负载 9/10
+    robin_hood_set<int> iset;
+    iset.reserve(900);
+    std::cout << iset.bucket_count() << std::endl;              // 1024
+    for (int i = 0; i < 900; ++i) iset.insert(i * 7);
+    std::cout << iset.size() << ' ' << iset.bucket_count() << std::endl;    // 900 1024
+    std::cout << (iset.find(14) != iset.end()) << ' '
+              << (iset.find(15) != iset.end()) << std::endl;  // 1 0
+    // 负载将近 9/10, 探测距离仍然很短
+    std::cout << (iset.max_probe_length() < 32) << std::endl;  // 1
+
+    // erase(it) 返回原处的迭代器, 后面的元素可能已经挪了过来
+    robin_hood_set<int>::iterator it = iset.begin();
+    while (it != iset.end()) {
+        if (*it % 2 == 0) it = iset.erase(it);
+        else ++it;
+    }
+    std::cout << iset.size() << ' ' << iset.count(7) << ' ' << iset.count(14) << std::endl;  // 450 1 0
+
+    return 0;
+}
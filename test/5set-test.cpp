@@ -50,5 +50,31 @@ int main(void)
     // 企图通过迭代器来改变 set 元素, 是不被允许的
     // *ite1 = 9;       // error, assignment of read-only location
 
+    // 就地集合运算
+    int ib[4] = {1, 3, 6, 8};
+    set<int> iset2(ib, ib + 4);
+    iset.merge_union(iset2);
+    for (ite1 = iset.begin(); ite1 != iset.end(); ++ite1)
+        std::cout << *ite1;
+    std::cout << std::endl;                                 // 0 1 2 3 4 5 6 8
+    iset.subtract(iset2);
+    for (ite1 = iset.begin(); ite1 != iset.end(); ++ite1)
+        std::cout << *ite1;
+    std::cout << std::endl;                                 // 0 2 4 5
+    iset.intersect_with(set<int>(ia, ia + 5));
+    for (ite1 = iset.begin(); ite1 != iset.end(); ++ite1)
+        std::cout << *ite1;
+    std::cout << std::endl;                                 // 0 2 4
+
+    // 节点把手: 修改键值或在容器之间搬移元素, 都不配置节点
+    set<int>::node_type nh = iset.extract(4);
+    nh.key() = 7;
+    iset.insert(nh);                                        // 0 2 7
+    iset2.merge(iset);
+    std::cout << iset.size() << ' ' << iset2.size() << std::endl;   // 0 7
+    for (ite1 = iset2.begin(); ite1 != iset2.end(); ++ite1)
+        std::cout << *ite1;
+    std::cout << std::endl;                                 // 0 1 2 3 6 7 8
+
     return 0;
 }
\ No newline at end of file
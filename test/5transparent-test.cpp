@@ -0,0 +1,84 @@
+#include <iostream>
+#include <string>
+
+#include "../src/stl_set.h"
+#include "../src/stl_map.h"
+
+// 能由 const char* 隐式转换而来的键值, 记录转换(即构造临时对象)的次数
+struct label {
+    static int conversions;
+    std::string s;
+
+    label(const char* p) : s(p) { ++conversions; }
+};
+int label::conversions = 0;
+
+// 透明的比较: 可以直接拿 const char* 与 label 比较
+struct label_less {
+    typedef void is_transparent;
+    bool operator()(const label& x, const label& y) const { return x.s < y.s; }
+    bool operator()(const label& x, const char* y) const { return x.s.compare(y) < 0; }
+    bool operator()(const char* x, const label& y) const { return y.s.compare(x) > 0; }
+};
+
+// 不透明的比较: 只接受 label
+struct plain_less {
+    bool operator()(const label& x, const label& y) const { return x.s < y.s; }
+};
+
+int main(void)
+{
+    const char* names[5] = {"jason", "jerry", "jimmy", "jjhou", "kevin"};
+
+    set<label, label_less> tset;
+    for (int i = 0; i < 5; ++i) {
+        tset.insert(label(names[i]));
+    }
+    label::conversions = 0;
+    std::cout << tset.find("jimmy")->s << ' ' << (tset.find("jack") == tset.end())
+              << ' ' << tset.count("jjhou") << ' ' << tset.count("john") << std::endl;
+    // jimmy 1 1 0
+    std::cout << tset.lower_bound("jj")->s << ' ' << tset.upper_bound("jjhou")->s
+              << std::endl;                                     // jjhou kevin
+    pair<set<label, label_less>::iterator, set<label, label_less>::iterator> r =
+        tset.equal_range("jerry");
+    std::cout << r.first->s << ' ' << r.second->s << std::endl;  // jerry jimmy
+    std::cout << "conversions=" << label::conversions << std::endl;  // conversions=0
+
+    // Compare 没有 is_transparent: 仍然走 key_type 的版本, 每次查找都要先转换
+    set<label, plain_less> pset;
+    for (int i = 0; i < 5; ++i) {
+        pset.insert(label(names[i]));
+    }
+    label::conversions = 0;
+    std::cout << pset.find("jimmy")->s << ' ' << pset.count("john") << ' '
+              << pset.lower_bound("jj")->s << ' ' << pset.upper_bound("jjhou")->s << ' '
+              << pset.equal_range("jerry").first->s << std::endl;  // jimmy 0 jjhou kevin jerry
+    std::cout << "conversions=" << label::conversions << std::endl;  // conversions=5
+
+    // 以 less<void> 为 Compare, 用 const char* 查找 std::string 键值
+    map<std::string, int, less<void> > simap;
+    for (int i = 0; i < 5; ++i) {
+        simap[std::string(names[i])] = i;
+    }
+    const map<std::string, int, less<void> >& csimap = simap;
+    std::cout << simap.find("jjhou")->second << ' ' << csimap.find("jerry")->second << ' '
+              << simap.count("jimmy") << ' ' << simap.count("jack") << std::endl;   // 3 1 1 0
+    std::cout << simap.lower_bound("jk")->first << ' '
+              << csimap.upper_bound("jason")->first << ' '
+              << (simap.upper_bound("kevin") == simap.end()) << std::endl;   // kevin jerry 1
+    pair<map<std::string, int, less<void> >::iterator,
+         map<std::string, int, less<void> >::iterator> mr = simap.equal_range("jimmy");
+    mr.first->second = 20;
+    std::cout << mr.first->first << ' ' << mr.second->first << ' '
+              << simap[std::string("jimmy")] << std::endl;      // jimmy jjhou 20
+
+    // map 的不透明版本同样只接受 key_type
+    map<label, int, plain_less> lmap;
+    lmap.insert(pair<const label, int>(label("jjhou"), 1));
+    label::conversions = 0;
+    std::cout << lmap.find("jjhou")->second << ' ' << lmap.count("jerry") << ' '
+              << "conversions=" << label::conversions << std::endl;   // 1 0 conversions=2
+
+    return 0;
+}